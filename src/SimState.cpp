@@ -14,6 +14,7 @@
 #include <constants.hpp>
 #include <io/read_rb_scene.hpp>
 #include <io/serialize_json.hpp>
+#include <io/trajectory.hpp>
 #include <io/write_gltf.hpp>
 #include <io/write_obj.hpp>
 #include <physics/rigid_body_problem.hpp>
@@ -34,7 +35,13 @@ SimState::SimState()
     , m_num_simulation_steps(0)
     , m_max_simulation_steps(-1)
     , m_checkpoint_frequency(100)
+    , m_save_single_precision(false)
     , m_dirty_constraints(false)
+    , m_frame_timestep(0.01)
+    , m_substep_timestep(0.01)
+    , m_sim_time(0)
+    , m_substep_time0(0)
+    , m_frame_num_iterations(0)
 {
     initial_rss = getCurrentRSS();
 }
@@ -46,6 +53,47 @@ void to_lower(std::string& s)
     });
 }
 
+// Saved simulations are written with the args on the first line, one state
+// per line, and the stats on the last line, so they can be streamed both ways.
+static const std::string RESULTS_HEADER_START = R"({"args":)";
+static const std::string RESULTS_HEADER_END =
+    R"(,"animation":{"state_sequence":)";
+static const std::string RESULTS_FOOTER_START = R"(},"stats":)";
+
+std::string results_header(const nlohmann::json& args)
+{
+    return RESULTS_HEADER_START + args.dump() + RESULTS_HEADER_END;
+}
+
+std::string results_footer(const nlohmann::json& stats)
+{
+    return RESULTS_FOOTER_START + stats.dump() + "}";
+}
+
+/// @brief Read the args from the first line of a saved simulation.
+/// @returns true if the input is a saved simulation, otherwise false and the
+///          input is rewound.
+bool read_results_header(std::istream& input, nlohmann::json& args)
+{
+    std::string start(RESULTS_HEADER_START.size(), '\0');
+    if (input.read(&start[0], start.size()) && start == RESULTS_HEADER_START) {
+        std::string line;
+        std::getline(input, line);
+        const std::string end = RESULTS_HEADER_END + "[";
+        if (line.size() >= end.size()
+            && line.compare(line.size() - end.size(), end.size(), end) == 0) {
+            args = nlohmann::json::parse(
+                line.substr(0, line.size() - end.size()), nullptr, false);
+            if (!args.is_discarded()) {
+                return true;
+            }
+        }
+    }
+    input.clear();
+    input.seekg(0);
+    return false;
+}
+
 bool SimState::load_scene(const std::string& filename, const std::string& patch)
 {
     PROFILER_CLEAR();
@@ -60,9 +108,22 @@ bool SimState::load_scene(const std::string& filename, const std::string& patch)
         // scene = ...
         spdlog::error("MuJoCo file format not supported yet", ext);
         return false;
+    } else if (ext == ".traj") {
+        scene_file = filename;
+        return load_trajectory(filename);
     } else if (ext == ".json") {
-        std::ifstream input(filename);
-        if (input.good()) {
+        std::ifstream input(filename, std::ios::binary);
+        nlohmann::json saved_args;
+        if (input.good() && read_results_header(input, saved_args)) {
+            // Read the saved states one at a time
+            scene_file = filename;
+            if (patch.size()) {
+                nlohmann::json saved = { { "args", saved_args } };
+                saved.merge_patch(nlohmann::json::parse(patch));
+                saved_args = saved["args"];
+            }
+            return load_simulation(saved_args, input);
+        } else if (input.good()) {
             scene = nlohmann::json::parse(input, nullptr, false);
             if (patch.size()) {
                 scene.merge_patch(nlohmann::json::parse(patch));
@@ -93,6 +154,55 @@ bool SimState::load_scene(const std::string& filename, const std::string& patch)
 
 bool SimState::reload_scene() { return load_scene(scene_file); }
 
+bool SimState::load_simulation(
+    const nlohmann::json& saved_args, std::istream& input)
+{
+    // load original setup
+    bool success = init(saved_args);
+    if (!success) {
+        return false;
+    }
+
+    // now reload simulation history one state at a time
+    state_sequence.clear();
+    const std::string footer_start = "]" + RESULTS_FOOTER_START;
+    bool is_complete = false;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.compare(0, footer_start.size(), footer_start) == 0) {
+            nlohmann::json stats = nlohmann::json::parse(
+                line.substr(
+                    footer_start.size(), line.size() - footer_start.size() - 1),
+                nullptr, false);
+            if (!stats.is_discarded()) {
+                load_stats(stats);
+                is_complete = true;
+            }
+            break;
+        }
+        // Every state but the first starts with a comma
+        nlohmann::json state = nlohmann::json::parse(
+            line.begin() + (!line.empty() && line[0] == ','), line.end(),
+            nullptr, false);
+        if (state.is_discarded()) {
+            break; // e.g., a state cut off by a crash
+        }
+        state_sequence.push_back(state);
+    }
+    if (state_sequence.empty()) {
+        spdlog::error("No saved states in {}", scene_file);
+        return false;
+    }
+    if (!is_complete) {
+        spdlog::warn(
+            "Simulation {} was not saved completely (e.g., the run crashed); "
+            "resuming from its last complete state",
+            scene_file);
+    }
+    resume_from_history();
+    return true;
+}
+
 bool SimState::load_simulation(const nlohmann::json& input_args)
 {
     // load original setup
@@ -102,19 +212,82 @@ bool SimState::load_simulation(const nlohmann::json& input_args)
     }
 
     // now reload simulation history
-    state_sequence = input_args["animation"]["state_sequence"]
-                         .get<std::vector<nlohmann::json>>();
+    state_sequence.clear();
+    for (const auto& state : input_args["animation"]["state_sequence"]) {
+        state_sequence.push_back(state);
+    }
     if (input_args.find("stats") != input_args.end()) {
-        const auto& stats = input_args["stats"];
-        step_timings = stats["step_timings"].get<std::vector<double>>();
-        solver_iterations = stats["solver_iterations"].get<std::vector<int>>();
-        num_contacts = stats["num_contacts"].get<std::vector<int>>();
-        step_minimum_distances =
-            stats["step_minimum_distances"].get<std::vector<double>>();
+        load_stats(input_args["stats"]);
+    }
+    resume_from_history();
+    return true;
+}
+
+bool SimState::load_trajectory(const std::string& filename)
+{
+    TrajectoryReader reader;
+    if (!reader.open(filename)) {
+        return false;
+    }
+    // Only a closed trajectory stores the velocities of its last step
+    if (!reader.is_complete()) {
+        spdlog::error(
+            "Trajectory {} was not closed (e.g., the run crashed), so the "
+            "simulation cannot be resumed from it",
+            filename);
+        return false;
+    }
+
+    // load original setup
+    const nlohmann::json& metadata = reader.metadata();
+    bool success = init(metadata["args"]);
+    if (!success) {
+        return false;
+    }
+    if (reader.dim() != problem_ptr->dim()
+        || reader.num_bodies() != problem_ptr->num_bodies()) {
+        spdlog::error(
+            "Trajectory {} does not match its scene (dim={:d} "
+            "num_bodies={:d})",
+            filename, reader.dim(), reader.num_bodies());
+        return false;
+    }
+
+    // now reload simulation history
+    state_sequence.clear();
+    for (size_t i = 0; i < reader.num_steps(); i++) {
+        state_sequence.push_back(reader.read_state(i));
+    }
+    if (state_sequence.empty()) {
+        state_sequence.push_back(problem_ptr->state());
     }
+    if (metadata.contains("stats")) {
+        load_stats(metadata["stats"]);
+    }
+    resume_from_history();
+    return true;
+}
+
+void SimState::load_stats(const nlohmann::json& stats)
+{
+    step_timings = stats["step_timings"].get<std::vector<double>>();
+    solver_iterations = stats["solver_iterations"].get<std::vector<int>>();
+    num_contacts = stats["num_contacts"].get<std::vector<int>>();
+    step_minimum_distances =
+        stats["step_minimum_distances"].get<std::vector<double>>();
+}
+
+void SimState::resume_from_history()
+{
     m_num_simulation_steps = int(state_sequence.size()) - 1;
     problem_ptr->state(state_sequence.back());
-    return true;
+    // Resume the adaptive time-steps from the last frame
+    m_sim_time = m_substep_time0 = m_num_simulation_steps * m_frame_timestep;
+    m_substep_state0 = m_frame_state = state_sequence.back();
+    m_substep_num_contacts = num_contacts.empty() ? 0 : num_contacts.back();
+    m_substep_min_distance = step_minimum_distances.empty()
+        ? -1
+        : step_minimum_distances.back();
 }
 
 bool SimState::init(const nlohmann::json& args_in)
@@ -135,7 +308,8 @@ bool SimState::init(const nlohmann::json& args_in)
             "gravity": [0.0, 0.0, 0.0],
             "collision_eps": 0.0,
             "time_stepper": "default",
-            "do_intersection_check": false
+            "do_intersection_check": false,
+            "solve_contact_islands": false
         },
         "homotopy_solver": {
             "inner_solver": "DEPRECATED",
@@ -152,6 +326,9 @@ bool SimState::init(const nlohmann::json& args_in)
             "velocity_conv_tol": null,
             "is_velocity_conv_tol_abs": false,
             "line_search_lower_bound": null,
+            "decompose_linear_solve": false,
+            "matrix_free": false,
+            "max_pcg_iterations": 1000,
             "linear_solver": {
                 "name": "Eigen::SimplicialLDLT",
                 "max_iter": 1000,
@@ -162,7 +339,12 @@ bool SimState::init(const nlohmann::json& args_in)
         },
         "ipc_solver": {
             "dhat_epsilon": 1e-9,
-            "min_barrier_stiffness_scale": null
+            "min_barrier_stiffness_scale": null,
+            "warm_start": false
+        },
+        "lbfgs_ipc_solver": {
+            "history_size": 10,
+            "initial_hessian_refresh": 10
         },
         "ncp_solver": {
             "max_iterations": 1000,
@@ -183,6 +365,20 @@ bool SimState::init(const nlohmann::json& args_in)
             "static_friction_speed_bound": 1e-3,
             "iterations": 1
         },
+        "adaptive_timestep": {
+            "enabled": false,
+            "min_timestep": null,
+            "max_timestep": null,
+            "newton_iteration_budget": 50,
+            "min_ccd_step_size": 0.1,
+            "shrink_factor": 0.5,
+            "growth_factor": 1.25
+        },
+        "body_sleeping": {
+            "steps": 0,
+            "linear_velocity_threshold": 1e-2,
+            "angular_velocity_threshold": 3e-2
+        },
         "volume_constraint": {
             "detection_method": "hash_grid",
             "trajectory_type": "piecewise_linear",
@@ -209,6 +405,10 @@ bool SimState::init(const nlohmann::json& args_in)
     json newton_settings = args["newton_solver"];    // make a copy of newton
     newton_settings.merge_patch(args["ipc_solver"]); // apply ipc to newton
     args["ipc_solver"] = newton_settings; // set ipc to updated newton
+    // Share the IPC solver settings with L-BFGS IPC
+    json ipc_settings = args["ipc_solver"];
+    ipc_settings.merge_patch(args["lbfgs_ipc_solver"]);
+    args["lbfgs_ipc_solver"] = ipc_settings;
 
     // check that incomming json doesn't have any unkown keys to avoid stupid
     // bugs
@@ -232,6 +432,10 @@ bool SimState::init(const nlohmann::json& args_in)
     newton_settings = args["newton_solver"];         // make a copy of newton
     newton_settings.merge_patch(args["ipc_solver"]); // apply ipc to newton
     args["ipc_solver"] = newton_settings; // set ipc to updated newton
+    // Share the IPC solver settings with L-BFGS IPC
+    ipc_settings = args["ipc_solver"];
+    ipc_settings.merge_patch(args["lbfgs_ipc_solver"]);
+    args["lbfgs_ipc_solver"] = ipc_settings;
 
     auto problem_name = args["scene_type"].get<std::string>();
     auto tmp_problem_ptr = ProblemFactory::factory().get_problem(problem_name);
@@ -254,11 +458,27 @@ bool SimState::init(const nlohmann::json& args_in)
         m_max_simulation_steps = int(ceil(max_time / problem_ptr->timestep()));
     }
 
+    // Frames are always saved every timestep, but the problem can take
+    // smaller or larger steps in between.
+    m_frame_timestep = problem_ptr->timestep();
+    success = m_timestep_controller.settings(
+        args["adaptive_timestep"], m_frame_timestep);
+    if (!success) {
+        return false;
+    }
+    m_substep_timestep = std::clamp(
+        m_frame_timestep, m_timestep_controller.min_timestep,
+        m_timestep_controller.max_timestep);
+    m_sim_time = m_substep_time0 = 0;
+
     m_num_simulation_steps = 0;
     m_dirty_constraints = true;
 
     state_sequence.clear();
     state_sequence.push_back(problem_ptr->state());
+    m_substep_state0 = m_frame_state = state_sequence.back();
+    m_substep_num_contacts = 0;
+    m_substep_min_distance = -1;
     step_timings.clear();
     solver_iterations.clear();
     num_contacts.clear();
@@ -270,7 +490,10 @@ bool SimState::init(const nlohmann::json& args_in)
 nlohmann::json SimState::get_active_config()
 {
     nlohmann::json active_args;
-    active_args["timestep"] = problem_ptr->timestep();
+    active_args["timestep"] = m_frame_timestep;
+    if (m_timestep_controller.enabled) {
+        active_args["adaptive_timestep"] = m_timestep_controller.settings();
+    }
     active_args["scene_type"] = problem_ptr->name();
 
     active_args[problem_ptr->name()] = problem_ptr->settings();
@@ -322,6 +545,11 @@ void SimState::run_simulation(const std::string& fout)
     std::string chkpt_base =
         (fout_path.parent_path() / fout_path.stem()).string();
 
+    if (fout_path.extension() != ".traj") {
+        // Append the states to the results file as the steps complete
+        state_sequence.stream_to(fout, results_header(args));
+    }
+
     if (m_max_simulation_steps <= 0) {
         m_max_simulation_steps = 1000;
     }
@@ -343,8 +571,13 @@ void SimState::run_simulation(const std::string& fout)
         // Checkpoint the simulation every m_checkpoint_frequency time-steps
         if ((i + 1) % m_checkpoint_frequency == 0
             && (i + 1) < m_max_simulation_steps) {
-            std::string chkpt_fout = fmt::format(
-                "{}-chkpt{:05d}.json", chkpt_base, m_num_simulation_steps);
+            // A streamed results file is completed in place
+            std::string chkpt_fout = fout;
+            if (fout != state_sequence.filename()) {
+                chkpt_fout = fmt::format(
+                    "{}-chkpt{:05d}{}", chkpt_base, m_num_simulation_steps,
+                    fout_path.extension().string());
+            }
             save_simulation(chkpt_fout);
             spdlog::info("Simulation checkpoint saved to {}", chkpt_fout);
         }
@@ -376,8 +609,12 @@ void SimState::simulation_step()
     m_step_has_intersections = false;
 
     step_timer.start();
-    problem_ptr->simulation_step(
-        m_step_had_collision, m_step_has_intersections, m_solve_collisions);
+    if (m_timestep_controller.enabled) {
+        adaptive_simulation_step();
+    } else {
+        problem_ptr->simulation_step(
+            m_step_had_collision, m_step_has_intersections, m_solve_collisions);
+    }
     step_timer.stop();
 
     if (m_step_had_collision) {
@@ -403,16 +640,93 @@ void SimState::simulation_step()
     //                          : "collisions_solved");
 }
 
+void SimState::adaptive_simulation_step()
+{
+    PROFILE_POINT("SimState::adaptive_simulation_step");
+    PROFILE_START();
+
+    const double frame_time = m_num_simulation_steps * m_frame_timestep;
+    // Avoid an extra tiny substep because of round-off in the accumulated time
+    const double time_tol = 1e-9 * m_frame_timestep;
+
+    m_step_had_collision = false;
+    m_frame_num_iterations = 0;
+    // The substep that contains the previous frame also spans the start of
+    // this frame interval.
+    m_frame_num_contacts = m_substep_num_contacts;
+    m_frame_min_distance = m_substep_min_distance;
+    int num_substeps = 0;
+    while (m_sim_time < frame_time - time_tol) {
+        m_substep_state0 = problem_ptr->state();
+        m_substep_time0 = m_sim_time;
+
+        bool had_collision, has_intersections;
+        problem_ptr->timestep(m_substep_timestep);
+        problem_ptr->simulation_step(
+            had_collision, has_intersections, m_solve_collisions);
+        m_sim_time += m_substep_timestep;
+        num_substeps++;
+
+        m_step_had_collision |= had_collision;
+        m_step_has_intersections |= has_intersections;
+        const OptimizationResults& result = problem_ptr->opt_result;
+        m_frame_num_iterations += result.num_iterations;
+
+        m_substep_num_contacts = problem_ptr->num_contacts();
+        m_substep_min_distance = problem_ptr->compute_min_distance();
+        m_frame_num_contacts =
+            std::max(m_frame_num_contacts, m_substep_num_contacts);
+        // Negative distances mean no distance is below d̂
+        if (m_frame_min_distance < 0
+            || (m_substep_min_distance >= 0
+                && m_substep_min_distance < m_frame_min_distance)) {
+            m_frame_min_distance = m_substep_min_distance;
+        }
+
+        m_substep_timestep = m_timestep_controller.next_timestep(
+            m_substep_timestep, result.num_iterations,
+            result.min_ccd_step_size);
+        spdlog::debug(
+            "sim_state action=adaptive_substep sim_it={} time={:g} "
+            "newton_iterations={} min_ccd_step_size={:g} next_timestep={:g}",
+            m_num_simulation_steps, m_sim_time, result.num_iterations,
+            result.min_ccd_step_size, m_substep_timestep);
+    }
+
+    // The frame lies in the last substep (possibly taken for an earlier frame)
+    const double substep = m_sim_time - m_substep_time0;
+    const double t = substep > 0
+        ? std::clamp((frame_time - m_substep_time0) / substep, 0.0, 1.0)
+        : 1.0;
+    m_frame_state = problem_ptr->interpolate_state(
+        m_substep_state0, problem_ptr->state(), t);
+
+    spdlog::info(
+        "sim_state action=adaptive_timestep sim_it={} num_substeps={} "
+        "next_timestep={:g}",
+        m_num_simulation_steps, num_substeps, m_substep_timestep);
+
+    PROFILE_END();
+}
+
 void SimState::save_simulation_step()
 {
     PROFILE_POINT("SimState::save_simulation_step");
     PROFILE_START();
 
-    state_sequence.push_back(problem_ptr->state());
+    if (m_timestep_controller.enabled) {
+        // The frame is interpolated, so report the substeps around it
+        state_sequence.push_back(m_frame_state);
+        solver_iterations.push_back(m_frame_num_iterations);
+        num_contacts.push_back(m_frame_num_contacts);
+        step_minimum_distances.push_back(m_frame_min_distance);
+    } else {
+        state_sequence.push_back(problem_ptr->state());
+        solver_iterations.push_back(problem_ptr->opt_result.num_iterations);
+        num_contacts.push_back(problem_ptr->num_contacts());
+        step_minimum_distances.push_back(problem_ptr->compute_min_distance());
+    }
     step_timings.push_back(step_timer.getElapsedTime());
-    solver_iterations.push_back(problem_ptr->opt_result.num_iterations);
-    num_contacts.push_back(problem_ptr->num_contacts());
-    step_minimum_distances.push_back(problem_ptr->compute_min_distance());
 
     PROFILE_END();
 }
@@ -422,11 +736,6 @@ bool SimState::save_simulation(const std::string& filename)
     PROFILE_POINT("SimState::save_simulation");
     PROFILE_START();
 
-    nlohmann::json results;
-    results["args"] = args;
-    results["animation"] = nlohmann::json();
-    results["animation"]["state_sequence"] = state_sequence;
-
     nlohmann::json stats;
     stats["dim"] = problem_ptr->dim();
     stats["num_bodies"] = problem_ptr->num_bodies();
@@ -440,20 +749,57 @@ bool SimState::save_simulation(const std::string& filename)
     stats["num_contacts"] = num_contacts;
     stats["step_minimum_distances"] = step_minimum_distances;
     stats["solve_stats"] = problem_ptr->solver().stats();
-    results["stats"] = stats;
 
-    std::ofstream file(filename);
+    if (fs::path(filename).extension() == ".traj") {
+        bool success = save_trajectory(filename, stats);
+        PROFILE_END();
+        return success;
+    }
+
+    if (filename == state_sequence.filename()) {
+        // The states are already in the file, so only add the stats
+        bool success = state_sequence.finish(results_footer(stats));
+        PROFILE_END();
+        return success;
+    }
+
+    std::ofstream file(filename, std::ios::binary);
     if (!file) {
         PROFILE_END();
         return false;
     }
 
-    file << results.dump();
+    // Copy the serialized states from the history instead of building one
+    // large JSON
+    file << results_header(args);
+    state_sequence.write_json_array(file);
+    file << results_footer(stats);
 
     PROFILE_END();
     return true;
 }
 
+bool SimState::save_trajectory(
+    const std::string& filename, const nlohmann::json& stats)
+{
+    nlohmann::json metadata;
+    metadata["args"] = args;
+    metadata["stats"] = stats;
+
+    TrajectoryWriter writer;
+    if (!writer.open(
+            filename, problem_ptr->dim(), problem_ptr->num_bodies(),
+            m_frame_timestep, metadata, m_save_single_precision)) {
+        return false;
+    }
+    for (size_t i = 0; i < state_sequence.size(); i++) {
+        if (!writer.write_step(state_sequence[i])) {
+            return false;
+        }
+    }
+    return writer.close();
+}
+
 bool SimState::save_obj_sequence(const std::string& dir_name)
 {
     // Create the output directory if it does not exist
@@ -495,7 +841,7 @@ bool SimState::save_gltf(const std::string& filename)
         std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
 
     return write_gltf(
-        filename, rbp->m_assembler, poses, problem_ptr->timestep());
+        filename, rbp->m_assembler, poses, m_frame_timestep);
 }
 
 } // namespace ipc::rigid
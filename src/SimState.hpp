@@ -3,10 +3,13 @@
 #include <igl/Timer.h>
 #include <nlohmann/json.hpp>
 
+#include <istream>
 #include <memory> // shared_ptr
 
+#include <io/state_history.hpp>
 #include <physics/simulation_problem.hpp>
 #include <solvers/optimization_solver.hpp>
+#include <time_stepper/timestep_controller.hpp>
 
 namespace ipc::rigid {
 
@@ -16,7 +19,12 @@ public:
 
     bool load_scene(const std::string& filename, const std::string& patch = "");
     bool reload_scene();
-    bool load_simulation(const nlohmann::json& args);
+    /// @brief Resume a simulation saved by save_simulation().
+    /// @param args  Arguments of the saved simulation.
+    /// @param input Rest of the saved file, read one state at a time.
+    bool load_simulation(const nlohmann::json& args, std::istream& input);
+    /// @brief Resume a simulation saved as a single JSON object.
+    bool load_simulation(const nlohmann::json& results);
     bool init(const nlohmann::json& args);
 
     void simulation_step();
@@ -43,11 +51,14 @@ public:
     int m_max_simulation_steps; ///< maximum number of time-steps to take
     int m_checkpoint_frequency; ///< time-steps between checkpoints
 
+    /// @brief Save .traj trajectories with float32 instead of float64 values
+    bool m_save_single_precision;
+
     std::string scene_file;
 
     nlohmann::json args;
 
-    std::vector<nlohmann::json> state_sequence;
+    StateHistory state_sequence; ///< saved states streamed to disk
     std::vector<double> step_timings;
     std::vector<int> solver_iterations;
     std::vector<int> num_contacts;
@@ -58,6 +69,43 @@ protected:
     size_t initial_rss;
 
     bool m_dirty_constraints;
+
+    /// @brief Load a binary trajectory saved by save_simulation().
+    bool load_trajectory(const std::string& filename);
+    /// @brief Save the states to a binary trajectory file.
+    bool save_trajectory(
+        const std::string& filename, const nlohmann::json& stats);
+    /// @brief Load the per-step statistics of a saved simulation.
+    void load_stats(const nlohmann::json& stats);
+    /// @brief Continue the simulation from the last state of the history.
+    void resume_from_history();
+
+    /// @brief Advance the problem to the next frame with adaptive time-steps.
+    ///
+    /// The saved frame is interpolated (lerp of positions, slerp of
+    /// rotations) between the states around the frame time. CCD only checks
+    /// the substep trajectories, so the interpolated frames are not
+    /// guaranteed to be intersection-free.
+    void adaptive_simulation_step();
+
+    TimestepController m_timestep_controller;
+    double m_frame_timestep;         ///< time between saved frames
+    double m_substep_timestep;       ///< size of the next adaptive time-step
+    double m_sim_time;               ///< time at the end of the last substep
+    double m_substep_time0;          ///< time at the start of the last substep
+    nlohmann::json m_substep_state0; ///< state at the start of the last substep
+    nlohmann::json m_frame_state;    ///< state interpolated at the last frame
+    int m_frame_num_iterations;      ///< Newton iterations of the last frame
+    /// @brief Contacts at the end of the last substep.
+    int m_substep_num_contacts;
+    /// @brief Minimum distance at the end of the last substep.
+    double m_substep_min_distance;
+    /// @brief Largest number of contacts of the substeps spanning the last
+    /// frame interval.
+    int m_frame_num_contacts;
+    /// @brief Smallest minimum distance of the substeps spanning the last
+    /// frame interval (negative if no distance is below d̂).
+    double m_frame_min_distance;
 };
 
 } // namespace ipc::rigid
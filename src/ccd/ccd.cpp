@@ -356,6 +356,54 @@ bool face_vertex_ccd(
     }
 }
 
+double edge_vertex_toi_lower_bound(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const EdgeVertexCandidate& candidate,
+    double minimum_separation_distance)
+{
+    long bodyA_id, vertex_id, bodyB_id, edge_id;
+    bodies.global_to_local_vertex(candidate.vertex_index, bodyA_id, vertex_id);
+    bodies.global_to_local_edge(candidate.edge_index, bodyB_id, edge_id);
+    return compute_edge_vertex_time_of_impact_lower_bound(
+        bodies[bodyA_id], poses_t0[bodyA_id], poses_t1[bodyA_id], vertex_id,
+        bodies[bodyB_id], poses_t0[bodyB_id], poses_t1[bodyB_id], edge_id,
+        minimum_separation_distance);
+}
+
+double edge_edge_toi_lower_bound(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const EdgeEdgeCandidate& candidate,
+    double minimum_separation_distance)
+{
+    long bodyA_id, edgeA_id, bodyB_id, edgeB_id;
+    bodies.global_to_local_edge(candidate.edge0_index, bodyA_id, edgeA_id);
+    bodies.global_to_local_edge(candidate.edge1_index, bodyB_id, edgeB_id);
+    return compute_edge_edge_time_of_impact_lower_bound(
+        bodies[bodyA_id], poses_t0[bodyA_id], poses_t1[bodyA_id], edgeA_id,
+        bodies[bodyB_id], poses_t0[bodyB_id], poses_t1[bodyB_id], edgeB_id,
+        minimum_separation_distance);
+}
+
+double face_vertex_toi_lower_bound(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const FaceVertexCandidate& candidate,
+    double minimum_separation_distance)
+{
+    long bodyA_id, vertex_id, bodyB_id, face_id;
+    bodies.global_to_local_vertex(candidate.vertex_index, bodyA_id, vertex_id);
+    bodies.global_to_local_face(candidate.face_index, bodyB_id, face_id);
+    return compute_face_vertex_time_of_impact_lower_bound(
+        bodies[bodyA_id], poses_t0[bodyA_id], poses_t1[bodyA_id], vertex_id,
+        bodies[bodyB_id], poses_t0[bodyB_id], poses_t1[bodyB_id], face_id,
+        minimum_separation_distance);
+}
+
 double edge_vertex_closest_point(
     const RigidBodyAssembler& bodies,
     const PosesD& poses_t0,
@@ -6,24 +6,12 @@
 
 #include <ipc/broad_phase/collision_candidate.hpp>
 
+#include <ccd/detection_method.hpp>
 #include <ccd/impact.hpp>
 #include <physics/rigid_body_assembler.hpp>
 
 namespace ipc::rigid {
 
-/// @brief Possible methods for detecting all edge vertex collisions.
-enum DetectionMethod {
-    BRUTE_FORCE, ///< @brief Use brute-force to detect all collisions
-    HASH_GRID, ///< @brief Use a spatial data structure to detect all collisions
-    BVH,       ///< @brief Use a BVH to detect all collisions
-};
-
-NLOHMANN_JSON_SERIALIZE_ENUM(
-    DetectionMethod,
-    { { HASH_GRID, "hash_grid" },
-      { BRUTE_FORCE, "brute_force" },
-      { BVH, "bvh" } });
-
 /// @brief Possible trajectories of vertices in a rigid body.
 enum TrajectoryType {
     /// @brief Linearization of the rotation component of rigid body
@@ -125,6 +113,33 @@ bool face_vertex_ccd(
     double earliest_toi = 1,
     double minimum_separation_distance = 0);
 
+/// @brief Conservative lower bound on the time-of-impact of a candidate.
+///
+/// Only depends on the initial distance of the candidate and the maximum
+/// displacement of each body (see compute_time_of_impact_lower_bound()), so
+/// it is much cheaper than the CCD. Valid for the rigid and piecewise-linear
+/// trajectories.
+double edge_vertex_toi_lower_bound(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const EdgeVertexCandidate& ev_candidate,
+    double minimum_separation_distance = 0);
+
+double edge_edge_toi_lower_bound(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const EdgeEdgeCandidate& ee_candidate,
+    double minimum_separation_distance = 0);
+
+double face_vertex_toi_lower_bound(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const FaceVertexCandidate& fv_candidate,
+    double minimum_separation_distance = 0);
+
 double edge_vertex_closest_point(
     const RigidBodyAssembler& bodies,
     const PosesD& poses_t0,
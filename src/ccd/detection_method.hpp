@@ -0,0 +1,23 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Possible methods for detecting all edge vertex collisions.
+enum DetectionMethod {
+    BRUTE_FORCE, ///< @brief Use brute-force to detect all collisions
+    HASH_GRID, ///< @brief Use a spatial data structure to detect all collisions
+    BVH,       ///< @brief Use a BVH to detect all collisions
+    /// @brief Use a sweep-and-prune that keeps the boxes sorted across calls
+    SWEEP_AND_PRUNE,
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(
+    DetectionMethod,
+    { { HASH_GRID, "hash_grid" },
+      { BRUTE_FORCE, "brute_force" },
+      { BVH, "bvh" },
+      { SWEEP_AND_PRUNE, "sweep_and_prune" } });
+
+} // namespace ipc::rigid
@@ -44,6 +44,7 @@ void detect_collision_candidates_linear(
         break;
     }
     case BVH:
+    case SWEEP_AND_PRUNE: // Linear trajectories are not swept
         detect_collision_candidates_linear_bvh(
             bodies, poses_t0, poses_t1, collision_types, candidates,
             inflation_radius);
@@ -255,19 +256,23 @@ void detect_collision_candidates_linear_bvh(
     std::vector<std::pair<int, int>> body_pairs =
         bodies.close_bodies(poses_t0, poses_t1, inflation_radius);
 
+    // Rotations at t0 and local vertex AABBs shared by all pairs of a body
+    const BodyPairCache<double> cache_t0(
+        bodies, poses_t0, body_pairs, inflation_radius);
+
     typedef tbb::enumerable_thread_specific<Candidates> LocalStorage;
     LocalStorage storages;
     tbb::parallel_for(
         tbb::blocked_range<size_t>(size_t(0), body_pairs.size()),
         [&](const tbb::blocked_range<size_t>& range) {
             LocalStorage::reference loc_storage_candidates = storages.local();
+            std::vector<AABB> VA_aabbs;
             for (long i = range.begin(); i != range.end(); ++i) {
                 int bodyA_id = body_pairs[i].first;
                 int bodyB_id = body_pairs[i].second;
                 sort_body_pair(bodies, bodyA_id, bodyB_id);
 
                 const auto& bodyA = bodies[bodyA_id];
-                const auto& bodyB = bodies[bodyB_id];
 
                 // PROFILE_POINT("detect_collision_candidates_linear_bvh:compute_vertices");
                 // PROFILE_START();
@@ -277,10 +282,8 @@ void detect_collision_candidates_linear_bvh(
                 const auto& pB_t0 = poses_t0[bodyB_id].position;
                 const auto& pA_t1 = poses_t1[bodyA_id].position;
                 const auto& pB_t1 = poses_t1[bodyB_id].position;
-                const auto RA_t0 =
-                    poses_t0[bodyA_id].construct_rotation_matrix();
-                const auto RB_t0 =
-                    poses_t0[bodyB_id].construct_rotation_matrix();
+                const auto& RA_t0 = cache_t0.rotation(bodyA_id);
+                const auto& RB_t0 = cache_t0.rotation(bodyB_id);
                 const auto RA_t1 =
                     poses_t1[bodyA_id].construct_rotation_matrix();
                 const auto RB_t1 =
@@ -294,7 +297,7 @@ void detect_collision_candidates_linear_bvh(
                      + (pA_t1 - pB_t1).transpose())
                     * RB_t1;
 
-                std::vector<AABB> VA_aabbs;
+                VA_aabbs.clear();
                 VA_aabbs.reserve(bodyA.num_vertices());
                 for (int i = 0; i < bodyA.num_vertices(); i++) {
                     const auto& v_t0 = VA_t0.row(i);
@@ -306,7 +309,8 @@ void detect_collision_candidates_linear_bvh(
                 // PROFILE_END();
 
                 detect_body_pair_collision_candidates_from_aabbs(
-                    bodies, VA_aabbs, bodyA_id, bodyB_id, collision_types,
+                    bodies, VA_aabbs, cache_t0.local_vertex_aabbs(bodyB_id),
+                    bodyA_id, bodyB_id, collision_types,
                     loc_storage_candidates, inflation_radius);
             }
         });
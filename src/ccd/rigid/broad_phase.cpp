@@ -45,6 +45,10 @@ void detect_collision_candidates_rigid(
         detect_collision_candidates_rigid_bvh(
             bodies, poses, collision_types, candidates, inflation_radius);
         break;
+    case SWEEP_AND_PRUNE:
+        detect_collision_candidates_rigid_sap(
+            bodies, poses, collision_types, candidates, inflation_radius);
+        break;
     }
 
     PROFILE_END();
@@ -103,16 +107,22 @@ void detect_collision_candidates_rigid_bvh(
     // Use interval arithmetic to conservativly capture all distance candidates
     auto posesI = cast<Interval>(poses);
 
+    // Rotations and local vertex AABBs shared by all pairs of a body
+    const BodyPairCache<Interval> cache(
+        bodies, posesI, body_pairs, inflation_radius);
+
     ThreadSpecificCandidates storages;
     tbb::parallel_for(
         tbb::blocked_range<size_t>(size_t(0), body_pairs.size()),
         [&](const tbb::blocked_range<size_t>& range) {
             ThreadSpecificCandidates::reference local_storage_candidates =
                 storages.local();
+            std::vector<AABB> bodyA_vertex_aabbs;
             for (long i = range.begin(); i != range.end(); ++i) {
                 detect_body_pair_collision_candidates_bvh(
-                    bodies, posesI, body_pairs[i].first, body_pairs[i].second,
-                    collision_types, local_storage_candidates,
+                    bodies, posesI, cache, body_pairs[i].first,
+                    body_pairs[i].second, collision_types,
+                    local_storage_candidates, bodyA_vertex_aabbs,
                     inflation_radius);
             }
         });
@@ -120,6 +130,19 @@ void detect_collision_candidates_rigid_bvh(
     merge_local_candidates(storages, candidates);
 }
 
+// Use a sweep-and-prune to create a set of all candidate collisions.
+void detect_collision_candidates_rigid_sap(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses,
+    const int collision_types,
+    Candidates& candidates,
+    const double inflation_radius)
+{
+    // A static trajectory
+    detect_collision_candidates_rigid_sap(
+        bodies, poses, poses, collision_types, candidates, inflation_radius);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Broad-Phase Continous Collision Detection
 ///////////////////////////////////////////////////////////////////////////////
@@ -156,6 +179,11 @@ void detect_collision_candidates_rigid(
             bodies, poses_t0, poses_t1, collision_types, candidates,
             inflation_radius);
         break;
+    case SWEEP_AND_PRUNE:
+        detect_collision_candidates_rigid_sap(
+            bodies, poses_t0, poses_t1, collision_types, candidates,
+            inflation_radius);
+        break;
     }
 
     PROFILE_END();
@@ -217,16 +245,22 @@ void detect_collision_candidates_rigid_bvh(
     Poses<Interval> poses = interpolate(
         cast<Interval>(poses_t0), cast<Interval>(poses_t1), Interval(0, 1));
 
+    // Rotations and local vertex AABBs shared by all pairs of a body
+    const BodyPairCache<Interval> cache(
+        bodies, poses, body_pairs, inflation_radius);
+
     ThreadSpecificCandidates storages;
     tbb::parallel_for(
         tbb::blocked_range<size_t>(size_t(0), body_pairs.size()),
         [&](const tbb::blocked_range<size_t>& range) {
             ThreadSpecificCandidates::reference local_storage_candidates =
                 storages.local();
+            std::vector<AABB> bodyA_vertex_aabbs;
             for (long i = range.begin(); i != range.end(); ++i) {
                 detect_body_pair_collision_candidates_bvh(
-                    bodies, poses, body_pairs[i].first, body_pairs[i].second,
-                    collision_types, local_storage_candidates,
+                    bodies, poses, cache, body_pairs[i].first,
+                    body_pairs[i].second, collision_types,
+                    local_storage_candidates, bodyA_vertex_aabbs,
                     inflation_radius);
             }
         });
@@ -234,6 +268,153 @@ void detect_collision_candidates_rigid_bvh(
     merge_local_candidates(storages, candidates);
 }
 
+// Use a sweep-and-prune to create a set of all candidate collisions.
+void detect_collision_candidates_rigid_sap(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const int collision_types,
+    Candidates& candidates,
+    const double inflation_radius)
+{
+    std::vector<std::pair<int, int>> body_pairs = bodies.close_bodies(
+        poses_t0, poses_t1, inflation_radius, SWEEP_AND_PRUNE);
+
+    std::vector<bool> is_body_close(bodies.num_bodies(), false);
+    for (const auto& body_pair : body_pairs) {
+        is_body_close[body_pair.first] = is_body_close[body_pair.second] = true;
+    }
+
+    const bool build_ev = collision_types & CollisionType::EDGE_VERTEX;
+    const bool build_ee = collision_types & CollisionType::EDGE_EDGE;
+    const bool build_fv = collision_types & CollisionType::FACE_VERTEX;
+
+    // All primitives are stored in a single sweep (vertices, then edges, then
+    // faces), so the size of the sweep does not change between calls.
+    const size_t num_vertices = bodies.num_vertices();
+    const size_t num_edges = bodies.num_edges();
+    const size_t num_faces = bodies.num_faces();
+
+    NAMED_PROFILE_POINT("detect_collision_candidates_rigid_sap:boxes", BOXES);
+    PROFILE_START(BOXES);
+
+    // Boxes with min > max are inactive and skipped by the sweep
+    SweepAndPrune::Box empty_box;
+    empty_box[0].setConstant(std::numeric_limits<double>::infinity());
+    empty_box[1].setConstant(-std::numeric_limits<double>::infinity());
+    std::vector<SweepAndPrune::Box> boxes(
+        num_vertices + num_edges + num_faces, empty_box);
+
+    // Use interval arithmetic to conservativly bound the vertex trajectories
+    Poses<Interval> poses = interpolate(
+        cast<Interval>(poses_t0), cast<Interval>(poses_t1), Interval(0, 1));
+
+    tbb::parallel_for(size_t(0), bodies.num_bodies(), [&](size_t i) {
+        if (!is_body_close[i]) {
+            return;
+        }
+        const MatrixXI V = bodies[i].world_vertices(poses[i]);
+        const long v0i = bodies.m_body_vertex_id[i];
+        for (int vi = 0; vi < V.rows(); vi++) {
+            SweepAndPrune::Box& box = boxes[v0i + vi];
+            box[0].setZero();
+            box[1].setZero();
+            for (int j = 0; j < V.cols(); j++) {
+                box[0][j] = V(vi, j).lower() - inflation_radius;
+                box[1][j] = V(vi, j).upper() + inflation_radius;
+            }
+        }
+    });
+
+    auto merge_vertex_boxes = [&](SweepAndPrune::Box& box, long vi) {
+        box[0] = box[0].cwiseMin(boxes[vi][0]);
+        box[1] = box[1].cwiseMax(boxes[vi][1]);
+    };
+    if (build_ev || build_ee) {
+        for (long ei = 0; ei < num_edges; ei++) {
+            SweepAndPrune::Box& box = boxes[num_vertices + ei];
+            for (int j = 0; j < bodies.m_edges.cols(); j++) {
+                merge_vertex_boxes(box, bodies.m_edges(ei, j));
+            }
+        }
+    }
+    if (build_fv) {
+        for (long fi = 0; fi < num_faces; fi++) {
+            SweepAndPrune::Box& box = boxes[num_vertices + num_edges + fi];
+            for (int j = 0; j < bodies.m_faces.cols(); j++) {
+                merge_vertex_boxes(box, bodies.m_faces(fi, j));
+            }
+        }
+    }
+    if (!build_ev && !build_fv) {
+        // Vertices are only needed for edge-vertex and face-vertex candidates
+        std::fill_n(boxes.begin(), num_vertices, empty_box);
+    }
+
+    PROFILE_END(BOXES);
+
+    NAMED_PROFILE_POINT("detect_collision_candidates_rigid_sap:sweep", SWEEP);
+    PROFILE_START(SWEEP);
+
+    bodies.primitive_sap().update(boxes);
+
+    enum PrimitiveType { VERTEX, EDGE, FACE };
+    auto primitive_type = [&](size_t id) {
+        return id < num_vertices
+            ? VERTEX
+            : (id < num_vertices + num_edges ? EDGE : FACE);
+    };
+    auto primitive_group_id = [&](size_t id) {
+        switch (primitive_type(id)) {
+        case VERTEX:
+            return bodies.group_ids()[id];
+        case EDGE:
+            return bodies.group_ids()[bodies.m_edges(id - num_vertices, 0)];
+        default:
+            return bodies.group_ids()[bodies.m_faces(
+                id - num_vertices - num_edges, 0)];
+        }
+    };
+    // Pairs are sorted (i < j), so vertices always come first
+    auto can_collide = [&](size_t i, size_t j) {
+        const PrimitiveType type_i = primitive_type(std::min(i, j));
+        const PrimitiveType type_j = primitive_type(std::max(i, j));
+        bool is_valid_type = (build_ev && type_i == VERTEX && type_j == EDGE)
+            || (build_ee && type_i == EDGE && type_j == EDGE)
+            || (build_fv && type_i == VERTEX && type_j == FACE);
+        return is_valid_type && primitive_group_id(i) != primitive_group_id(j);
+    };
+
+    std::vector<std::pair<int, int>> pairs;
+    bodies.primitive_sap().intersect_self(pairs, can_collide);
+
+    for (const auto& [i, j] : pairs) {
+        switch (primitive_type(j)) {
+        case EDGE:
+            if (primitive_type(i) == VERTEX) {
+                candidates.ev_candidates.emplace_back(j - num_vertices, i);
+            } else {
+                candidates.ee_candidates.emplace_back(
+                    i - num_vertices, j - num_vertices);
+            }
+            break;
+        case FACE:
+            candidates.fv_candidates.emplace_back(
+                j - num_vertices - num_edges, i);
+            break;
+        default:
+            assert(false);
+        }
+    }
+
+    PROFILE_END(SWEEP);
+    PROFILE_MESSAGE(
+        SWEEP, "num_swaps,num_candidates",
+        fmt::format(
+            "{:d},{:d}", bodies.primitive_sap().num_swaps(),
+            candidates.size()));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Broad-Phase Intersection Detection
 ///////////////////////////////////////////////////////////////////////////////
@@ -44,6 +44,14 @@ void detect_collision_candidates_rigid_bvh(
     Candidates& candidates,
     const double inflation_radius = 0.0);
 
+/// @brief Use a sweep-and-prune to create a set of all candidate collisions.
+void detect_collision_candidates_rigid_sap(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses,
+    const int collision_types,
+    Candidates& candidates,
+    const double inflation_radius = 0.0);
+
 ///////////////////////////////////////////////////////////////////////////////
 // Broad-Phase Continous Collision Detection
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,6 +84,19 @@ void detect_collision_candidates_rigid_bvh(
     Candidates& candidates,
     const double inflation_radius = 0.0);
 
+/// @brief Use a sweep-and-prune to create a set of all candidate collisions.
+///
+/// The vertex, edge, and face boxes are kept sorted across calls (see
+/// RigidBodyAssembler::primitive_sap()), so this is near-linear when the
+/// bodies barely move between calls.
+void detect_collision_candidates_rigid_sap(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const int collision_types,
+    Candidates& candidates,
+    const double inflation_radius = 0.0);
+
 ///////////////////////////////////////////////////////////////////////////////
 // Broad-Phase Intersection Detection
 ///////////////////////////////////////////////////////////////////////////////
@@ -1,10 +1,40 @@
 #include "rigid_body_bvh.hpp"
 
+#include <tbb/parallel_for.h>
+
 namespace ipc::rigid {
 
+template <typename T>
+BodyPairCache<T>::BodyPairCache(
+    const RigidBodyAssembler& bodies,
+    const Poses<T>& poses,
+    const std::vector<std::pair<int, int>>& body_pairs,
+    const double inflation_radius)
+    : m_rotations(bodies.num_bodies())
+    , m_local_vertex_aabbs(bodies.num_bodies())
+{
+    std::vector<bool> is_body_in_pair(bodies.num_bodies(), false);
+    for (const auto& body_pair : body_pairs) {
+        is_body_in_pair[body_pair.first] = true;
+        is_body_in_pair[body_pair.second] = true;
+    }
+
+    tbb::parallel_for(size_t(0), bodies.num_bodies(), [&](size_t i) {
+        if (is_body_in_pair[i]) {
+            m_rotations[i] = poses[i].construct_rotation_matrix();
+            m_local_vertex_aabbs[i] =
+                vertex_aabbs(bodies[i].vertices, inflation_radius);
+        }
+    });
+}
+
+template class BodyPairCache<double>;
+template class BodyPairCache<Interval>;
+
 void detect_body_pair_collision_candidates_from_aabbs(
     const RigidBodyAssembler& bodies,
     const std::vector<AABB>& bodyA_vertex_aabbs,
+    const std::vector<AABB>& bodyB_vertex_aabbs,
     const int bodyA_id,
     const int bodyB_id,
     const int collision_types,
@@ -53,8 +83,8 @@ void detect_body_pair_collision_candidates_from_aabbs(
     const RigidBody& bodyA = bodies[bodyA_id];
     const RigidBody& bodyB = bodies[bodyB_id];
 
-    const std::vector<AABB> bodyB_vertex_aabbs =
-        vertex_aabbs(bodyB.vertices, inflation_radius);
+    assert(bodyA_vertex_aabbs.size() == bodyA.num_vertices());
+    assert(bodyB_vertex_aabbs.size() == bodyB.num_vertices());
     const Eigen::MatrixXi &EA = bodyA.edges, &EB = bodyB.edges,
                           &FA = bodyA.faces, &FB = bodyB.faces;
 
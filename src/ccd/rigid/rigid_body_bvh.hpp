@@ -51,46 +51,82 @@ vertex_aabbs(const MatrixX<T>& V, double inflation_radius = 0)
     return aabbs;
 }
 
+/// @brief Per-call cache of the quantities shared by all the body pairs a body
+/// appears in.
+///
+/// Each body's rotation matrix and the AABBs of its vertices in its local
+/// frame are computed once instead of once per body pair.
+template <typename T> class BodyPairCache {
+public:
+    BodyPairCache(
+        const RigidBodyAssembler& bodies,
+        const Poses<T>& poses,
+        const std::vector<std::pair<int, int>>& body_pairs,
+        const double inflation_radius = 0.0);
+
+    /// @brief Rotation matrix of a body in one of the pairs.
+    const MatrixMax3<T>& rotation(int body_id) const
+    {
+        return m_rotations[body_id];
+    }
+
+    /// @brief Inflated AABBs of a body's vertices in its local frame.
+    const std::vector<AABB>& local_vertex_aabbs(int body_id) const
+    {
+        return m_local_vertex_aabbs[body_id];
+    }
+
+protected:
+    std::vector<MatrixMax3<T>> m_rotations;
+    std::vector<std::vector<AABB>> m_local_vertex_aabbs;
+};
+
 void detect_body_pair_collision_candidates_from_aabbs(
     const RigidBodyAssembler& bodies,
     const std::vector<AABB>& bodyA_vertex_aabbs,
+    const std::vector<AABB>& bodyB_vertex_aabbs,
     const int bodyA_id,
     const int bodyB_id,
     const int collision_types,
     Candidates& candidates,
     const double inflation_radius = 0.0);
 
+/// @param[in,out] bodyA_vertex_aabbs Buffer reused between calls to avoid
+///                                   reallocating for every pair.
 template <typename T>
 inline void detect_body_pair_collision_candidates_bvh(
     const RigidBodyAssembler& bodies,
     const Poses<T>& poses,
+    const BodyPairCache<T>& cache,
     int bodyA_id,
     int bodyB_id,
     const int collision_types,
     Candidates& candidates,
+    std::vector<AABB>& bodyA_vertex_aabbs,
     const double inflation_radius = 0.0)
 {
     sort_body_pair(bodies, bodyA_id, bodyB_id);
 
     // Compute the smaller body's vertices in the larger body's local
-    // coordinates.
-    // PROFILE_POINT(fmt::format(
-    //     "detect_body_pair_collision_candidates_bvh<{}>:compute_vertices",
-    //     get_type_name<T>()));
-    // PROFILE_START();
-    const auto RA = poses[bodyA_id].construct_rotation_matrix();
-    const auto RB = poses[bodyB_id].construct_rotation_matrix();
-    const auto& pA = poses[bodyA_id].position;
-    const auto& pB = poses[bodyB_id].position;
-    const MatrixX<T> VA =
-        ((bodies[bodyA_id].vertices * RA.transpose()).rowwise()
-         + (pA - pB).transpose())
-        * RB;
-    // PROFILE_END();
+    // coordinates using the relative transform of the pair:
+    // Rᵀ_B(R_A v + p_A - p_B) = (Rᵀ_B R_A) v + Rᵀ_B (p_A - p_B)
+    const MatrixMax3<T> RB_T = cache.rotation(bodyB_id).transpose();
+    const MatrixMax3<T> R = RB_T * cache.rotation(bodyA_id);
+    const VectorMax3<T> p =
+        RB_T * (poses[bodyA_id].position - poses[bodyB_id].position);
+
+    const Eigen::MatrixXd& VA = bodies[bodyA_id].vertices;
+    bodyA_vertex_aabbs.clear();
+    bodyA_vertex_aabbs.reserve(VA.rows());
+    for (long i = 0; i < VA.rows(); i++) {
+        bodyA_vertex_aabbs.push_back(vertex_aabb(
+            VectorMax3<T>(R * VA.row(i).transpose().cast<T>() + p),
+            inflation_radius));
+    }
 
     detect_body_pair_collision_candidates_from_aabbs(
-        bodies, vertex_aabbs(VA, inflation_radius), bodyA_id, bodyB_id,
-        collision_types, candidates, inflation_radius);
+        bodies, bodyA_vertex_aabbs, cache.local_vertex_aabbs(bodyB_id),
+        bodyA_id, bodyB_id, collision_types, candidates, inflation_radius);
 }
 
 void detect_body_pair_intersection_candidates_from_aabbs(
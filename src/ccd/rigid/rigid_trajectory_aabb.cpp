@@ -1,5 +1,7 @@
 #include "rigid_trajectory_aabb.hpp"
 
+#include <utils/sinc.hpp>
+
 namespace ipc::rigid {
 
 typedef Pose<Interval> PoseI;
@@ -101,4 +103,151 @@ VectorMax3I face_vertex_aabb(
         - face_trajectory_aabb(bodyB, poseB_t0, poseB_t1, face_id, t, u, v);
 }
 
+namespace {
+    Eigen::Matrix<Interval, 2, 2>
+    rotation_matrix(const Eigen::Matrix<Interval, 1, 1>& r)
+    {
+        const Interval c = cos(r(0)), s = sin(r(0));
+        Eigen::Matrix<Interval, 2, 2> R;
+        R << c, -s, s, c;
+        return R;
+    }
+
+    Matrix3I rotation_matrix(const Vector3I& r)
+    {
+        // Same as construct_rotation_matrix() without dynamic sizes
+        // ‖r/2‖ = ‖r‖/2 because dividing by two is exact
+        const Interval angle =
+            sqrt(square(r(0)) + square(r(1)) + square(r(2)));
+        const Interval sinc_angle = sinc(angle);
+        const Interval sinc_half_angle = sinc(angle / 2.0);
+        const Matrix3I K = Hat(r);
+        Matrix3I R = sinc_angle * K
+            + (0.5 * sinc_half_angle * sinc_half_angle) * (K * K);
+        R.diagonal().array() += Interval(1.0);
+        return R;
+    }
+} // namespace
+
+template <int dim>
+RigidTrajectoryPairAABB<dim>::RigidTrajectoryPairAABB(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0,
+    const Pose<double>& poseA_t1,
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0,
+    const Pose<double>& poseB_t1)
+    : m_bodyA { bodyA,
+                poseA_t0.position.cast<Interval>(),
+                poseA_t1.position.cast<Interval>(),
+                poseA_t0.rotation.cast<Interval>(),
+                poseA_t1.rotation.cast<Interval>() }
+    , m_bodyB { bodyB,
+                poseB_t0.position.cast<Interval>(),
+                poseB_t1.position.cast<Interval>(),
+                poseB_t0.rotation.cast<Interval>(),
+                poseB_t1.rotation.cast<Interval>() }
+    , m_cache_size(0)
+    , m_next_cache_entry(0)
+{
+    assert(bodyA.dim() == dim && bodyB.dim() == dim);
+}
+
+template <int dim>
+const typename RigidTrajectoryPairAABB<dim>::Transforms&
+RigidTrajectoryPairAABB<dim>::transforms(const Interval& t)
+{
+    for (int i = 0; i < m_cache_size; i++) {
+        const Interval& ti = m_cache[i].t;
+        if (t.lower() == ti.lower() && t.upper() == ti.upper()) {
+            return m_cache[i];
+        }
+    }
+
+    // Replace the oldest entry
+    Transforms& entry = m_cache[m_next_cache_entry];
+    m_next_cache_entry = (m_next_cache_entry + 1) % CACHE_SIZE;
+    m_cache_size = std::min(m_cache_size + 1, CACHE_SIZE);
+
+    // Compute the poses at time t
+    entry.t = t;
+    entry.RA = rotation_matrix(RotationI(
+        (m_bodyA.rotation_t1 - m_bodyA.rotation_t0) * t
+        + m_bodyA.rotation_t0));
+    entry.pA =
+        (m_bodyA.position_t1 - m_bodyA.position_t0) * t + m_bodyA.position_t0;
+    entry.RB = rotation_matrix(RotationI(
+        (m_bodyB.rotation_t1 - m_bodyB.rotation_t0) * t
+        + m_bodyB.rotation_t0));
+    entry.pB =
+        (m_bodyB.position_t1 - m_bodyB.position_t0) * t + m_bodyB.position_t0;
+    return entry;
+}
+
+template <int dim>
+typename RigidTrajectoryPairAABB<dim>::VectorI
+RigidTrajectoryPairAABB<dim>::world_vertex(
+    const BodyTrajectory& body,
+    const MatrixI& R,
+    const VectorI& p,
+    size_t vertex_id) const
+{
+    const Eigen::Matrix<double, dim, 1> v =
+        body.body.vertices.row(vertex_id).transpose();
+    return R * v.template cast<Interval>() + p;
+}
+
+template <int dim>
+typename RigidTrajectoryPairAABB<dim>::VectorI
+RigidTrajectoryPairAABB<dim>::edge_vertex(
+    size_t vertex_id, size_t edge_id, const Interval& t, const Interval& alpha)
+{
+    const Transforms& T = transforms(t);
+    const auto& edges = m_bodyB.body.edges;
+    const VectorI e0 = world_vertex(m_bodyB, T.RB, T.pB, edges(edge_id, 0));
+    const VectorI e1 = world_vertex(m_bodyB, T.RB, T.pB, edges(edge_id, 1));
+    return world_vertex(m_bodyA, T.RA, T.pA, vertex_id)
+        - ((e1 - e0) * alpha + e0);
+}
+
+template <int dim>
+typename RigidTrajectoryPairAABB<dim>::VectorI
+RigidTrajectoryPairAABB<dim>::edge_edge(
+    size_t edgeA_id,
+    size_t edgeB_id,
+    const Interval& t,
+    const Interval& alpha,
+    const Interval& beta)
+{
+    const Transforms& T = transforms(t);
+    const auto& edgesA = m_bodyA.body.edges;
+    const auto& edgesB = m_bodyB.body.edges;
+    const VectorI ea0 = world_vertex(m_bodyA, T.RA, T.pA, edgesA(edgeA_id, 0));
+    const VectorI ea1 = world_vertex(m_bodyA, T.RA, T.pA, edgesA(edgeA_id, 1));
+    const VectorI eb0 = world_vertex(m_bodyB, T.RB, T.pB, edgesB(edgeB_id, 0));
+    const VectorI eb1 = world_vertex(m_bodyB, T.RB, T.pB, edgesB(edgeB_id, 1));
+    return ((ea1 - ea0) * alpha + ea0) - ((eb1 - eb0) * beta + eb0);
+}
+
+template <int dim>
+typename RigidTrajectoryPairAABB<dim>::VectorI
+RigidTrajectoryPairAABB<dim>::face_vertex(
+    size_t vertex_id,
+    size_t face_id,
+    const Interval& t,
+    const Interval& u,
+    const Interval& v)
+{
+    const Transforms& T = transforms(t);
+    const auto& faces = m_bodyB.body.faces;
+    const VectorI f0 = world_vertex(m_bodyB, T.RB, T.pB, faces(face_id, 0));
+    const VectorI f1 = world_vertex(m_bodyB, T.RB, T.pB, faces(face_id, 1));
+    const VectorI f2 = world_vertex(m_bodyB, T.RB, T.pB, faces(face_id, 2));
+    return world_vertex(m_bodyA, T.RA, T.pA, vertex_id)
+        - ((f1 - f0) * u + (f2 - f0) * v + f0);
+}
+
+template class RigidTrajectoryPairAABB<2>;
+template class RigidTrajectoryPairAABB<3>;
+
 } // namespace ipc::rigid
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include <interval/interval.hpp>
 #include <physics/rigid_body.hpp>
 
@@ -67,4 +69,88 @@ VectorMax3I face_vertex_aabb(
     const Interval& u = Interval(0, 1),
     const Interval& v = Interval(0, 1));
 
+/// @brief Fixed-dimension inclusion functions for the trajectories of a pair
+/// of rigid bodies.
+///
+/// The poses, rotation matrices, and vertices use fixed-size intervals, so no
+/// evaluation allocates. The rotations and positions of both bodies are
+/// cached for the last few time intervals. The root finder visits boxes in
+/// order of time and splits of the spatial parameters keep the time interval,
+/// so most boxes reuse the rotations of a recent box.
+///
+/// @tparam dim Dimension of the bodies (2 or 3).
+template <int dim> class RigidTrajectoryPairAABB {
+public:
+    typedef Eigen::Matrix<Interval, dim, 1> VectorI;
+    typedef Eigen::Matrix<Interval, dim, dim> MatrixI;
+    /// @brief Rotation vector (angle in 2D and axis-angle in 3D).
+    typedef Eigen::Matrix<Interval, dim == 2 ? 1 : 3, 1> RotationI;
+
+    RigidTrajectoryPairAABB(
+        const RigidBody& bodyA,       // First body of the pair
+        const Pose<double>& poseA_t0, // Pose of bodyA at t=0
+        const Pose<double>& poseA_t1, // Pose of bodyA at t=1
+        const RigidBody& bodyB,       // Second body of the pair
+        const Pose<double>& poseB_t0, // Pose of bodyB at t=0
+        const Pose<double>& poseB_t1  // Pose of bodyB at t=1
+    );
+
+    VectorI edge_vertex(
+        size_t vertex_id, // In bodyA
+        size_t edge_id,   // In bodyB
+        const Interval& t,
+        const Interval& alpha);
+
+    VectorI edge_edge(
+        size_t edgeA_id, // In bodyA
+        size_t edgeB_id, // In bodyB
+        const Interval& t,
+        const Interval& alpha,
+        const Interval& beta);
+
+    VectorI face_vertex(
+        size_t vertex_id, // In bodyA
+        size_t face_id,   // In bodyB
+        const Interval& t,
+        const Interval& u,
+        const Interval& v);
+
+    /// @brief Number of time intervals whose rotations are cached.
+    static constexpr int CACHE_SIZE = 8;
+
+protected:
+    struct BodyTrajectory {
+        const RigidBody& body;
+        VectorI position_t0, position_t1;
+        RotationI rotation_t0, rotation_t1;
+    };
+
+    /// @brief Rotation and position of both bodies over a time interval.
+    struct Transforms {
+        Interval t;
+        MatrixI RA, RB;
+        VectorI pA, pB;
+    };
+
+    /// @brief Get the transforms over t, computing them if they are not
+    /// cached.
+    const Transforms& transforms(const Interval& t);
+
+    /// @brief World position of a vertex given the rotation and position of
+    /// its body.
+    VectorI world_vertex(
+        const BodyTrajectory& body,
+        const MatrixI& R,
+        const VectorI& p,
+        size_t vertex_id) const;
+
+    BodyTrajectory m_bodyA, m_bodyB;
+
+    std::array<Transforms, CACHE_SIZE> m_cache;
+    /// @brief Number of valid cache entries.
+    int m_cache_size;
+    /// @brief Entry replaced by the next cache miss.
+    int m_next_cache_entry;
+};
+
 } // namespace ipc::rigid
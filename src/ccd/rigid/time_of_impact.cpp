@@ -6,6 +6,10 @@
 #include <igl/Timer.h>
 #endif
 
+#include <ipc/distance/edge_edge.hpp>
+#include <ipc/distance/point_edge.hpp>
+#include <ipc/distance/point_triangle.hpp>
+
 #include <ccd/rigid/rigid_trajectory_aabb.hpp>
 #include <geometry/distance.hpp>
 #include <geometry/intersection.hpp>
@@ -71,27 +75,27 @@ bool compute_edge_vertex_time_of_impact(
     assert(bodyB.dim() == dim);
     assert(dim == 2);
 
-    const PoseI poseIA_t0 = poseA_t0.cast<Interval>();
-    const PoseI poseIA_t1 = poseA_t1.cast<Interval>();
-
-    const PoseI poseIB_t0 = poseB_t0.cast<Interval>();
-    const PoseI poseIB_t1 = poseB_t1.cast<Interval>();
-
-    const auto distance = [&](const VectorMax3I& params) {
-        assert(params.size() == 2);
-        return edge_vertex_aabb(
-            bodyA, poseIA_t0, poseIA_t1, vertex_id, bodyB, poseIB_t0, poseIB_t1,
-            edge_id, /*t=*/params(0), /*alpha=*/params(1));
+    RigidTrajectoryPairAABB<2> trajectory(
+        bodyA, poseA_t0, poseA_t1, bodyB, poseB_t0, poseB_t1);
+    const auto distance = [&](const IntervalBoxes<2>& params,
+                              IntervalBoxes<2>& distances) {
+        for (size_t i = 0; i < params.size(); i++) {
+            distances.push_back(trajectory.edge_vertex(
+                vertex_id, edge_id, /*t=*/params.coord(0)[i],
+                /*alpha=*/params.coord(1)[i]));
+        }
     };
+    const auto always_true = [](const Vector2I&) { return true; };
 
     Eigen::Vector2d tol = compute_edge_vertex_tolerance(
         bodyA, poseA_t0, poseA_t1, vertex_id, bodyB, poseB_t0, poseB_t1,
         edge_id);
     tol[0] = toi_tolerance;
 
-    VectorMax3I x0 = Vector2I(Interval(0, earliest_toi), Interval(0, 1));
-    VectorMax3I toi_interval;
-    bool is_impacting = interval_root_finder(distance, x0, tol, toi_interval);
+    Vector2I x0(Interval(0, earliest_toi), Interval(0, 1));
+    Vector2I toi_interval;
+    bool is_impacting = interval_root_finder_batched<2>(
+        distance, always_true, always_true, x0, tol, toi_interval);
 
     // Return a conservative time-of-impact
     toi = is_impacting ? toi_interval(0).lower()
@@ -170,16 +174,17 @@ bool compute_edge_edge_time_of_impact(
 {
     assert(bodyA.dim() == 3 && bodyB.dim() == bodyA.dim());
 
-    const PoseI poseIA_t0 = poseA_t0.cast<Interval>();
-    const PoseI poseIA_t1 = poseA_t1.cast<Interval>();
-    const PoseI poseIB_t0 = poseB_t0.cast<Interval>();
-    const PoseI poseIB_t1 = poseB_t1.cast<Interval>();
-    const auto distance = [&](const VectorMax3I& params) {
-        assert(params.size() == 3);
-        return edge_edge_aabb(
-            bodyA, poseIA_t0, poseIA_t1, edgeA_id, bodyB, poseIB_t0, poseIB_t1,
-            edgeB_id, /*t=*/params(0), /*alpha=*/params(1), /*beta=*/params(2));
+    RigidTrajectoryPairAABB<3> trajectory(
+        bodyA, poseA_t0, poseA_t1, bodyB, poseB_t0, poseB_t1);
+    const auto distance = [&](const IntervalBoxes<3>& params,
+                              IntervalBoxes<3>& distances) {
+        for (size_t i = 0; i < params.size(); i++) {
+            distances.push_back(trajectory.edge_edge(
+                edgeA_id, edgeB_id, /*t=*/params.coord(0)[i],
+                /*alpha=*/params.coord(1)[i], /*beta=*/params.coord(2)[i]));
+        }
     };
+    const auto always_true = [](const Vector3I&) { return true; };
 
     Eigen::Vector3d tol = compute_edge_edge_tolerance(
         bodyA, poseA_t0, poseA_t1, edgeA_id, //
@@ -191,10 +196,10 @@ bool compute_edge_edge_time_of_impact(
     timer.start();
 #endif
 
-    VectorMax3I toi_interval;
-    VectorMax3I x0 =
-        Vector3I(Interval(0, earliest_toi), Interval(0, 1), Interval(0, 1));
-    bool is_impacting = interval_root_finder(distance, x0, tol, toi_interval);
+    Vector3I toi_interval;
+    Vector3I x0(Interval(0, earliest_toi), Interval(0, 1), Interval(0, 1));
+    bool is_impacting = interval_root_finder_batched<3>(
+        distance, always_true, always_true, x0, tol, toi_interval);
 
 #ifdef TIME_CCD_QUERIES
     timer.stop();
@@ -260,20 +265,19 @@ bool compute_face_vertex_time_of_impact(
 {
     assert(bodyA.dim() == 3 && bodyA.dim() == bodyB.dim());
 
-    const PoseI poseIA_t0 = poseA_t0.cast<Interval>();
-    const PoseI poseIA_t1 = poseA_t1.cast<Interval>();
-    const PoseI poseIB_t0 = poseB_t0.cast<Interval>();
-    const PoseI poseIB_t1 = poseB_t1.cast<Interval>();
-
-    const auto distance = [&](const VectorMax3I& params) {
-        assert(params.size() == 3);
-        return face_vertex_aabb(
-            bodyA, poseIA_t0, poseIA_t1, vertex_id, //
-            bodyB, poseIB_t0, poseIB_t1, face_id,   //
-            /*t=*/params(0), /*u=*/params(1), /*v=*/params(2));
+    RigidTrajectoryPairAABB<3> trajectory(
+        bodyA, poseA_t0, poseA_t1, bodyB, poseB_t0, poseB_t1);
+    const auto distance = [&](const IntervalBoxes<3>& params,
+                              IntervalBoxes<3>& distances) {
+        for (size_t i = 0; i < params.size(); i++) {
+            distances.push_back(trajectory.face_vertex(
+                vertex_id, face_id, /*t=*/params.coord(0)[i],
+                /*u=*/params.coord(1)[i], /*v=*/params.coord(2)[i]));
+        }
     };
+    const auto always_true = [](const Vector3I&) { return true; };
 
-    const auto is_domain_valid = [&](const VectorMax3I& params) {
+    const auto is_domain_valid = [&](const Vector3I& params) {
         const Interval &t = params[0], &u = params[1], &v = params[2];
         // 0 ≤ t, u, v ≤ 1 is satisfied by the initial domain of the solve
         return overlap(u + v, Interval(0, 1));
@@ -289,11 +293,10 @@ bool compute_face_vertex_time_of_impact(
     timer.start();
 #endif
 
-    VectorMax3I toi_interval;
-    VectorMax3I x0 =
-        Vector3I(Interval(0, earliest_toi), Interval(0, 1), Interval(0, 1));
-    bool is_impacting =
-        interval_root_finder(distance, is_domain_valid, x0, tol, toi_interval);
+    Vector3I toi_interval;
+    Vector3I x0(Interval(0, earliest_toi), Interval(0, 1), Interval(0, 1));
+    bool is_impacting = interval_root_finder_batched<3>(
+        distance, always_true, is_domain_valid, x0, tol, toi_interval);
 
 #ifdef TIME_CCD_QUERIES
     timer.stop();
@@ -309,4 +312,100 @@ bool compute_face_vertex_time_of_impact(
     return is_impacting;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Conservative lower bounds
+
+double compute_time_of_impact_lower_bound(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0,
+    const Pose<double>& poseA_t1,
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0,
+    const Pose<double>& poseB_t1,
+    double distance_t0,
+    double minimum_separation_distance)
+{
+    const double gap = distance_t0 - minimum_separation_distance;
+    if (gap <= 0) {
+        return 0;
+    }
+
+    const double dpA = (poseA_t1.position - poseA_t0.position).norm();
+    const double dpB = (poseB_t1.position - poseB_t0.position).norm();
+    // A rotation displaces a point by at most the diameter of its orbit
+    if (gap > dpA + dpB + 2 * (bodyA.r_max + bodyB.r_max)) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const double max_speed = dpA
+        + bodyA.r_max * (poseA_t1.rotation - poseA_t0.rotation).norm() + dpB
+        + bodyB.r_max * (poseB_t1.rotation - poseB_t0.rotation).norm();
+    if (max_speed == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return gap / max_speed;
+}
+
+double compute_edge_vertex_time_of_impact_lower_bound(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0,
+    const Pose<double>& poseA_t1,
+    size_t vertex_id,
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0,
+    const Pose<double>& poseB_t1,
+    size_t edge_id,
+    double minimum_separation_distance)
+{
+    const double distance_t0 = sqrt(point_edge_distance(
+        bodyA.world_vertex(poseA_t0, vertex_id),
+        bodyB.world_vertex(poseB_t0, bodyB.edges(edge_id, 0)),
+        bodyB.world_vertex(poseB_t0, bodyB.edges(edge_id, 1))));
+    return compute_time_of_impact_lower_bound(
+        bodyA, poseA_t0, poseA_t1, bodyB, poseB_t0, poseB_t1, distance_t0,
+        minimum_separation_distance);
+}
+
+double compute_edge_edge_time_of_impact_lower_bound(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0,
+    const Pose<double>& poseA_t1,
+    size_t edgeA_id,
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0,
+    const Pose<double>& poseB_t1,
+    size_t edgeB_id,
+    double minimum_separation_distance)
+{
+    const double distance_t0 = sqrt(edge_edge_distance(
+        bodyA.world_vertex(poseA_t0, bodyA.edges(edgeA_id, 0)),
+        bodyA.world_vertex(poseA_t0, bodyA.edges(edgeA_id, 1)),
+        bodyB.world_vertex(poseB_t0, bodyB.edges(edgeB_id, 0)),
+        bodyB.world_vertex(poseB_t0, bodyB.edges(edgeB_id, 1))));
+    return compute_time_of_impact_lower_bound(
+        bodyA, poseA_t0, poseA_t1, bodyB, poseB_t0, poseB_t1, distance_t0,
+        minimum_separation_distance);
+}
+
+double compute_face_vertex_time_of_impact_lower_bound(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0,
+    const Pose<double>& poseA_t1,
+    size_t vertex_id,
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0,
+    const Pose<double>& poseB_t1,
+    size_t face_id,
+    double minimum_separation_distance)
+{
+    const double distance_t0 = sqrt(point_triangle_distance(
+        bodyA.world_vertex(poseA_t0, vertex_id),
+        bodyB.world_vertex(poseB_t0, bodyB.faces(face_id, 0)),
+        bodyB.world_vertex(poseB_t0, bodyB.faces(face_id, 1)),
+        bodyB.world_vertex(poseB_t0, bodyB.faces(face_id, 2))));
+    return compute_time_of_impact_lower_bound(
+        bodyA, poseA_t0, poseA_t1, bodyB, poseB_t0, poseB_t1, distance_t0,
+        minimum_separation_distance);
+}
+
 } // namespace ipc::rigid
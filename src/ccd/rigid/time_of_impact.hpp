@@ -52,4 +52,62 @@ bool compute_face_vertex_time_of_impact(
     double earliest_toi = 1, // Only search for collision in [0, earliest_toi]
     double toi_tolerance = Constants::RIGID_CCD_TOI_TOL);
 
+/// @brief Conservative lower bound on the time-of-impact of two bodies.
+///
+/// Every point of a body lies within r_max of its center of mass and the
+/// exponential map of the rotation vector is 1-Lipschitz, so a point moves at
+/// most t(‖Δp‖ + r_max‖Δθ‖) and never more than ‖Δp‖ + 2r_max over [0, t].
+/// Two primitives initially distance_t0 apart cannot come closer than
+/// minimum_separation_distance before the returned time. This holds for the
+/// rigid trajectory and for any linear interpolation of it (e.g., the
+/// piecewise-linear trajectory).
+///
+/// @returns A time t ≥ 0 such that no impact can occur in [0, t) (∞ if the
+///          primitives can never come within minimum_separation_distance).
+double compute_time_of_impact_lower_bound(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0, // Pose of bodyA at t=0
+    const Pose<double>& poseA_t1, // Pose of bodyA at t=1
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0, // Pose of bodyB at t=0
+    const Pose<double>& poseB_t1, // Pose of bodyB at t=1
+    double distance_t0,
+    double minimum_separation_distance = 0);
+
+/// Lower bound on the time-of-impact of an edge-vertex pair
+double compute_edge_vertex_time_of_impact_lower_bound(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0, // Pose of bodyA at t=0
+    const Pose<double>& poseA_t1, // Pose of bodyA at t=1
+    size_t vertex_id,             // In bodyA
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0, // Pose of bodyB at t=0
+    const Pose<double>& poseB_t1, // Pose of bodyB at t=1
+    size_t edge_id,               // In bodyB
+    double minimum_separation_distance = 0);
+
+/// Lower bound on the time-of-impact of an edge-edge pair
+double compute_edge_edge_time_of_impact_lower_bound(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0, // Pose of bodyA at t=0
+    const Pose<double>& poseA_t1, // Pose of bodyA at t=1
+    size_t edgeA_id,              // In bodyA
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0, // Pose of bodyB at t=0
+    const Pose<double>& poseB_t1, // Pose of bodyB at t=1
+    size_t edgeB_id,              // In bodyB
+    double minimum_separation_distance = 0);
+
+/// Lower bound on the time-of-impact of a face-vertex pair
+double compute_face_vertex_time_of_impact_lower_bound(
+    const RigidBody& bodyA,
+    const Pose<double>& poseA_t0, // Pose of bodyA at t=0
+    const Pose<double>& poseA_t1, // Pose of bodyA at t=1
+    size_t vertex_id,             // In bodyA
+    const RigidBody& bodyB,
+    const Pose<double>& poseB_t0, // Pose of bodyB at t=0
+    const Pose<double>& poseB_t1, // Pose of bodyB at t=1
+    size_t face_id,               // In bodyB
+    double minimum_separation_distance = 0);
+
 } // namespace ipc::rigid
@@ -38,8 +38,13 @@ namespace Constants {
     /// \brief Default tolerance used for interval root finding.
     static const double INTERVAL_ROOT_FINDER_TOL = 1e-8;
 
-    /// \brief Default tolerance used for interval root finding.
-    static const int INTERVAL_ROOT_FINDER_MAX_ITERATIONS = 10000;
+    /// \brief Default maximum number of boxes evaluated by interval root
+    /// finding (negative for no limit).
+    static const int INTERVAL_ROOT_FINDER_MAX_ITERATIONS = -1;
+
+    /// \brief Number of boxes popped from the frontier of the interval root
+    /// finder per call to the inclusion function.
+    static const int INTERVAL_ROOT_FINDER_BATCH_SIZE = 64;
 
     /// \brief Scaling of κ_min to better condition the system
     static const double DEFAULT_MIN_BARRIER_STIFFNESS_SCALE = 1e11;
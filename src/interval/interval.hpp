@@ -6,7 +6,9 @@
 #include <boost/numeric/interval.hpp>
 
 #define USE_FILIB_INTERVALS
-#ifdef USE_FILIB_INTERVALS
+#ifdef RIGID_IPC_MODE_FREE_INTERVALS
+#include <interval/mode_free_rounding.hpp>
+#elif defined(USE_FILIB_INTERVALS)
 #include <interval/filib_rounding.hpp>
 #endif
 
@@ -19,7 +21,17 @@ namespace interval_options {
         CheckingPolicy;
 } // namespace interval_options
 
-#ifdef USE_FILIB_INTERVALS
+#ifdef RIGID_IPC_MODE_FREE_INTERVALS
+
+// Use outward rounding without saving and restoring the FPU state
+typedef boost::numeric::interval<
+    double,
+    boost::numeric::interval_lib::policies<
+        boost::numeric::interval_lib::save_state_nothing<ModeFreeRounding>,
+        interval_options::CheckingPolicy>>
+    Interval;
+
+#elif defined(USE_FILIB_INTERVALS)
 
 // Use filib rounding arithmetic
 typedef boost::numeric::interval<
@@ -55,10 +67,19 @@ typedef boost::numeric::interval<
 
 #endif // USE_FILIB_INTERVALS
 
+/// @brief Widths of a vector of intervals with the same (maximum) size.
 template <typename Derived>
-inline Eigen::VectorXd width(const Eigen::MatrixBase<Derived>& x)
+inline Eigen::Matrix<
+    double,
+    Derived::SizeAtCompileTime,
+    1,
+    Eigen::ColMajor,
+    Derived::MaxSizeAtCompileTime,
+    1>
+width(const Eigen::MatrixBase<Derived>& x)
 {
-    Eigen::VectorXd w(x.size());
+    decltype(width(x)) w;
+    w.resize(x.size());
     for (int i = 0; i < x.size(); i++) {
         w(i) = width(x(i));
     }
@@ -68,7 +89,7 @@ inline Eigen::VectorXd width(const Eigen::MatrixBase<Derived>& x)
 template <typename Derived>
 inline double diagonal_width(const Eigen::MatrixBase<Derived>& x)
 {
-    Eigen::VectorXd widths = width(x);
+    const auto widths = width(x);
     double w = 0;
     for (int i = 0; i < widths.size(); i++) {
         w += widths(i) * widths(i);
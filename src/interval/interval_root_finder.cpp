@@ -1,9 +1,8 @@
 // A root finder using interval arithmetic.
 #include "interval_root_finder.hpp"
 
-#include <stack>
-
 #include <logger.hpp>
+#include <utils/not_implemented_error.hpp>
 
 namespace ipc::rigid {
 
@@ -94,6 +93,35 @@ void log_octree(
     }
 }
 
+template <int dim>
+bool interval_root_finder_fixed_dim(
+    const std::function<VectorMax3I(const VectorMax3I&)>& f,
+    const std::function<bool(const VectorMax3I&)>& constraint_predicate,
+    const std::function<bool(const VectorMax3I&)>& is_domain_valid,
+    const VectorMax3I& x0,
+    const VectorMax3d& tol,
+    VectorMax3I& x,
+    int max_iterations)
+{
+    typedef Eigen::Matrix<Interval, dim, 1> Box;
+    Box x_fixed;
+    bool found_root = interval_root_finder_batched<dim>(
+        [&](const IntervalBoxes<dim>& xs, IntervalBoxes<dim>& ys) {
+            // f only takes a single box, so evaluate them one at a time
+            for (size_t i = 0; i < xs.size(); i++) {
+                ys.push_back(Box(f(VectorMax3I(xs[i]))));
+            }
+        },
+        [&](const Box& xi) { return constraint_predicate(VectorMax3I(xi)); },
+        [&](const Box& xi) { return is_domain_valid(VectorMax3I(xi)); },
+        Box(x0), Eigen::Matrix<double, dim, 1>(tol), x_fixed, max_iterations);
+    x = found_root ? VectorMax3I(x_fixed)
+                   : VectorMax3I::Constant(
+                       x0.size(),
+                       Interval(std::numeric_limits<double>::infinity()));
+    return found_root;
+}
+
 bool interval_root_finder(
     const std::function<VectorMax3I(const VectorMax3I&)>& f,
     const std::function<bool(const VectorMax3I&)>& constraint_predicate,
@@ -105,101 +133,24 @@ bool interval_root_finder(
 {
     // log_octree(f, x0);
 
-    // Keep searching for earlier roots (assumes time is first coordinate)
-    VectorMax3I earliest_root = VectorMax3I::Constant(
-        x0.size(), Interval(std::numeric_limits<double>::infinity()));
-    bool found_root = false;
-
-    // Stack of intervals and the last split dimension
-    std::stack<VectorMax3I> xs;
-    xs.push(x0);
-
-    // If the start is a root then we are in trouble, so we should reduce the
-    // tolerance.
-    VectorMax3I x_tol(tol.size());
-    for (int i = 0; i < x_tol.size(); i++) {
-        x_tol(i) = Interval(0, tol(i));
-    }
-    if (zero_in(f(x_tol))) {
-        tol(0) /= 1e2;
+    switch (x0.size()) {
+    case 1:
+        return interval_root_finder_fixed_dim<1>(
+            f, constraint_predicate, is_domain_valid, x0, tol, x,
+            max_iterations);
+    case 2:
+        return interval_root_finder_fixed_dim<2>(
+            f, constraint_predicate, is_domain_valid, x0, tol, x,
+            max_iterations);
+    case 3:
+        return interval_root_finder_fixed_dim<3>(
+            f, constraint_predicate, is_domain_valid, x0, tol, x,
+            max_iterations);
+    default:
+        throw NotImplementedError(
+            "interval_root_finder() is only implemented for 1 to 3 "
+            "dimensions!");
     }
-
-    // TODO: Enable max_iterations
-    for (size_t iter = 0; !xs.empty(); iter++) {
-        x = xs.top();
-        xs.pop();
-
-        // Skip any interval that is not before the earliest root
-        if (x[0].lower() >= earliest_root[0].lower()) {
-            continue;
-        }
-
-        if (!is_domain_valid(x)) {
-            continue;
-        }
-
-        VectorMax3I y = f(x);
-
-        // spdlog::critical(
-        //     "{} ↦ {}", fmt_eigen_intervals(x),
-        //     fmt_eigen_intervals(y));
-
-        if (!zero_in(y)) {
-            continue;
-        }
-
-        VectorMax3d widths = width(x);
-        bool all_tol_sat = (widths.array() <= tol.array()).all();
-        bool all_widths_zero = (widths.array() <= 1e-10).all();
-        if ((x[0].lower() > 0 || all_widths_zero) && all_tol_sat) {
-            if (constraint_predicate(x)) {
-                earliest_root = x;
-                found_root = true;
-            }
-            continue;
-        }
-
-        // Check the diagonal of the range box
-        // if (diagonal_width(y) <= Constants::INTERVAL_ROOT_FINDER_RANGE_TOL
-        //     && constraint_predicate(x)) {
-        //     earliest_root = x;
-        //     found_root = true;
-        //     continue;
-        // }
-
-        // Bisect the largest dimension divided by its tolerance
-        int split_i = -1;
-        for (int i = 0; i < x.size(); i++) {
-            if ((all_tol_sat || widths(i) > tol(i))
-                && (split_i == -1
-                    || widths(i) * tol(split_i) > widths(split_i) * tol(i))) {
-                split_i = i;
-            }
-        }
-        assert(split_i >= 0 && split_i <= x.size());
-
-        std::pair<Interval, Interval> halves = bisect(x(split_i));
-        // Push the second half on first so it is examined after the first half
-        x(split_i) = halves.second;
-        xs.push(x);
-        x(split_i) = halves.first;
-        xs.push(x);
-    }
-    // TODO: This is needs to be updated when max_iterations is renabled
-    // if (!xs.empty()) {
-    //     // Return the earliest possible time of impact
-    //     x = xs.top().first;
-    //     xs.pop();
-    //     while (!xs.empty()) {
-    //         if (xs.top().first[0].lower() < x[0].lower()) {
-    //             x = xs.top().first;
-    //         }
-    //         xs.pop();
-    //     }
-    //     return true; // A conservative answer
-    // }
-    x = earliest_root;
-    return found_root;
 }
 
 } // namespace ipc::rigid
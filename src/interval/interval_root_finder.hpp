@@ -1,7 +1,9 @@
 // A root finder using interval arithmetic.
 #pragma once
 
+#include <array>
 #include <functional>
+#include <vector>
 
 #include <constants.hpp>
 #include <interval/interval.hpp>
@@ -52,4 +54,88 @@ bool interval_root_finder(
     VectorMax3I& x,
     int max_iterations = Constants::INTERVAL_ROOT_FINDER_MAX_ITERATIONS);
 
+/// @brief A batch of n-dimensional interval boxes.
+///
+/// Each coordinate is stored in its own contiguous array (structure of
+/// arrays), so an inclusion function receives the whole batch in one call.
+/// It is free to evaluate the boxes one at a time.
+template <int dim> class IntervalBoxes {
+public:
+    typedef Eigen::Matrix<Interval, dim, 1> Box;
+
+    size_t size() const { return m_coords[0].size(); }
+    bool empty() const { return m_coords[0].empty(); }
+
+    void clear()
+    {
+        for (auto& coord : m_coords) {
+            coord.clear();
+        }
+    }
+
+    void push_back(const Box& x)
+    {
+        for (int i = 0; i < dim; i++) {
+            m_coords[i].push_back(x(i));
+        }
+    }
+
+    Box operator[](size_t j) const
+    {
+        Box x;
+        for (int i = 0; i < dim; i++) {
+            x(i) = m_coords[i][j];
+        }
+        return x;
+    }
+
+    /// @brief All values of the i-th coordinate.
+    const std::vector<Interval>& coord(int i) const { return m_coords[i]; }
+    std::vector<Interval>& coord(int i) { return m_coords[i]; }
+
+protected:
+    std::array<std::vector<Interval>, dim> m_coords;
+};
+
+/// @brief Find the earliest box containing a root of f: Iⁿ ↦ Iⁿ.
+///
+/// The boxes to visit are kept in a frontier ordered by the start of the
+/// first coordinate (time). The earliest batch_size boxes are popped and
+/// evaluated with a single call to
+/// f(const IntervalBoxes<dim>& x, IntervalBoxes<dim>& y), which must append
+/// the range of every box of x to the (empty) y. Boxes that start after the
+/// earliest root found so far are pruned. Grouping the boxes only saves the
+/// per-call overhead; the std::function overloads above and the rigid CCD
+/// still evaluate them one box at a time.
+///
+/// @param f                    Batched inclusion function.
+/// @param constraint_predicate Predicate a root box must satisfy.
+/// @param is_domain_valid      Predicate a box must satisfy to be evaluated.
+/// @param x0                   Initial box.
+/// @param tol                  Width of the root box in each dimension.
+/// @param[out] x               Earliest root box if one was found.
+/// @param max_iterations       Maximum number of boxes to evaluate (negative
+///                             for no limit, the default). If it is reached,
+///                             a warning is logged and the earliest box left
+///                             is returned as a conservative root, which can
+///                             be much earlier than the true root.
+/// @param batch_size           Maximum number of boxes evaluated per call.
+/// @returns True if a root was found.
+template <
+    int dim,
+    typename BatchFunction,
+    typename ConstraintPredicate,
+    typename DomainPredicate>
+bool interval_root_finder_batched(
+    const BatchFunction& f,
+    const ConstraintPredicate& constraint_predicate,
+    const DomainPredicate& is_domain_valid,
+    const Eigen::Matrix<Interval, dim, 1>& x0,
+    Eigen::Matrix<double, dim, 1> tol,
+    Eigen::Matrix<Interval, dim, 1>& x,
+    int max_iterations = Constants::INTERVAL_ROOT_FINDER_MAX_ITERATIONS,
+    int batch_size = Constants::INTERVAL_ROOT_FINDER_BATCH_SIZE);
+
 } // namespace ipc::rigid
+
+#include "interval_root_finder.tpp"
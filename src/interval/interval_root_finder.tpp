@@ -0,0 +1,137 @@
+#pragma once
+#include "interval_root_finder.hpp"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+namespace ipc::rigid {
+
+template <
+    int dim,
+    typename BatchFunction,
+    typename ConstraintPredicate,
+    typename DomainPredicate>
+bool interval_root_finder_batched(
+    const BatchFunction& f,
+    const ConstraintPredicate& constraint_predicate,
+    const DomainPredicate& is_domain_valid,
+    const Eigen::Matrix<Interval, dim, 1>& x0,
+    Eigen::Matrix<double, dim, 1> tol,
+    Eigen::Matrix<Interval, dim, 1>& x,
+    int max_iterations,
+    int batch_size)
+{
+    typedef Eigen::Matrix<Interval, dim, 1> Box;
+    assert(batch_size > 0);
+
+    // Keep searching for earlier roots (assumes time is first coordinate)
+    double earliest_root_start = std::numeric_limits<double>::infinity();
+    Box earliest_root;
+    bool found_root = false;
+
+    IntervalBoxes<dim> batch, ranges;
+
+    // If the start is a root then we are in trouble, so we should reduce the
+    // tolerance.
+    Box x_tol;
+    for (int i = 0; i < dim; i++) {
+        x_tol(i) = Interval(0, tol(i));
+    }
+    batch.push_back(x_tol);
+    f(batch, ranges);
+    if (zero_in(ranges[0])) {
+        tol(0) /= 1e2;
+    }
+
+    // Frontier of boxes to visit ordered by the start of the first coordinate
+    // (time), so the earliest boxes are always evaluated first and a root
+    // prunes every box that starts after it.
+    const auto starts_later = [](const Box& a, const Box& b) {
+        return a(0).lower() > b(0).lower();
+    };
+    std::vector<Box> frontier = { x0 };
+
+    int num_iterations = 0;
+    while (!frontier.empty()
+           && frontier.front()(0).lower() < earliest_root_start) {
+        if (max_iterations >= 0 && num_iterations >= max_iterations) {
+            // Return the earliest box left as a conservative root
+            x = frontier.front();
+            spdlog::warn(
+                "interval root finder reached max_iterations={:d}; returning "
+                "the earliest unresolved box (t={:g}) as a conservative root",
+                max_iterations, x(0).lower());
+            return true;
+        }
+
+        // Pop the earliest boxes up to a batch
+        const int max_batch_size = max_iterations >= 0
+            ? std::min(batch_size, max_iterations - num_iterations)
+            : batch_size;
+        batch.clear();
+        while (!frontier.empty() && int(batch.size()) < max_batch_size
+               && frontier.front()(0).lower() < earliest_root_start) {
+            std::pop_heap(frontier.begin(), frontier.end(), starts_later);
+            if (is_domain_valid(frontier.back())) {
+                batch.push_back(frontier.back());
+            }
+            frontier.pop_back();
+        }
+        if (batch.empty()) {
+            continue;
+        }
+        num_iterations += int(batch.size());
+
+        ranges.clear();
+        f(batch, ranges);
+        assert(ranges.size() == batch.size());
+
+        for (size_t j = 0; j < batch.size(); j++) {
+            Box xj = batch[j];
+            // Skip boxes after a root found earlier in this batch
+            if (xj(0).lower() >= earliest_root_start || !zero_in(ranges[j])) {
+                continue;
+            }
+
+            const Eigen::Matrix<double, dim, 1> widths = width(xj);
+            bool all_tol_sat = (widths.array() <= tol.array()).all();
+            bool all_widths_zero = (widths.array() <= 1e-10).all();
+            if ((xj(0).lower() > 0 || all_widths_zero) && all_tol_sat) {
+                if (constraint_predicate(xj)) {
+                    earliest_root = xj;
+                    earliest_root_start = xj(0).lower();
+                    found_root = true;
+                }
+                continue;
+            }
+
+            // Bisect the largest dimension divided by its tolerance
+            int split_i = -1;
+            for (int i = 0; i < dim; i++) {
+                if ((all_tol_sat || widths(i) > tol(i))
+                    && (split_i == -1
+                        || widths(i) * tol(split_i)
+                            > widths(split_i) * tol(i))) {
+                    split_i = i;
+                }
+            }
+            assert(split_i >= 0 && split_i < dim);
+
+            std::pair<Interval, Interval> halves = bisect(xj(split_i));
+            xj(split_i) = halves.first;
+            frontier.push_back(xj);
+            std::push_heap(frontier.begin(), frontier.end(), starts_later);
+            xj(split_i) = halves.second;
+            frontier.push_back(xj);
+            std::push_heap(frontier.begin(), frontier.end(), starts_later);
+        }
+    }
+
+    if (found_root) {
+        x = earliest_root;
+    }
+    return found_root;
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include <interval/filib_rounding.hpp>
+
+namespace ipc::rigid {
+
+/// @brief A double greater than x by at least one ulp.
+///
+/// Bumping a result computed with round-to-nearest by one ulp gives an upper
+/// bound of the exact result without changing the FPU rounding mode.
+/// |x|·2⁻⁵² is at least one ulp of x and the smallest denormal handles x = 0.
+/// A result that overflowed to -∞ is clamped to the lowest finite double.
+/// @note Assumes denormals are not flushed to zero.
+inline double next_up(double x)
+{
+    if (x == -std::numeric_limits<double>::infinity()) {
+        return std::numeric_limits<double>::lowest();
+    }
+    if (!std::isfinite(x)) {
+        return x;
+    }
+    return x
+        + (std::abs(x) * std::numeric_limits<double>::epsilon()
+           + std::numeric_limits<double>::denorm_min());
+}
+
+/// @brief A double less than x by at least one ulp.
+///
+/// A result that overflowed to +∞ is clamped to the largest finite double.
+inline double next_down(double x) { return -next_up(-x); }
+
+/// @brief Outward rounding that never touches the FPU rounding mode.
+///
+/// Arithmetic is computed with the default round-to-nearest mode and then
+/// bumped outward by one ulp (see next_up()). The interval can therefore use
+/// save_state_nothing instead of saving and restoring the FPU state on every
+/// operation. Transcendental functions are inherited from FILibRounding, but
+/// the functions that FILibRounding implements by switching the rounding mode
+/// are overridden, because nothing would restore it.
+struct ModeFreeRounding : FILibRounding {
+    // Results of exact operations (e.g., x + (-x) or x * 0) are not widened.
+    double add_down(double x, double y)
+    {
+        const double r = x + y;
+        return r == 0 ? 0 : next_down(r);
+    }
+    double add_up(double x, double y)
+    {
+        const double r = x + y;
+        return r == 0 ? 0 : next_up(r);
+    }
+    double sub_down(double x, double y)
+    {
+        const double r = x - y;
+        return r == 0 ? 0 : next_down(r);
+    }
+    double sub_up(double x, double y)
+    {
+        const double r = x - y;
+        return r == 0 ? 0 : next_up(r);
+    }
+    double mul_down(double x, double y)
+    {
+        return (x == 0 || y == 0) ? 0 : next_down(x * y);
+    }
+    double mul_up(double x, double y)
+    {
+        return (x == 0 || y == 0) ? 0 : next_up(x * y);
+    }
+    double div_down(double x, double y) { return x == 0 ? 0 : next_down(x / y); }
+    double div_up(double x, double y) { return x == 0 ? 0 : next_up(x / y); }
+
+    /// @brief median of two numbers rounded to closest number
+    double median(double x, double y) { return (x + y) / 2; }
+
+    /// @brief round down to integer
+    double int_down(double x) { return std::floor(x); }
+    /// @brief round up to integer
+    double int_up(double x) { return std::ceil(x); }
+
+    /// @brief convert to the closest double (rounding down)
+    template <typename T> double conv_down(const T& x)
+    {
+        if constexpr (std::is_same_v<T, double>) {
+            return x;
+        } else {
+            return next_down(static_cast<double>(x));
+        }
+    }
+    /// @brief convert to the closest double (rounding up)
+    template <typename T> double conv_up(const T& x)
+    {
+        if constexpr (std::is_same_v<T, double>) {
+            return x;
+        } else {
+            return next_up(static_cast<double>(x));
+        }
+    }
+};
+
+} // namespace ipc::rigid
@@ -0,0 +1,129 @@
+#include "mapped_file.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+// An empty file cannot be mapped, so it is represented by a non-null pointer
+// to an empty buffer.
+static const char EMPTY_FILE[1] = { '\0' };
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    HANDLE file = CreateFileA(
+        filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        spdlog::error("Unable to open file: {}", filename);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        spdlog::error("Unable to get the size of file: {}", filename);
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        m_data = EMPTY_FILE;
+        m_size = 0;
+        return true;
+    }
+
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* data = mapping == nullptr
+        ? nullptr
+        : MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        spdlog::error("Unable to memory map file: {}", filename);
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file_handle = file;
+    m_mapping_handle = mapping;
+    m_data = static_cast<const char*>(data);
+    m_size = size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr && m_data != EMPTY_FILE) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping_handle);
+        CloseHandle(m_file_handle);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_file_handle = m_mapping_handle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        spdlog::error("Unable to open file: {}", filename);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        spdlog::error("Unable to get the size of file: {}", filename);
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        m_data = EMPTY_FILE;
+        m_size = 0;
+        return true;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the file descriptor is closed
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        spdlog::error("Unable to memory map file: {}", filename);
+        return false;
+    }
+
+    m_data = static_cast<const char*>(data);
+    m_size = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr && m_data != EMPTY_FILE) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+} // namespace ipc::rigid
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ipc::rigid {
+
+/// @brief Read-only memory map of a whole file.
+///
+/// Pages are only loaded by the OS when they are touched, so mapping a large
+/// file is cheap and reading a small part of it only costs that part.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// @brief Map a file into memory.
+    /// @returns true on success, false on errors
+    bool open(const std::string& filename);
+
+    /// @brief Unmap the file.
+    void close();
+
+    bool is_open() const { return m_data != nullptr; }
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+
+protected:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+#if defined(_WIN32)
+    void* m_file_handle = nullptr;
+    void* m_mapping_handle = nullptr;
+#endif
+};
+
+} // namespace ipc::rigid
@@ -0,0 +1,290 @@
+#include "results_reader.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <string_view>
+
+#include <io/serialize_json.hpp>
+#include <logger.hpp>
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+namespace {
+    /// Finds the byte ranges of JSON values without parsing them.
+    class JSONScanner {
+    public:
+        JSONScanner(const char* begin, const char* end)
+            : p(begin)
+            , end(end)
+        {
+        }
+
+        /// Call f(key, value_begin, value_end) for each member of an object.
+        template <typename F> bool for_each_member(F f)
+        {
+            if (!consume('{')) {
+                return false;
+            }
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                skip_whitespace();
+                const char* key_begin = p;
+                if (p == end || *p != '"' || !skip_string()) {
+                    return false;
+                }
+                // Keys are compared raw, which is fine without escapes
+                std::string_view key(key_begin + 1, p - key_begin - 2);
+                if (!consume(':')) {
+                    return false;
+                }
+                skip_whitespace();
+                const char* value_begin = p;
+                if (!skip_value()) {
+                    return false;
+                }
+                f(key, value_begin, p);
+            } while (consume(','));
+            return consume('}');
+        }
+
+        /// Call f(value_begin, value_end) for each element of an array.
+        template <typename F> bool for_each_element(F f)
+        {
+            if (!consume('[')) {
+                return false;
+            }
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                skip_whitespace();
+                const char* value_begin = p;
+                if (!skip_value()) {
+                    return false;
+                }
+                f(value_begin, p);
+            } while (consume(','));
+            return consume(']');
+        }
+
+    protected:
+        void skip_whitespace()
+        {
+            while (p != end && std::isspace(static_cast<unsigned char>(*p))) {
+                ++p;
+            }
+        }
+
+        bool consume(char c)
+        {
+            skip_whitespace();
+            if (p != end && *p == c) {
+                ++p;
+                return true;
+            }
+            return false;
+        }
+
+        /// Skip a string starting at the opening quote.
+        bool skip_string()
+        {
+            assert(*p == '"');
+            for (++p; p != end; ++p) {
+                if (*p == '\\') {
+                    if (++p == end) {
+                        return false;
+                    }
+                } else if (*p == '"') {
+                    ++p;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool skip_value()
+        {
+            if (p == end) {
+                return false;
+            }
+            if (*p == '"') {
+                return skip_string();
+            }
+            if (*p == '{' || *p == '[') {
+                int depth = 0;
+                while (p != end) {
+                    if (*p == '"') {
+                        if (!skip_string()) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    if (*p == '{' || *p == '[') {
+                        depth++;
+                    } else if ((*p == '}' || *p == ']') && --depth == 0) {
+                        ++p;
+                        return true;
+                    }
+                    ++p;
+                }
+                return false;
+            }
+            // Number, true, false, or null
+            const char* value_begin = p;
+            while (p != end && std::strchr(",}] \t\r\n", *p) == nullptr) {
+                ++p;
+            }
+            return p != value_begin;
+        }
+
+        const char* p;
+        const char* end;
+    };
+} // namespace
+
+bool SimulationResultsReader::open(const std::string& filename)
+{
+    PROFILE_POINT("SimulationResultsReader::open");
+    PROFILE_START();
+
+    m_frames.clear();
+    m_stats = { nullptr, nullptr };
+    m_args = nlohmann::json();
+    m_file.close();
+
+    bool success;
+    m_is_trajectory = is_trajectory_file(filename);
+    if (m_is_trajectory) {
+        success = m_trajectory.open(filename);
+        if (success) {
+            m_args = m_trajectory.metadata().value("args", nlohmann::json());
+            if (!m_args.is_object()) {
+                spdlog::error("Missing args in trajectory file: {}", filename);
+                success = false;
+            }
+        }
+    } else {
+        success = open_json(filename);
+    }
+
+    PROFILE_END();
+    return success;
+}
+
+bool SimulationResultsReader::open_json(const std::string& filename)
+{
+    if (!m_file.open(filename)) {
+        return false;
+    }
+
+    const char *animation_begin = nullptr, *animation_end = nullptr;
+    bool valid = JSONScanner(m_file.begin(), m_file.end())
+                     .for_each_member([&](std::string_view key,
+                                          const char* value_begin,
+                                          const char* value_end) {
+                         if (key == "args") {
+                             m_args = nlohmann::json::parse(
+                                 value_begin, value_end, nullptr, false);
+                         } else if (key == "stats") {
+                             m_stats = { value_begin, value_end };
+                         } else if (key == "animation") {
+                             animation_begin = value_begin;
+                             animation_end = value_end;
+                         }
+                     });
+
+    const char *sequence_begin = nullptr, *sequence_end = nullptr;
+    valid = valid && animation_begin != nullptr
+        && JSONScanner(animation_begin, animation_end)
+               .for_each_member([&](std::string_view key,
+                                    const char* value_begin,
+                                    const char* value_end) {
+                   if (key == "state_sequence") {
+                       sequence_begin = value_begin;
+                       sequence_end = value_end;
+                   }
+               });
+
+    valid = valid && sequence_begin != nullptr
+        && JSONScanner(sequence_begin, sequence_end)
+               .for_each_element(
+                   [&](const char* value_begin, const char* value_end) {
+                       m_frames.emplace_back(value_begin, value_end);
+                   });
+
+    if (!valid || !m_args.is_object()) {
+        spdlog::error("Invalid simulation results JSON file: {}", filename);
+        m_frames.clear();
+        return false;
+    }
+    return true;
+}
+
+nlohmann::json SimulationResultsReader::stats() const
+{
+    if (m_is_trajectory) {
+        const nlohmann::json& metadata = m_trajectory.metadata();
+        return metadata.contains("stats") ? metadata["stats"]
+                                          : nlohmann::json();
+    }
+    if (m_stats.first == nullptr) {
+        return nlohmann::json();
+    }
+    return nlohmann::json::parse(m_stats.first, m_stats.second);
+}
+
+size_t SimulationResultsReader::num_frames() const
+{
+    return m_is_trajectory ? m_trajectory.num_steps() : m_frames.size();
+}
+
+double SimulationResultsReader::timestep() const
+{
+    return m_is_trajectory ? m_trajectory.timestep()
+                           : m_args["timestep"].get<double>();
+}
+
+void SimulationResultsReader::clamp_frame_range(
+    int& first_frame, int& last_frame) const
+{
+    const int num = int(num_frames());
+    first_frame = std::clamp(first_frame, 0, num);
+    if (last_frame < 0 || last_frame >= num) {
+        last_frame = num - 1;
+    }
+}
+
+nlohmann::json SimulationResultsReader::frame_state(size_t i) const
+{
+    assert(i < num_frames());
+    if (m_is_trajectory) {
+        return m_trajectory.read_state(i);
+    }
+    return nlohmann::json::parse(m_frames[i].first, m_frames[i].second);
+}
+
+PosesD SimulationResultsReader::frame_poses(size_t i) const
+{
+    assert(i < num_frames());
+    if (m_is_trajectory) {
+        return m_trajectory.read_poses(i);
+    }
+
+    const nlohmann::json state = frame_state(i);
+    PosesD poses;
+    poses.reserve(state["rigid_bodies"].size());
+    for (const auto& jrb : state["rigid_bodies"]) {
+        VectorMax3d position, rotation;
+        from_json(jrb["position"], position);
+        from_json(jrb["rotation"], rotation);
+        poses.emplace_back(position, rotation);
+    }
+    return poses;
+}
+
+} // namespace ipc::rigid
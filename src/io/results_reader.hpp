@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <io/mapped_file.hpp>
+#include <io/trajectory.hpp>
+#include <physics/pose.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Random access to the frames of saved simulation results.
+///
+/// Reads both results JSON files and binary trajectories. The file is memory
+/// mapped and only the args are parsed when it is opened. For JSON results,
+/// opening only scans the file to find where each frame starts and ends.
+/// Frames are then decoded on demand, so reading a few frames of a long run
+/// does not parse the whole file.
+///
+/// The reader can be shared between threads once it is opened.
+class SimulationResultsReader {
+public:
+    /// @brief Open a results JSON or binary trajectory file.
+    /// @returns true on success, false on errors
+    bool open(const std::string& filename);
+
+    /// @brief Arguments the simulation was run with.
+    const nlohmann::json& args() const { return m_args; }
+    /// @brief Statistics of the simulation (null if they were not saved).
+    nlohmann::json stats() const;
+
+    /// @brief Number of saved frames.
+    size_t num_frames() const;
+    /// @brief Time between frames.
+    double timestep() const;
+
+    /// @brief Clamp an inclusive range of frames to the saved frames.
+    /// @param[in,out] first_frame First frame of the range.
+    /// @param[in,out] last_frame Last frame of the range (negative for the
+    ///                           last saved frame).
+    void clamp_frame_range(int& first_frame, int& last_frame) const;
+
+    /// @brief Decode a frame as a state JSON (see RigidBodyProblem::state()).
+    nlohmann::json frame_state(size_t i) const;
+    /// @brief Decode only the poses of the bodies in a frame.
+    PosesD frame_poses(size_t i) const;
+
+protected:
+    /// @brief Index the frames of a results JSON.
+    bool open_json(const std::string& filename);
+
+    bool m_is_trajectory = false;
+    TrajectoryReader m_trajectory;
+
+    /// @brief Memory map of a results JSON
+    MappedFile m_file;
+    /// @brief Byte range of each frame's state in the JSON
+    std::vector<std::pair<const char*, const char*>> m_frames;
+    /// @brief Byte range of the stats in the JSON
+    std::pair<const char*, const char*> m_stats = { nullptr, nullptr };
+
+    nlohmann::json m_args;
+};
+
+} // namespace ipc::rigid
@@ -0,0 +1,287 @@
+#include "state_history.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <random>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <logger.hpp>
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+namespace {
+    /// @brief Create a new empty file with a unique name in the temporary
+    /// directory.
+    /// @returns The path of the file, or an empty string on errors.
+    std::string create_temporary_file()
+    {
+        std::error_code ec;
+        const fs::path dir = fs::temp_directory_path(ec);
+        if (ec) {
+            return "";
+        }
+        std::random_device rd;
+        for (int i = 0; i < 100; i++) {
+            const std::string name = fmt::format(
+                "rigid_ipc_states_{:08x}{:08x}.jsonl", rd(), rd());
+            const std::string filename = (dir / name).string();
+            // Exclusive creation ("x") fails if the path exists, even as a
+            // symbolic link, so no existing file is ever overwritten.
+            if (std::FILE* file = std::fopen(filename.c_str(), "wbx")) {
+                std::fclose(file);
+                return filename;
+            }
+            if (errno != EEXIST) {
+                break;
+            }
+        }
+        return "";
+    }
+
+    /// @brief Line of the i-th state in the array of states.
+    std::string state_line(size_t i, const std::string& state)
+    {
+        return (i > 0 ? "," : "") + state + "\n";
+    }
+} // namespace
+
+StateHistory::StateHistory(size_t window_size)
+    : m_window_size(std::max(window_size, size_t(1)))
+    , m_size(0)
+    , m_filename(create_temporary_file())
+    , m_is_temporary(true)
+    , m_file_size(0)
+{
+    if (m_filename.empty()) {
+        spdlog::error(
+            "Unable to create a state history file; keeping all states in "
+            "memory");
+    } else {
+        open();
+    }
+}
+
+StateHistory::~StateHistory()
+{
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    if (m_is_temporary && !m_filename.empty()) {
+        std::error_code ec;
+        fs::remove(m_filename, ec);
+    }
+}
+
+void StateHistory::open()
+{
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_offsets.assign(1, std::streamoff(m_header.size() + 2));
+    m_file_size = m_offsets.back();
+    m_file.open(
+        m_filename,
+        std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+    if (m_file) {
+        m_file << m_header << "[\n";
+        m_file.flush();
+    }
+    if (!m_file) {
+        spdlog::error(
+            "Unable to open state history file {}; keeping all states in "
+            "memory",
+            m_filename);
+        m_file.close();
+    }
+}
+
+void StateHistory::clear()
+{
+    m_size = 0;
+    m_window.clear();
+    if (!m_filename.empty()) {
+        open();
+    }
+}
+
+void StateHistory::push_back(const nlohmann::json& state)
+{
+    PROFILE_POINT("StateHistory::push_back");
+    PROFILE_START();
+
+    if (m_file.is_open()) {
+        const std::string line = state_line(m_size, state.dump());
+        m_file.seekp(m_offsets.back());
+        m_file << line;
+        // Flush so the state is on disk as soon as the step completes
+        m_file.flush();
+        m_offsets.push_back(m_offsets.back() + line.size());
+        if (m_file_size > m_offsets.back()) {
+            // Drop what is left of the footer
+            truncate(m_offsets.back());
+        }
+        m_file_size = m_offsets.back();
+    }
+
+    m_window.push_back(state);
+    if (m_file.is_open() && m_window.size() > m_window_size) {
+        m_window.pop_front();
+    }
+    m_size++;
+
+    PROFILE_END();
+}
+
+std::string StateHistory::read(size_t i) const
+{
+    assert(m_file.is_open() && i < m_size);
+    // Do not count the comma and the new line
+    const std::streamoff start = m_offsets[i] + (i > 0);
+    std::string line(m_offsets[i + 1] - start - 1, '\0');
+    m_file.seekg(start);
+    m_file.read(&line[0], line.size());
+    return line;
+}
+
+nlohmann::json StateHistory::operator[](size_t i) const
+{
+    assert(i < m_size);
+    const size_t window_start = m_size - m_window.size();
+    if (i >= window_start) {
+        return m_window[i - window_start];
+    }
+    return nlohmann::json::parse(read(i));
+}
+
+const nlohmann::json& StateHistory::back() const
+{
+    assert(!m_window.empty());
+    return m_window.back();
+}
+
+void StateHistory::copy_states(std::ostream& out) const
+{
+    assert(m_file.is_open());
+    std::vector<char> buffer(1 << 20);
+    m_file.seekg(m_offsets.front());
+    for (std::streamoff remaining = m_offsets.back() - m_offsets.front();
+         remaining > 0;) {
+        const std::streamsize count =
+            std::min(remaining, std::streamoff(buffer.size()));
+        m_file.read(buffer.data(), count);
+        out.write(buffer.data(), count);
+        remaining -= count;
+    }
+}
+
+void StateHistory::write_json_array(std::ostream& out) const
+{
+    PROFILE_POINT("StateHistory::write_json_array");
+    PROFILE_START();
+
+    out << "[\n";
+    if (m_file.is_open()) {
+        // Every state is already serialized on disk
+        copy_states(out);
+    } else {
+        for (size_t i = 0; i < m_size; i++) {
+            out << state_line(i, m_window[i].dump());
+        }
+    }
+    out << ']';
+
+    PROFILE_END();
+}
+
+bool StateHistory::stream_to(
+    const std::string& filename, const std::string& header)
+{
+    PROFILE_POINT("StateHistory::stream_to");
+    PROFILE_START();
+
+    std::fstream file(
+        filename,
+        std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file) {
+        spdlog::error("Unable to open state history file {}", filename);
+        PROFILE_END();
+        return false;
+    }
+    file << header;
+    write_json_array(file);
+    file.flush();
+    if (!file) {
+        spdlog::error("Unable to write state history file {}", filename);
+        PROFILE_END();
+        return false;
+    }
+
+    // The lines are the same, only shifted by the size of the headers
+    const std::streamoff shift =
+        std::streamoff(header.size()) - std::streamoff(m_header.size());
+    if (m_file.is_open()) {
+        for (std::streamoff& offset : m_offsets) {
+            offset += shift;
+        }
+    } else {
+        m_offsets.assign(1, std::streamoff(header.size() + 2));
+        for (size_t i = 0; i < m_size; i++) {
+            m_offsets.push_back(
+                m_offsets.back() + state_line(i, m_window[i].dump()).size());
+        }
+        while (m_window.size() > m_window_size) {
+            m_window.pop_front();
+        }
+    }
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    if (m_is_temporary && !m_filename.empty()) {
+        std::error_code ec;
+        fs::remove(m_filename, ec);
+    }
+    m_file = std::move(file);
+    m_filename = filename;
+    m_is_temporary = false;
+    m_header = header;
+    // Drop the closing bracket, so the next state is appended
+    truncate(m_offsets.back());
+    m_file_size = m_offsets.back();
+
+    PROFILE_END();
+    return true;
+}
+
+bool StateHistory::finish(const std::string& footer)
+{
+    if (!m_file.is_open()) {
+        return false;
+    }
+    m_file.seekp(m_offsets.back());
+    m_file << ']' << footer;
+    m_file.flush();
+    const std::streamoff size = m_offsets.back() + 1 + footer.size();
+    if (m_file_size > size) {
+        truncate(size);
+    }
+    m_file_size = size;
+    return bool(m_file);
+}
+
+void StateHistory::truncate(std::streamoff size)
+{
+    m_file.flush();
+    std::error_code ec;
+    fs::resize_file(m_filename, size, ec);
+    if (ec) {
+        spdlog::warn(
+            "Unable to truncate state history file {}: {}", m_filename,
+            ec.message());
+    }
+}
+
+} // namespace ipc::rigid
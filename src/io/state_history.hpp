@@ -0,0 +1,100 @@
+#pragma once
+
+#include <deque>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Sequence of simulation states streamed to disk.
+///
+/// Each state is appended to a file as soon as it is pushed, and only the
+/// most recent states are kept in memory. Older states are read back from the
+/// file on access. If the file cannot be created, all states are kept in
+/// memory instead.
+///
+/// The file holds a header, then the states as a JSON array with one state
+/// per line, and, once finish() is called, a footer. By default it is a
+/// private temporary file removed with the history. stream_to() moves the
+/// states to a file that is kept (e.g., the results file), so the states
+/// written before a crash can still be read from it.
+///
+/// Accessing a state moves the file's read position, so a history must not be
+/// read from multiple threads at once.
+class StateHistory {
+public:
+    /// @param window_size Number of most recent states kept in memory.
+    explicit StateHistory(size_t window_size = 64);
+    ~StateHistory();
+
+    StateHistory(const StateHistory&) = delete;
+    StateHistory& operator=(const StateHistory&) = delete;
+
+    /// @brief Remove all states and truncate the file (keeping its header).
+    void clear();
+
+    /// @brief Append a state to the end of the history.
+    ///
+    /// The state overwrites the footer if one was written.
+    void push_back(const nlohmann::json& state);
+
+    /// @brief Number of states in the history.
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /// @brief Get the i-th state (read from disk if it is not in memory).
+    nlohmann::json operator[](size_t i) const;
+    /// @brief Get the last state.
+    const nlohmann::json& back() const;
+
+    /// @brief Write the states as a JSON array without parsing them.
+    void write_json_array(std::ostream& out) const;
+
+    /// @brief Move the states to a new file that is kept after the history.
+    ///
+    /// The file is created (or truncated) and starts with the given header.
+    /// @returns true on success, false if the file cannot be written (the
+    ///          states then stay where they were)
+    bool stream_to(const std::string& filename, const std::string& header);
+
+    /// @brief Close the array of states and write a footer after it.
+    /// @returns true on success, false if the states are not in a file
+    bool finish(const std::string& footer);
+
+    /// @brief Path of the file the states are streamed to.
+    const std::string& filename() const { return m_filename; }
+
+protected:
+    /// @brief Create (or truncate) the backing file and write the header.
+    void open();
+
+    /// @brief Read the serialized i-th state from the file.
+    std::string read(size_t i) const;
+
+    /// @brief Copy the lines of all states from the file.
+    void copy_states(std::ostream& out) const;
+
+    /// @brief Drop the end of the file after the given size.
+    void truncate(std::streamoff size);
+
+    size_t m_window_size;
+    size_t m_size;
+    std::string m_filename;
+    /// @brief Remove the file with the history?
+    bool m_is_temporary;
+    /// @brief Text written before the array of states.
+    std::string m_header;
+    mutable std::fstream m_file;
+    /// @brief Size of the file including the footer.
+    std::streamoff m_file_size;
+    /// @brief Offset of the start of each line in the file, plus the end.
+    std::vector<std::streamoff> m_offsets;
+    /// @brief The most recent states (all states if the file is not open).
+    std::deque<nlohmann::json> m_window;
+};
+
+} // namespace ipc::rigid
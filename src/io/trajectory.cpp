@@ -0,0 +1,307 @@
+#include "trajectory.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#include <io/serialize_json.hpp>
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+namespace {
+    constexpr char TRAJECTORY_MAGIC[8] = { 'R', 'I', 'P', 'C',
+                                           'T', 'R', 'A', 'J' };
+    constexpr char TRAILER_MAGIC[8] = { 'R', 'I', 'P', 'C',
+                                        'T', 'E', 'N', 'D' };
+    constexpr uint32_t TRAJECTORY_VERSION = 2;
+    /// Bytes after the trailer JSON (its size and the magic)
+    constexpr size_t TRAILER_FOOTER_SIZE =
+        sizeof(uint64_t) + sizeof(TRAILER_MAGIC);
+} // namespace
+
+static_assert(sizeof(TrajectoryHeader) == 56, "Header must not be padded");
+
+size_t TrajectoryHeader::pose_block_size() const
+{
+    return num_bodies * PoseD::dim_to_ndof(dim);
+}
+
+size_t TrajectoryHeader::step_size() const { return pose_block_size(); }
+
+size_t TrajectoryHeader::data_offset() const
+{
+    return sizeof(TrajectoryHeader) + metadata_size;
+}
+
+bool is_trajectory_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(TRAJECTORY_MAGIC)];
+    return file.read(magic, sizeof(magic))
+        && std::memcmp(magic, TRAJECTORY_MAGIC, sizeof(magic)) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Writer
+
+bool TrajectoryWriter::open(
+    const std::string& filename,
+    int dim,
+    size_t num_bodies,
+    double timestep,
+    const nlohmann::json& metadata,
+    bool single_precision)
+{
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        spdlog::error("Unable to open trajectory file {}", filename);
+        return false;
+    }
+
+    const std::string metadata_str = metadata.dump();
+
+    std::memset(&m_header, 0, sizeof(m_header));
+    std::memcpy(m_header.magic, TRAJECTORY_MAGIC, sizeof(m_header.magic));
+    m_header.version = TRAJECTORY_VERSION;
+    m_header.dim = dim;
+    m_header.num_bodies = num_bodies;
+    m_header.num_steps = 0;
+    m_header.scalar_size = single_precision ? sizeof(float) : sizeof(double);
+    m_header.timestep = timestep;
+    m_header.metadata_size = metadata_str.size();
+    m_last_state = nullptr;
+    m_step_values = nlohmann::json::object();
+
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_file.write(metadata_str.data(), metadata_str.size());
+    return bool(m_file);
+}
+
+bool TrajectoryWriter::write_step(const nlohmann::json& state)
+{
+    assert(m_file.is_open());
+    const auto& jrbs = state["rigid_bodies"];
+    assert(jrbs.size() == m_header.num_bodies);
+    const int ndof = PoseD::dim_to_ndof(m_header.dim);
+
+    Eigen::VectorXd values(m_header.step_size());
+    size_t i = 0;
+    for (const auto& jrb : jrbs) {
+        VectorMax3d position, rotation;
+        from_json(jrb["position"], position);
+        from_json(jrb["rotation"], rotation);
+        values.segment(i * ndof, ndof) << position, rotation;
+        i++;
+    }
+
+    if (m_header.scalar_size == sizeof(float)) {
+        Eigen::VectorXf values_f = values.cast<float>();
+        m_file.write(
+            reinterpret_cast<const char*>(values_f.data()),
+            values_f.size() * sizeof(float));
+    } else {
+        m_file.write(
+            reinterpret_cast<const char*>(values.data()),
+            values.size() * sizeof(double));
+    }
+
+    // Keep the other fields of the state (e.g., energies and momenta) for the
+    // trailer. Fields missing from some steps are null in those steps.
+    for (const auto& [key, value] : state.items()) {
+        if (key == "rigid_bodies") {
+            continue;
+        }
+        nlohmann::json& key_values = m_step_values[key];
+        while (key_values.size() < m_header.num_steps) {
+            key_values.push_back(nullptr);
+        }
+        key_values.push_back(value);
+    }
+    m_last_state = state;
+
+    m_header.num_steps++;
+    return bool(m_file);
+}
+
+bool TrajectoryWriter::close()
+{
+    for (auto& [key, key_values] : m_step_values.items()) {
+        while (key_values.size() < m_header.num_steps) {
+            key_values.push_back(nullptr);
+        }
+    }
+
+    nlohmann::json trailer;
+    trailer["final_state"] = m_last_state;
+    trailer["step_values"] = m_step_values;
+    const std::string trailer_str = trailer.dump();
+    const uint64_t trailer_size = trailer_str.size();
+    m_file.write(trailer_str.data(), trailer_str.size());
+    m_file.write(
+        reinterpret_cast<const char*>(&trailer_size), sizeof(trailer_size));
+    m_file.write(TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+
+    // The header records the number of steps as a consistency check
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    const bool success = bool(m_file);
+    m_file.close();
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reader
+
+bool TrajectoryReader::open(const std::string& filename)
+{
+    if (!m_file.open(filename)) {
+        return false;
+    }
+
+    if (m_file.size() < sizeof(m_header)
+        || std::memcmp(m_file.data(), TRAJECTORY_MAGIC, sizeof(m_header.magic))
+            != 0) {
+        spdlog::error("Invalid trajectory file {}", filename);
+        return false;
+    }
+    std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+    if (m_header.version != TRAJECTORY_VERSION
+        || (m_header.dim != 2 && m_header.dim != 3)
+        || (m_header.scalar_size != sizeof(float)
+            && m_header.scalar_size != sizeof(double))
+        || m_file.size() < m_header.data_offset()) {
+        spdlog::error(
+            "Unsupported trajectory file {} (version={:d} dim={:d} "
+            "scalar_size={:d})",
+            filename, m_header.version, m_header.dim, m_header.scalar_size);
+        return false;
+    }
+
+    m_metadata = nlohmann::json::parse(
+        m_file.begin() + sizeof(m_header),
+        m_file.begin() + m_header.data_offset(), nullptr, false);
+    if (m_metadata.is_discarded()) {
+        spdlog::error("Invalid trajectory metadata in {}", filename);
+        return false;
+    }
+
+    const size_t steps_end = read_trailer(filename);
+    if (steps_end == 0) {
+        return false;
+    }
+
+    // Derive the number of steps from the file size, so the complete steps of
+    // a file that was never closed can be read.
+    const size_t step_bytes = m_header.step_size() * m_header.scalar_size;
+    const size_t steps_bytes = steps_end - m_header.data_offset();
+    const size_t num_steps = step_bytes == 0 ? 0 : steps_bytes / step_bytes;
+    if (is_complete()) {
+        if (num_steps != m_header.num_steps
+            || num_steps * step_bytes != steps_bytes) {
+            spdlog::error(
+                "Corrupt trajectory file {} ({:d} steps stored but {:d} "
+                "recorded)",
+                filename, num_steps, m_header.num_steps);
+            return false;
+        }
+    } else {
+        spdlog::warn(
+            "Trajectory file {} was not closed, so only the poses of its "
+            "{:d} complete steps are available",
+            filename, num_steps);
+    }
+    m_header.num_steps = num_steps;
+    return true;
+}
+
+size_t TrajectoryReader::read_trailer(const std::string& filename)
+{
+    m_is_complete = false;
+    m_final_state = nullptr;
+    m_step_values = nlohmann::json::object();
+
+    const size_t size = m_file.size();
+    if (size < m_header.data_offset() + TRAILER_FOOTER_SIZE
+        || std::memcmp(
+               m_file.data() + size - sizeof(TRAILER_MAGIC), TRAILER_MAGIC,
+               sizeof(TRAILER_MAGIC))
+            != 0) {
+        return size; // No trailer
+    }
+
+    uint64_t trailer_size;
+    std::memcpy(
+        &trailer_size, m_file.data() + size - TRAILER_FOOTER_SIZE,
+        sizeof(trailer_size));
+    if (trailer_size > size - m_header.data_offset() - TRAILER_FOOTER_SIZE) {
+        spdlog::error("Invalid trajectory trailer in {}", filename);
+        return 0;
+    }
+    const size_t trailer_start = size - TRAILER_FOOTER_SIZE - trailer_size;
+
+    nlohmann::json trailer = nlohmann::json::parse(
+        m_file.begin() + trailer_start,
+        m_file.begin() + trailer_start + trailer_size, nullptr, false);
+    if (trailer.is_discarded() || !trailer.is_object()) {
+        spdlog::error("Invalid trajectory trailer in {}", filename);
+        return 0;
+    }
+    m_is_complete = true;
+    m_final_state = trailer["final_state"];
+    if (trailer["step_values"].is_object()) {
+        m_step_values = trailer["step_values"];
+    }
+    return trailer_start;
+}
+
+Eigen::VectorXd
+TrajectoryReader::read(size_t step, size_t offset, size_t count) const
+{
+    assert(step < num_steps() && offset + count <= m_header.step_size());
+    const size_t scalar_size = m_header.scalar_size;
+    // The data is not aligned, so copy it instead of mapping it.
+    const char* data = m_file.data() + m_header.data_offset()
+        + (step * m_header.step_size() + offset) * scalar_size;
+
+    if (scalar_size == sizeof(float)) {
+        Eigen::VectorXf values(count);
+        std::memcpy(values.data(), data, count * sizeof(float));
+        return values.cast<double>();
+    }
+    Eigen::VectorXd values(count);
+    std::memcpy(values.data(), data, count * sizeof(double));
+    return values;
+}
+
+PosesD TrajectoryReader::read_poses(size_t step) const
+{
+    return PoseD::dofs_to_poses(
+        read(step, 0, m_header.pose_block_size()), dim());
+}
+
+nlohmann::json TrajectoryReader::read_state(size_t step) const
+{
+    assert(step < num_steps());
+    if (step + 1 == num_steps() && !m_final_state.is_null()) {
+        return m_final_state;
+    }
+
+    const PosesD poses = read_poses(step);
+    std::vector<nlohmann::json> rbs(poses.size());
+    for (size_t i = 0; i < poses.size(); i++) {
+        rbs[i]["position"] = to_json(Eigen::VectorXd(poses[i].position));
+        rbs[i]["rotation"] = to_json(Eigen::VectorXd(poses[i].rotation));
+    }
+
+    nlohmann::json state;
+    state["rigid_bodies"] = rbs;
+    for (const auto& [key, key_values] : m_step_values.items()) {
+        if (step < key_values.size()) {
+            state[key] = key_values[step];
+        }
+    }
+    return state;
+}
+
+} // namespace ipc::rigid
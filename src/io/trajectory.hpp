@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include <Eigen/Core>
+#include <nlohmann/json.hpp>
+
+#include <io/mapped_file.hpp>
+#include <physics/pose.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Fixed size header of a binary trajectory file.
+///
+/// A trajectory file is laid out as:
+///   1. this header,
+///   2. metadata_size bytes of JSON metadata (e.g., args and stats),
+///   3. fixed size step records of float64 (or float32) values,
+///   4. a trailer written when the file is closed: JSON with the full final
+///      state ("final_state") and the per-step values of the state outside
+///      of "rigid_bodies" ("step_values", e.g., energies and momenta),
+///      followed by the size of the JSON (uint64) and the magic "RIPCTEND".
+///
+/// Each step record is a flat array of the poses of every body (position then
+/// rotation). Velocities and other per-body fields are only kept in the final
+/// state. Values are stored in the native byte order.
+///
+/// The number of steps is derived from the file size, so the complete steps
+/// of a file that was never closed (e.g., a crashed run) can still be read.
+/// Such a file has no velocities, so a simulation cannot resume from it.
+struct TrajectoryHeader {
+    char magic[8];          ///< "RIPCTRAJ"
+    uint32_t version;       ///< file format version
+    uint32_t dim;           ///< dimension of the scene (2 or 3)
+    uint64_t num_bodies;    ///< number of rigid bodies
+    uint64_t num_steps;     ///< number of step records (set when closed)
+    uint32_t scalar_size;   ///< 8 for float64 and 4 for float32 values
+    uint32_t reserved;      ///< unused (zero)
+    double timestep;        ///< time between steps
+    uint64_t metadata_size; ///< size of the JSON metadata in bytes
+
+    /// @brief Number of scalars of the poses of a step.
+    size_t pose_block_size() const;
+    /// @brief Number of scalars of a step record.
+    size_t step_size() const;
+    /// @brief Byte offset of the first step record.
+    size_t data_offset() const;
+};
+
+/// @brief Check if a file starts with the trajectory file magic.
+bool is_trajectory_file(const std::string& filename);
+
+/// @brief Write a sequence of rigid body states to a binary trajectory file.
+class TrajectoryWriter {
+public:
+    /// @brief Create the file and write the header and metadata.
+    /// @param single_precision Store values as float32 instead of float64.
+    /// @returns true on success, false on errors
+    bool open(
+        const std::string& filename,
+        int dim,
+        size_t num_bodies,
+        double timestep,
+        const nlohmann::json& metadata,
+        bool single_precision = false);
+
+    /// @brief Append a state (as returned by RigidBodyProblem::state()).
+    bool write_step(const nlohmann::json& state);
+
+    /// @brief Write the trailer and the number of steps, and close the file.
+    bool close();
+
+protected:
+    std::ofstream m_file;
+    TrajectoryHeader m_header;
+    /// @brief Last state written (saved in full in the trailer)
+    nlohmann::json m_last_state;
+    /// @brief Values of each state field outside of "rigid_bodies" per step
+    nlohmann::json m_step_values;
+};
+
+/// @brief Random access to the steps of a binary trajectory file.
+///
+/// The file is memory mapped and steps are decoded on demand, so only the
+/// pages of the steps read are loaded. A reader can be shared between threads.
+class TrajectoryReader {
+public:
+    /// @brief Open a file and read its header and metadata.
+    /// @returns true on success, false on errors
+    bool open(const std::string& filename);
+
+    int dim() const { return m_header.dim; }
+    size_t num_bodies() const { return m_header.num_bodies; }
+    size_t num_steps() const { return m_header.num_steps; }
+    double timestep() const { return m_header.timestep; }
+    const nlohmann::json& metadata() const { return m_metadata; }
+
+    /// @brief Read only the poses of a step.
+    PosesD read_poses(size_t step) const;
+
+    /// @brief Read a step as a state JSON (see RigidBodyProblem::state()).
+    ///
+    /// The last step of a closed file is the full saved state. Other steps
+    /// only have the poses of the bodies and the per-step values (e.g.,
+    /// energies and momenta).
+    nlohmann::json read_state(size_t step) const;
+
+    /// @brief Was the file closed (i.e., does it have a trailer)?
+    bool is_complete() const { return m_is_complete; }
+
+protected:
+    /// @brief Read the trailer at the end of the file if there is one.
+    /// @returns The byte offset of the end of the step records, or zero on
+    ///          errors.
+    size_t read_trailer(const std::string& filename);
+
+    /// @brief Read count scalars of a step starting at scalar offset.
+    Eigen::VectorXd read(size_t step, size_t offset, size_t count) const;
+
+    MappedFile m_file;
+    TrajectoryHeader m_header;
+    nlohmann::json m_metadata;
+    bool m_is_complete = false;
+    /// @brief Full state of the last step (null if the file was not closed)
+    nlohmann::json m_final_state;
+    /// @brief Values of each state field outside of "rigid_bodies" per step
+    nlohmann::json m_step_values;
+};
+
+} // namespace ipc::rigid
@@ -43,9 +43,14 @@ int main(int argc, char* argv[])
     std::string output_name = "sim.json";
     app.add_option(
            "-f,--output-name", output_name,
-           "name for simulation file (ngui only)")
+           "name for simulation file (.json or binary .traj) (ngui only)")
         ->default_val(output_name);
 
+    bool single_precision = false;
+    app.add_flag(
+        "--single-precision", single_precision,
+        "save .traj values as float32 (ngui only)");
+
     int num_steps = -1;
     app.add_option(
         "--num-steps", num_steps, "number of time-steps (ngui only)");
@@ -127,6 +132,8 @@ int main(int argc, char* argv[])
             sim.m_checkpoint_frequency = checkpoint_freq;
         }
 
+        sim.m_save_single_precision = single_precision;
+
         sim.run_simulation(fout);
     }
 }
@@ -1,7 +1,10 @@
 #include "distance_barrier_constraint.hpp"
 
-#include <mutex>
+#include <atomic>
+#include <numeric>
+
 #include <tbb/parallel_for_each.h>
+#include <tbb/parallel_sort.h>
 
 #include <igl/slice_mask.h>
 #include <ipc/ipc.hpp>
@@ -28,6 +31,8 @@ DistanceBarrierConstraint::DistanceBarrierConstraint(const std::string& name)
     , barrier_type(BarrierType::IPC)
     , minimum_separation_distance(0.0)
     , m_barrier_activation_distance(0.0)
+    , m_cached_inflation_radius(-1)
+    , m_constraint_set_dhat(-1)
 {
 }
 
@@ -53,6 +58,7 @@ nlohmann::json DistanceBarrierConstraint::settings() const
 void DistanceBarrierConstraint::initialize()
 {
     m_barrier_activation_distance = initial_barrier_activation_distance;
+    clear_candidate_cache();
     CollisionConstraint::initialize();
 }
 
@@ -134,15 +140,42 @@ double DistanceBarrierConstraint::compute_earliest_toi(
 {
     PROFILE_POINT("DistanceBarrierConstraint::compute_earliest_toi");
     PROFILE_START();
-    // This function will profile itself
-    Candidates candidates;
-    detect_collision_candidates(
-        bodies, poses_t0, poses_t1, dim_to_collision_type(bodies.dim()),
-        candidates, detection_method, trajectory_type,
-        /*inflation_radius=*/minimum_separation_distance / 2.0);
+
+    if (trajectory_type == TrajectoryType::LINEAR) {
+        // This function will profile itself
+        Candidates candidates;
+        detect_collision_candidates(
+            bodies, poses_t0, poses_t1, dim_to_collision_type(bodies.dim()),
+            candidates, detection_method, trajectory_type,
+            /*inflation_radius=*/minimum_separation_distance / 2.0);
+
+        double earliest_toi = compute_earliest_toi_narrow_phase(
+            bodies, poses_t0, poses_t1, candidates);
+        PROFILE_END();
+        return earliest_toi;
+    }
+
+    // The other trajectories interpolate the poses linearly, so the poses
+    // of every step of a line search lie on this trajectory. Inflating the
+    // trajectory's candidates by d̂ gives a superset of both the CCD
+    // candidates and the candidates of any of those steps.
+    const double inflation_radius =
+        (m_barrier_activation_distance + minimum_separation_distance) / 2.0;
+    if (m_cached_inflation_radius != inflation_radius
+        || poses_t0 != m_cached_poses_t0 || poses_t1 != m_cached_poses_t1) {
+        // This function will profile itself
+        m_cached_candidates = Candidates();
+        detect_collision_candidates(
+            bodies, poses_t0, poses_t1, dim_to_collision_type(bodies.dim()),
+            m_cached_candidates, detection_method, trajectory_type,
+            inflation_radius);
+        m_cached_poses_t0 = poses_t0;
+        m_cached_poses_t1 = poses_t1;
+        m_cached_inflation_radius = inflation_radius;
+    }
 
     double earliest_toi = compute_earliest_toi_narrow_phase(
-        bodies, poses_t0, poses_t1, candidates);
+        bodies, poses_t0, poses_t1, m_cached_candidates);
     PROFILE_END();
 
     return earliest_toi;
@@ -173,27 +206,82 @@ double DistanceBarrierConstraint::compute_earliest_toi_narrow_phase(
 
     PROFILE_START(NARROW_PHASE);
 
-    int collision_count = 0;
-    double earliest_toi = 1;
-    std::mutex earliest_toi_mutex;
+    // The earliest time of impact found so far. Every query reads the
+    // current value so the root finders only search [0, earliest_toi].
+    std::atomic<int> collision_count(0), culled_count(0);
+    std::atomic<double> earliest_toi(1);
 
     const size_t num_ev = candidates.ev_candidates.size();
     const size_t num_ee = candidates.ee_candidates.size();
     const size_t num_fv = candidates.fv_candidates.size();
 
+    // Order of the candidates to check
+    std::vector<int> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // Conservative lower bound on the time of impact of each candidate. The
+    // candidates are checked in increasing order of their bound, so early
+    // impacts are found first and shrink the search of later queries, and
+    // candidates that provably cannot collide before the earliest time of
+    // impact found so far are skipped.
+    std::vector<double> toi_lower_bounds;
+    if (trajectory_type == TrajectoryType::RIGID
+        || trajectory_type == TrajectoryType::PIECEWISE_LINEAR) {
+        toi_lower_bounds.resize(candidates.size());
+        tbb::parallel_for(size_t(0), candidates.size(), [&](size_t i) {
+            if (i < num_ev) {
+                toi_lower_bounds[i] = edge_vertex_toi_lower_bound(
+                    bodies, poses_t0, poses_t1, candidates.ev_candidates[i],
+                    minimum_separation_distance);
+            } else if (i - num_ev < num_ee) {
+                toi_lower_bounds[i] = edge_edge_toi_lower_bound(
+                    bodies, poses_t0, poses_t1,
+                    candidates.ee_candidates[i - num_ev],
+                    minimum_separation_distance);
+            } else {
+                toi_lower_bounds[i] = face_vertex_toi_lower_bound(
+                    bodies, poses_t0, poses_t1,
+                    candidates.fv_candidates[i - num_ev - num_ee],
+                    minimum_separation_distance);
+            }
+        });
+
+        // Candidates that cannot collide in the time-step are culled here
+        order.erase(
+            std::remove_if(
+                order.begin(), order.end(),
+                [&](int i) { return toi_lower_bounds[i] >= 1; }),
+            order.end());
+        culled_count = int(candidates.size() - order.size());
+
+        tbb::parallel_sort(order.begin(), order.end(), [&](int i, int j) {
+            return toi_lower_bounds[i] < toi_lower_bounds[j]
+                || (toi_lower_bounds[i] == toi_lower_bounds[j] && i < j);
+        });
+    }
+
     // Do a single block range over all three candidate vectors
     tbb::parallel_for(
-        tbb::blocked_range<int>(0, candidates.size()),
-        [&](tbb::blocked_range<int> r) {
-            for (int i = r.begin(); i < r.end(); i++) {
+        tbb::blocked_range<size_t>(0, order.size()),
+        [&](tbb::blocked_range<size_t> r) {
+            for (size_t k = r.begin(); k < r.end(); k++) {
+                const int i = order[k];
                 double toi = std::numeric_limits<double>::infinity();
                 bool are_colliding;
+                const double current_earliest_toi =
+                    earliest_toi.load(std::memory_order_relaxed);
+
+                if (!toi_lower_bounds.empty()
+                    && toi_lower_bounds[i] >= current_earliest_toi) {
+                    culled_count++;
+                    continue;
+                }
 
                 if (i < num_ev) {
                     // PROFILE_START(EV_NARROW_PHASE);
                     are_colliding = edge_vertex_ccd(
                         bodies, poses_t0, poses_t1, candidates.ev_candidates[i],
-                        toi, trajectory_type, earliest_toi,
+                        toi, trajectory_type, current_earliest_toi,
                         minimum_separation_distance);
                     // PROFILE_END(EV_NARROW_PHASE);
                 } else if (i - num_ev < num_ee) {
@@ -201,7 +289,7 @@ double DistanceBarrierConstraint::compute_earliest_toi_narrow_phase(
                     are_colliding = edge_edge_ccd(
                         bodies, poses_t0, poses_t1,
                         candidates.ee_candidates[i - num_ev], toi,
-                        trajectory_type, earliest_toi,
+                        trajectory_type, current_earliest_toi,
                         minimum_separation_distance);
                     // PROFILE_END(EE_NARROW_PHASE);
                 } else {
@@ -210,7 +298,7 @@ double DistanceBarrierConstraint::compute_earliest_toi_narrow_phase(
                     are_colliding = face_vertex_ccd(
                         bodies, poses_t0, poses_t1,
                         candidates.fv_candidates[i - num_ev - num_ee], toi,
-                        trajectory_type, earliest_toi,
+                        trajectory_type, current_earliest_toi,
                         minimum_separation_distance);
                     // PROFILE_END(FV_NARROW_PHASE);
                 }
@@ -236,32 +324,39 @@ double DistanceBarrierConstraint::compute_earliest_toi_narrow_phase(
                 }
 
                 if (are_colliding) {
-                    std::scoped_lock lock(earliest_toi_mutex);
                     collision_count++;
-                    if (toi < earliest_toi) {
-                        earliest_toi = toi;
-                    }
+                    // Atomic min: retry until toi is stored or a smaller
+                    // value has been found by another thread.
+                    double prev_earliest_toi =
+                        earliest_toi.load(std::memory_order_relaxed);
+                    while (toi < prev_earliest_toi
+                           && !earliest_toi.compare_exchange_weak(
+                               prev_earliest_toi, toi,
+                               std::memory_order_relaxed)) { }
                 }
             }
         });
 
+    const int num_collisions = collision_count.load();
+    const int num_culled = culled_count.load();
     double percent_correct = candidates.size() == 0
         ? 100
-        : (double(collision_count) / candidates.size() * 100);
+        : (double(num_collisions) / candidates.size() * 100);
     PROFILE_MESSAGE(
-        NARROW_PHASE, "num_candidates,num_collisions,percentage",
+        NARROW_PHASE, "num_candidates,num_culled,num_collisions,percentage",
         fmt::format(
-            "{:d},{:d},{:g}%", candidates.size(), collision_count,
-            percent_correct));
+            "{:d},{:d},{:d},{:g}%", candidates.size(), num_culled,
+            num_collisions, percent_correct));
 
     spdlog::debug(
-        "num_candidates={:d} num_collisions={:d} percentage={:g}%",
-        candidates.size(), collision_count, percent_correct);
+        "num_candidates={:d} num_culled={:d} num_collisions={:d} "
+        "percentage={:g}%",
+        candidates.size(), num_culled, num_collisions, percent_correct);
 
     PROFILE_END(NARROW_PHASE);
 
-    return collision_count ? earliest_toi
-                           : std::numeric_limits<double>::infinity();
+    return num_collisions ? earliest_toi.load()
+                          : std::numeric_limits<double>::infinity();
 }
 
 void DistanceBarrierConstraint::construct_constraint_set(
@@ -269,15 +364,13 @@ void DistanceBarrierConstraint::construct_constraint_set(
     const PosesD& poses,
     Constraints& constraint_set) const
 {
-    static PosesD cached_poses;
-    static Constraints cached_constraint_set;
-
     if (bodies.num_bodies() <= 1) {
         return;
     }
 
-    if (poses == cached_poses) {
-        constraint_set = cached_constraint_set;
+    if (poses == m_constraint_set_poses
+        && m_barrier_activation_distance == m_constraint_set_dhat) {
+        constraint_set = m_cached_constraint_set;
         return;
     }
 
@@ -288,21 +381,61 @@ void DistanceBarrierConstraint::construct_constraint_set(
     const double& dmin = minimum_separation_distance;
     const double inflation_radius = (dhat + dmin) / 2.0;
 
+    // Reuse the candidates of the last CCD trajectory if it contains poses
     Candidates candidates;
-    detect_collision_candidates_rigid(
-        bodies, poses, dim_to_collision_type(bodies.dim()), candidates,
-        detection_method, inflation_radius);
+    const bool use_cached_candidates =
+        is_covered_by_cached_candidates(poses, inflation_radius);
+    if (!use_cached_candidates) {
+        detect_collision_candidates_rigid(
+            bodies, poses, dim_to_collision_type(bodies.dim()), candidates,
+            detection_method, inflation_radius);
+    }
+    const Candidates& active_candidates =
+        use_cached_candidates ? m_cached_candidates : candidates;
 
     Eigen::MatrixXd V = bodies.world_vertices(poses);
     ipc::construct_constraint_set(
-        candidates, /*V_rest=*/V, V, bodies.m_edges, bodies.m_faces,
+        active_candidates, /*V_rest=*/V, V, bodies.m_edges, bodies.m_faces,
         /*dhat=*/dhat, constraint_set, bodies.m_faces_to_edges,
         /*dmin=*/dmin);
 
     PROFILE_END();
 
-    cached_poses = poses;
-    cached_constraint_set = constraint_set;
+    m_constraint_set_poses = poses;
+    m_constraint_set_dhat = m_barrier_activation_distance;
+    m_cached_constraint_set = constraint_set;
+}
+
+bool DistanceBarrierConstraint::is_covered_by_cached_candidates(
+    const PosesD& poses, const double inflation_radius) const
+{
+    if (m_cached_inflation_radius != inflation_radius
+        || poses.size() != m_cached_poses_t0.size()) {
+        return false;
+    }
+
+    // Check that poses = (1 - α) * poses_t0 + α * poses_t1 for α ∈ [0, 1]
+    const Eigen::VectorXd x = PoseD::poses_to_dofs(poses);
+    const Eigen::VectorXd x0 = PoseD::poses_to_dofs(m_cached_poses_t0);
+    const Eigen::VectorXd dx = PoseD::poses_to_dofs(m_cached_poses_t1) - x0;
+
+    const double dx_sqnorm = dx.squaredNorm();
+    const double alpha =
+        dx_sqnorm == 0 ? 0 : ((x - x0).dot(dx) / dx_sqnorm);
+    // Allow for the rounding of x + α * Δx in the line search
+    const double tol = 1e-12 * std::max(1.0, x.lpNorm<Eigen::Infinity>());
+    return alpha >= -tol && alpha <= 1 + tol
+        && (x0 + alpha * dx - x).lpNorm<Eigen::Infinity>() <= tol;
+}
+
+void DistanceBarrierConstraint::clear_candidate_cache() const
+{
+    m_cached_candidates = Candidates();
+    m_cached_poses_t0.clear();
+    m_cached_poses_t1.clear();
+    m_cached_inflation_radius = -1;
+    m_cached_constraint_set = Constraints();
+    m_constraint_set_poses.clear();
 }
 
 double DistanceBarrierConstraint::compute_minimum_distance(
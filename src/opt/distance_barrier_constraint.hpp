@@ -38,6 +38,12 @@ public:
         const PosesD& poses_t0,
         const PosesD& poses_t1) const;
 
+    /// @brief Compute the earliest time of impact along poses_t0 → poses_t1.
+    ///
+    /// For non-linear trajectories, the broad-phase candidates of the whole
+    /// trajectory inflated by d̂ are cached and reused by
+    /// construct_constraint_set() for any poses along the trajectory (e.g.,
+    /// the steps of a line search).
     double compute_earliest_toi(
         const RigidBodyAssembler& bodies,
         const PosesD& poses_t0,
@@ -96,8 +102,31 @@ protected:
         const PosesD& poses_t1,
         const Candidates& candidates) const;
 
+    /// @brief Determine if the cached candidates contain every candidate of
+    /// the given poses.
+    bool is_covered_by_cached_candidates(
+        const PosesD& poses, const double inflation_radius) const;
+
+    void clear_candidate_cache() const;
+
     /// @brief Max distance, d̂, at which the barrier forces are activate.
     double m_barrier_activation_distance;
+
+    /// @brief Candidates of every configuration along the segment
+    /// m_cached_poses_t0 → m_cached_poses_t1.
+    mutable Candidates m_cached_candidates;
+    mutable PosesD m_cached_poses_t0, m_cached_poses_t1;
+    /// @brief Inflation radius of the cached candidates (negative if empty).
+    mutable double m_cached_inflation_radius;
+
+    /// @brief Constraint set of the last poses given to
+    /// construct_constraint_set().
+    ///
+    /// This is stored per constraint (instead of in a static) so problems can
+    /// be solved concurrently.
+    mutable Constraints m_cached_constraint_set;
+    mutable PosesD m_constraint_set_poses;
+    mutable double m_constraint_set_dhat;
 };
 
 } // namespace ipc::rigid
@@ -5,6 +5,17 @@
 
 namespace ipc::rigid {
 
+double OptimizationProblem::compute_objective_blocks(
+    const Eigen::VectorXd& x, Eigen::VectorXd& grad, BlockSparseMatrix& hess)
+{
+    Eigen::SparseMatrix<double> sparse_hess;
+    double fx = compute_objective(x, grad, sparse_hess);
+    const int bs = hessian_block_size();
+    hess = BlockSparseMatrix(sparse_hess.cols() / bs, bs);
+    hess += sparse_hess;
+    return fx;
+}
+
 Eigen::VectorXd eval_grad_objective_approx(
     OptimizationProblem& problem, const Eigen::VectorXd& x)
 {
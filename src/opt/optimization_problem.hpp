@@ -5,6 +5,7 @@
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
 
+#include <utils/block_sparse_matrix.hpp>
 #include <utils/eigen_ext.hpp>
 
 namespace ipc::rigid {
@@ -43,7 +44,25 @@ public:
             /*compute_grad=*/true, /*compute_hess=*/false);
     }
 
+    /// @brief Compute the objective function f(x), its gradient, and its
+    /// Hessian as blocks of hessian_block_size() without assembling it.
+    ///
+    /// By default the assembled Hessian is split into blocks.
+    virtual double compute_objective_blocks(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad,
+        BlockSparseMatrix& hess);
+
     virtual void update_augmented_lagrangian(const Eigen::VectorXd& x) {}
+
+    /// @brief Initial iterate of a solve starting at x0.
+    ///
+    /// Problems with a history (e.g., previous time-steps) can return a better
+    /// guess than x0. The guess must be reachable from x0 without collisions.
+    virtual Eigen::VectorXd warm_start_point(const Eigen::VectorXd& x0)
+    {
+        return x0;
+    }
     virtual bool
     are_equality_constraints_satisfied(const Eigen::VectorXd& x) const
     {
@@ -56,6 +75,10 @@ public:
     /// @returns A vector of booleans indicating if a DoF is fixed.
     virtual const VectorXb& is_dof_fixed() const = 0;
 
+    /// @returns The number of consecutive variables that form a diagonal
+    /// block of the Hessian (e.g., the DoF of a body).
+    virtual int hessian_block_size() const { return 1; }
+
     virtual Eigen::VectorXi free_dof() const
     {
         const VectorXb& is_fixed = is_dof_fixed();
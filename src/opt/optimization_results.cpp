@@ -8,6 +8,7 @@ OptimizationResults::OptimizationResults()
     , success(false)
     , finished(false)
     , num_iterations(0)
+    , min_ccd_step_size(1)
 {
 }
 
@@ -22,6 +23,7 @@ OptimizationResults::OptimizationResults(
     , success(success)
     , finished(finished)
     , num_iterations(num_iterations)
+    , min_ccd_step_size(1)
 {
 }
 
@@ -11,6 +11,9 @@ struct OptimizationResults {
                         ///< successfully.
     bool finished;      ///< @brief Whether or not the optimizer converged.
     int num_iterations; ///< @brief number of iterations performed
+    /// @brief Smallest collision-free step length allowed by CCD in the line
+    /// searches (1 if CCD never limited a step).
+    double min_ccd_step_size;
 
     OptimizationResults();
     OptimizationResults(
@@ -138,16 +138,6 @@ public:
         return world_vertex<T>(Pose<T>(dof), vertex_idx);
     }
 
-    /// @warning Will not resize jac or hess, so make sure it is large
-    /// enough.
-    template <typename DScalar>
-    Eigen::MatrixXd world_vertices_diff(
-        const PoseD& pose,
-        long rb_v0_i,
-        Eigen::MatrixXd& V,
-        Eigen::MatrixXd& jac,
-        Eigen::MatrixXd& hess) const;
-
     double edge_length(int edge_id) const
     {
         return (vertices.row(edges(edge_id, 1))
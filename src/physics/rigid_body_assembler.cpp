@@ -111,6 +111,11 @@ void RigidBodyAssembler::init(const std::vector<RigidBody>& rigid_bodies)
     if (num_free_dof) {
         average_mass /= num_free_dof;
     }
+
+    // The bodies changed so the broad-phase structures have to be rebuilt
+    m_close_bodies_bvh.clear();
+    m_close_bodies_sap.clear();
+    m_primitive_sap.clear();
 }
 
 size_t RigidBodyAssembler::count_kinematic_bodies() const
@@ -197,75 +202,15 @@ Eigen::MatrixXd RigidBodyAssembler::world_velocities() const
     return V;
 }
 
-Eigen::MatrixXd RigidBodyAssembler::world_vertices_diff(
-    const PosesD& poses,
-    Eigen::MatrixXd& jac,
-    Eigen::MatrixXd& hess,
-    bool compute_jac,
-    bool compute_hess) const
-{
-    assert(num_bodies() == poses.size());
-
-    if (!compute_jac && !compute_hess) {
-        return world_vertices(poses);
-    }
-
-    // We will only use auto diff to compute the derivatives of the rotation
-    // matrix.
-    typedef AutodiffType<Eigen::Dynamic, /*maxN=*/3> Diff;
-
-    PROFILE_POINT("RigidBodyAssembler::world_vertices_diff");
-    PROFILE_START();
-
-    // V: Rᵐ ↦ Rⁿ (vertices flattened rowwise)
-    const int n = num_vertices() * dim();
-    const int m = PoseD::dim_to_ndof(dim());
-
-    NAMED_PROFILE_POINT(
-        "RigidBodyAssembler::world_vertices_diff:allocation", ALLOCATION);
-    PROFILE_START(ALLOCATION);
-    if (compute_jac) {
-        // ∇ V(x): Rᵐ ↦ Rⁿˣᵐ
-        jac.resize(n, m);
-    }
-    if (compute_hess) {
-        // ∇²V(x): Rᵐ ↦ Rⁿˣᵐˣᵐ
-        hess.resize(n * m, m); // Store as (n * m) × m matrix
-    }
-    Eigen::MatrixXd V(num_vertices(), dim());
-    PROFILE_END(ALLOCATION);
-
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(size_t(0), num_bodies()),
-        [&](const tbb::blocked_range<size_t>& range) {
-            for (size_t rb_i = range.begin(); rb_i != range.end(); ++rb_i) {
-                const RigidBody& rb = m_rbs[rb_i];
-
-                // Index of rigid bodies first vertex in the global vertices
-                long rb_v0_i = m_body_vertex_id[rb_i];
-
-                if (compute_hess) {
-                    rb.world_vertices_diff<Diff::DDouble2>(
-                        poses[rb_i], rb_v0_i, V, jac, hess);
-                } else {
-                    assert(compute_jac);
-                    rb.world_vertices_diff<Diff::DDouble1>(
-                        poses[rb_i], rb_v0_i, V, jac, hess);
-                }
-            }
-        });
-
-    assert((V - world_vertices(poses)).norm() < 1e-12);
-
-    PROFILE_END();
-    return V;
-}
-
 std::vector<std::pair<int, int>> RigidBodyAssembler::close_bodies(
     const PosesD& poses_t0,
     const PosesD& poses_t1,
-    const double inflation_radius) const
+    const double inflation_radius,
+    const DetectionMethod method) const
 {
+    if (method == DetectionMethod::SWEEP_AND_PRUNE) {
+        return close_bodies_sap(poses_t0, poses_t1, inflation_radius);
+    }
     // if (num_bodies() < 10) {
     //     return close_bodies_brute_force(
     //         poses_t0, poses_t1, inflation_radius);
@@ -323,26 +268,20 @@ std::vector<std::pair<int, int>> RigidBodyAssembler::close_bodies_bvh(
         body_bounding_boxes.push_back({ { min3D, max3D } });
     }
 
-    BVH::BVH bvh;
-    bvh.init(body_bounding_boxes);
+    // Refit the persistent BVH (rebuilds only if the quality degrades)
+    m_close_bodies_bvh.update(body_bounding_boxes);
 
     PROFILE_END(BUILD);
 
     NAMED_PROFILE_POINT("RigidBodyAssembler::close_bodies_bvh:query", QUERY);
     PROFILE_START(QUERY);
 
+    // Parallel self-query that visits each pair once (i < j)
     std::vector<std::pair<int, int>> close_body_pairs;
-    for (int i = 0; i < num_bodies(); i++) {
-        std::vector<unsigned int> intersecting_body_ids;
-        bvh.intersect_box(
-            body_bounding_boxes[i][0], body_bounding_boxes[i][1],
-            intersecting_body_ids);
-        for (const auto& j : intersecting_body_ids) {
-            if (i < j && m_rbs[i].group_id != m_rbs[j].group_id) {
-                close_body_pairs.emplace_back(i, j);
-            }
-        }
-    }
+    m_close_bodies_bvh.intersect_self(
+        close_body_pairs, [&](size_t i, size_t j) {
+            return m_rbs[i].group_id != m_rbs[j].group_id;
+        });
 
     PROFILE_END(QUERY);
     PROFILE_MESSAGE(
@@ -351,6 +290,51 @@ std::vector<std::pair<int, int>> RigidBodyAssembler::close_bodies_bvh(
     return close_body_pairs;
 }
 
+std::vector<std::pair<int, int>> RigidBodyAssembler::close_bodies_sap(
+    const PosesD& poses_t0,
+    const PosesD& poses_t1,
+    const double inflation_radius) const
+{
+    NAMED_PROFILE_POINT("RigidBodyAssembler::close_bodies_sap:sort", SORT);
+    PROFILE_START(SORT);
+
+    std::vector<std::array<Eigen::Vector3d, 2>> body_bounding_boxes(
+        num_bodies());
+    for (int i = 0; i < num_bodies(); i++) {
+        VectorMax3d min, max;
+        m_rbs[i].compute_bounding_box(poses_t0[i], poses_t1[i], min, max);
+        body_bounding_boxes[i][0].setZero();
+        body_bounding_boxes[i][1].setZero();
+        body_bounding_boxes[i][0].head(dim()) =
+            (min.array() - inflation_radius).matrix();
+        body_bounding_boxes[i][1].head(dim()) =
+            (max.array() + inflation_radius).matrix();
+    }
+
+    // Insertion sort starting from the previous order
+    m_close_bodies_sap.update(body_bounding_boxes);
+
+    PROFILE_END(SORT);
+    PROFILE_MESSAGE(
+        SORT, "num_swaps",
+        fmt::format("{:d}", m_close_bodies_sap.num_swaps()));
+
+    NAMED_PROFILE_POINT("RigidBodyAssembler::close_bodies_sap:sweep", SWEEP);
+    PROFILE_START(SWEEP);
+
+    std::vector<std::pair<int, int>> close_body_pairs;
+    m_close_bodies_sap.intersect_self(
+        close_body_pairs, [&](size_t i, size_t j) {
+            return m_rbs[i].group_id != m_rbs[j].group_id;
+        });
+
+    PROFILE_END(SWEEP);
+    PROFILE_MESSAGE(
+        SWEEP, "num_pairs", fmt::format("{:d}", close_body_pairs.size()));
+
+    return close_body_pairs;
+}
+
 std::vector<std::pair<int, int>> RigidBodyAssembler::close_bodies_hash_grid(
     const PosesD& poses_t0,
     const PosesD& poses_t1,
@@ -6,8 +6,11 @@
 #include <Eigen/Sparse>
 
 #include <autodiff/autodiff_types.hpp>
+#include <ccd/detection_method.hpp>
 #include <physics/rigid_body.hpp>
 #include <utils/eigen_ext.hpp>
+#include <utils/refit_bvh.hpp>
+#include <utils/sweep_and_prune.hpp>
 
 namespace ipc::rigid {
 
@@ -53,39 +56,6 @@ public:
 
     Eigen::MatrixXd world_velocities() const;
 
-    /// @brief Derivatives of the vertices with repect to rigid body DOF.
-    ///
-    /// Store the jacobian and hessian in a condensed form where only the
-    /// rigid DOF of the body the vertex belongs to is computed.
-    ///
-    /// @returns The vertices of all rigid bodies as a \f$n \times {2, 3}\f$
-    /// matrix.
-    Eigen::MatrixXd world_vertices_diff(
-        const PosesD& poses,
-        Eigen::MatrixXd& jac,
-        Eigen::MatrixXd& hess,
-        bool compute_jac,
-        bool compute_hess) const;
-
-    /// @brief Derivatives of the vertices with repect to rigid body DOF.
-    ///
-    /// Store the jacobian and hessian in a condensed form where only the
-    /// rigid DOF of the body the vertex belongs to is computed.
-    ///
-    /// @returns The vertices of all rigid bodies as a \f$n \times {2, 3}\f$
-    /// matrix.
-    Eigen::MatrixXd world_vertices_diff(
-        const Eigen::VectorXd& dof,
-        Eigen::MatrixXd& jac,
-        Eigen::MatrixXd& hess,
-        bool compute_jac,
-        bool compute_hess) const
-    {
-        return world_vertices_diff(
-            PoseD::dofs_to_poses(dof, dim()), jac, hess, compute_jac,
-            compute_hess);
-    }
-
     void global_to_local_vertex(
         const long global_vertex_id,
         long& rigid_body_id,
@@ -145,12 +115,20 @@ public:
 
     const Eigen::VectorXi& group_ids() const { return m_vertex_group_ids; }
 
+    /// Persistent sweep-and-prune of the vertex, edge, and face boxes used by
+    /// the SWEEP_AND_PRUNE broad-phase.
+    SweepAndPrune& primitive_sap() const { return m_primitive_sap; }
+
     /// Get a vector of body ids where each body is close to at least one
     /// other body.
+    ///
+    /// Only SWEEP_AND_PRUNE changes the method used; all other methods use a
+    /// BVH of the bodies.
     std::vector<std::pair<int, int>> close_bodies(
         const PosesD& poses_t0,
         const PosesD& poses_t1,
-        const double inflation_radius) const;
+        const double inflation_radius,
+        const DetectionMethod method = DetectionMethod::BVH) const;
     std::vector<std::pair<int, int>> close_bodies_brute_force(
         const PosesD& poses_t0,
         const PosesD& poses_t1,
@@ -163,6 +141,10 @@ public:
         const PosesD& poses_t0,
         const PosesD& poses_t1,
         const double inflation_radius) const;
+    std::vector<std::pair<int, int>> close_bodies_sap(
+        const PosesD& poses_t0,
+        const PosesD& poses_t1,
+        const double inflation_radius) const;
 
     /// Get the ith rigid body
     const RigidBody& operator[](size_t i) const { return m_rbs[i]; }
@@ -210,6 +192,22 @@ public:
 protected:
     /// @brief Group ids per vertex
     Eigen::VectorXi m_vertex_group_ids;
+
+    /// @brief Persistent BVH of the body bounding boxes used by
+    /// close_bodies_bvh(). It is refit in place between calls and only
+    /// rebuilt when its quality degrades.
+    /// @warning This makes close_bodies_bvh() not thread-safe.
+    mutable RefitBVH m_close_bodies_bvh;
+
+    /// @brief Persistent sweep-and-prune of the body bounding boxes used by
+    /// close_bodies_sap().
+    mutable SweepAndPrune m_close_bodies_sap;
+
+    /// @brief Persistent sweep-and-prune of the vertex, edge, and face boxes
+    /// used by the SWEEP_AND_PRUNE broad-phase.
+    /// @warning This makes detect_collision_candidates_rigid_sap() not
+    /// thread-safe.
+    mutable SweepAndPrune m_primitive_sap;
 };
 
 } // namespace ipc::rigid
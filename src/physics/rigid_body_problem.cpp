@@ -158,6 +158,13 @@ void RigidBodyProblem::state(const nlohmann::json& args)
     for (auto& jrb : args["rigid_bodies"]) {
         from_json(jrb["position"], m_assembler[i].pose.position);
         from_json(jrb["rotation"], m_assembler[i].pose.rotation);
+        if (!jrb.contains("linear_velocity")) {
+            // Pose-only state (an intermediate step of a binary trajectory)
+            // used to display a step. The velocities are unknown, so keep the
+            // current ones instead of inventing new ones.
+            i++;
+            continue;
+        }
         from_json(jrb["linear_velocity"], m_assembler[i].velocity.position);
         from_json(jrb["angular_velocity"], m_assembler[i].velocity.rotation);
         if (dim() == 3) {
@@ -178,6 +185,56 @@ void RigidBodyProblem::state(const nlohmann::json& args)
     }
 }
 
+namespace {
+    // Linearly interpolate every number of two JSON values of the same shape.
+    nlohmann::json
+    lerp_json(const nlohmann::json& a, const nlohmann::json& b, double t)
+    {
+        if (a.is_number() && b.is_number()) {
+            return (1 - t) * a.get<double>() + t * b.get<double>();
+        }
+        if (a.is_array() && b.is_array() && a.size() == b.size()) {
+            nlohmann::json c = nlohmann::json::array();
+            for (size_t i = 0; i < a.size(); i++) {
+                c.push_back(lerp_json(a[i], b[i], t));
+            }
+            return c;
+        }
+        if (a.is_object() && b.is_object()) {
+            nlohmann::json c = b;
+            for (auto& [key, value] : b.items()) {
+                if (a.contains(key)) {
+                    c[key] = lerp_json(a[key], value, t);
+                }
+            }
+            return c;
+        }
+        return t < 0.5 ? a : b;
+    }
+} // namespace
+
+nlohmann::json RigidBodyProblem::interpolate_state(
+    const nlohmann::json& state0, const nlohmann::json& state1, double t) const
+{
+    nlohmann::json state = lerp_json(state0, state1, t);
+    if (dim() != 3) {
+        return state;
+    }
+
+    // Linearly interpolating rotation vectors does not follow the shortest
+    // rotation, so slerp the quaternions instead.
+    auto& rbs = state["rigid_bodies"];
+    for (size_t i = 0; i < rbs.size(); i++) {
+        Eigen::VectorXd r0, r1;
+        from_json(state0["rigid_bodies"][i]["rotation"], r0);
+        from_json(state1["rigid_bodies"][i]["rotation"], r1);
+        Eigen::AngleAxisd r(
+            construct_quaternion(r0).slerp(t, construct_quaternion(r1)));
+        rbs[i]["rotation"] = to_json(Eigen::VectorXd(r.angle() * r.axis()));
+    }
+    return state;
+}
+
 void RigidBodyProblem::update_dof()
 {
     poses_t0 = m_assembler.rb_poses_t0();
@@ -30,7 +30,17 @@ public:
     nlohmann::json settings() const override;
 
     virtual nlohmann::json state() const override;
+    /// @brief Set the state of the bodies.
+    ///
+    /// A pose-only state (see TrajectoryReader::read_state()) only moves the
+    /// bodies and keeps their current velocities.
     void state(const nlohmann::json& s) override;
+    /// @brief Linearly interpolate the state of the bodies (spherically for
+    /// 3D rotations).
+    nlohmann::json interpolate_state(
+        const nlohmann::json& state0,
+        const nlohmann::json& state1,
+        double t) const override;
 
     virtual double timestep() const override { return m_timestep; }
     virtual void timestep(double timestep) override { m_timestep = timestep; }
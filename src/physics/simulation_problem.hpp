@@ -36,6 +36,14 @@ public:
     virtual nlohmann::json state() const = 0;
     /// Set the state of the simulation
     virtual void state(const nlohmann::json& s) = 0;
+    /// @brief Interpolate between two states of the simulation.
+    /// @param state0 State at t = 0.
+    /// @param state1 State at t = 1.
+    /// @param t Interpolation parameter in [0, 1].
+    virtual nlohmann::json interpolate_state(
+        const nlohmann::json& state0,
+        const nlohmann::json& state1,
+        double t) const = 0;
 
     virtual double timestep() const = 0;        ///< Get the timestep size
     virtual void timestep(double timestep) = 0; ///< Set the timestep size
@@ -0,0 +1,163 @@
+#include "world_vertices_diff.hpp"
+
+#include <type_traits>
+
+#include <tbb/parallel_for.h>
+
+#include <autodiff/autodiff_types.hpp>
+#include <physics/rigid_body_assembler.hpp>
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+WorldVerticesDiff::WorldVerticesDiff(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses,
+    bool compute_jac,
+    bool compute_hess)
+    : m_bodies(bodies)
+    , m_has_jac(compute_jac || compute_hess)
+    , m_has_hess(compute_hess)
+{
+    assert(bodies.num_bodies() == poses.size());
+
+    if (!m_has_jac) {
+        m_vertices = bodies.world_vertices(poses);
+        return;
+    }
+
+    PROFILE_POINT("WorldVerticesDiff::WorldVerticesDiff");
+    PROFILE_START();
+
+    // The gradient only needs first derivatives of the rotations
+    typedef AutodiffType<Eigen::Dynamic, /*maxN=*/3> Diff;
+    if (m_has_hess) {
+        compute_rotation_derivatives<Diff::DDouble2>(poses);
+    } else {
+        compute_rotation_derivatives<Diff::DDouble1>(poses);
+    }
+
+    PROFILE_END();
+}
+
+template <typename DScalar>
+void WorldVerticesDiff::compute_rotation_derivatives(const PosesD& poses)
+{
+    // We will only use auto diff to compute the derivatives of the rotation
+    // matrix.
+    typedef AutodiffType<Eigen::Dynamic, /*maxN=*/3> Diff;
+    constexpr bool has_hess = std::is_same<DScalar, Diff::DDouble2>::value;
+    assert(has_hess == m_has_hess);
+
+    const RigidBodyAssembler& bodies = m_bodies;
+    const int dim = bodies.dim();
+    const int rot_ndof = PoseD::dim_to_rot_ndof(dim);
+
+    m_vertices.resize(bodies.num_vertices(), dim);
+    m_rotation_jac.resize(bodies.num_bodies());
+    if (has_hess) {
+        m_rotation_hess.resize(bodies.num_bodies());
+    }
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), bodies.num_bodies()),
+        [&](const tbb::blocked_range<size_t>& range) {
+            // Activate autodiff with the correct number of variables.
+            Diff::activate(rot_ndof);
+
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                const RigidBody& rb = bodies[i];
+
+                MatrixMax3<DScalar> R = construct_rotation_matrix(
+                    VectorMax3<DScalar>(
+                        Diff::template dTvars<DScalar>(0, poses[i].rotation)));
+
+                MatrixMax3d R_value(dim, dim);
+                for (int k = 0; k < rot_ndof; k++) {
+                    m_rotation_jac[i][k].resize(dim, dim);
+                    if constexpr (has_hess) {
+                        for (int l = 0; l < rot_ndof; l++) {
+                            m_rotation_hess[i][k * rot_ndof + l].resize(
+                                dim, dim);
+                        }
+                    }
+                }
+                for (int r = 0; r < dim; r++) {
+                    for (int c = 0; c < dim; c++) {
+                        R_value(r, c) = R(r, c).getValue();
+                        for (int k = 0; k < rot_ndof; k++) {
+                            m_rotation_jac[i][k](r, c) =
+                                R(r, c).getGradient()(k);
+                            if constexpr (has_hess) {
+                                for (int l = 0; l < rot_ndof; l++) {
+                                    m_rotation_hess[i][k * rot_ndof + l](r, c) =
+                                        R(r, c).getHessian()(k, l);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                m_vertices.middleRows(
+                    bodies.m_body_vertex_id[i], rb.num_vertices()) =
+                    rb.world_vertices(R_value, poses[i].position);
+            }
+        });
+}
+
+void WorldVerticesDiff::local_vertex(
+    long vertex_id, long& body_id, VectorMax3d& v) const
+{
+    body_id = m_bodies.vertex_id_to_body_id(vertex_id);
+    v = m_bodies[body_id]
+            .vertices.row(vertex_id - m_bodies.m_body_vertex_id[body_id])
+            .transpose();
+}
+
+WorldVerticesDiff::VertexJacobian
+WorldVerticesDiff::vertex_jacobian(long vertex_id) const
+{
+    assert(m_has_jac);
+
+    long body_id;
+    VectorMax3d v;
+    local_vertex(vertex_id, body_id, v);
+
+    const int dim = v.size();
+    const int pos_ndof = PoseD::dim_to_pos_ndof(dim);
+    const int rot_ndof = PoseD::dim_to_rot_ndof(dim);
+
+    VertexJacobian jac(dim, pos_ndof + rot_ndof);
+    jac.leftCols(pos_ndof).setIdentity(); // ∇ₚV = I
+    for (int k = 0; k < rot_ndof; k++) {
+        jac.col(pos_ndof + k) = m_rotation_jac[body_id][k] * v;
+    }
+    return jac;
+}
+
+MatrixMax6d WorldVerticesDiff::vertex_hessian(long vertex_id, int coord) const
+{
+    assert(m_has_hess);
+
+    long body_id;
+    VectorMax3d v;
+    local_vertex(vertex_id, body_id, v);
+
+    const int dim = v.size();
+    const int pos_ndof = PoseD::dim_to_pos_ndof(dim);
+    const int rot_ndof = PoseD::dim_to_rot_ndof(dim);
+
+    // Hessian of position is zero
+    // ∇²_p V = ∇_p∇_r V = ∇_r∇_p V = 0
+    const int ndof = pos_ndof + rot_ndof;
+    MatrixMax6d hess = MatrixMax6d::Zero(ndof, ndof);
+    for (int k = 0; k < rot_ndof; k++) {
+        for (int l = 0; l < rot_ndof; l++) {
+            hess(pos_ndof + k, pos_ndof + l) =
+                m_rotation_hess[body_id][k * rot_ndof + l].row(coord).dot(v);
+        }
+    }
+    return hess;
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <physics/pose.hpp>
+#include <utils/eigen_ext.hpp>
+
+namespace ipc::rigid {
+
+class RigidBodyAssembler;
+
+/// @brief Derivatives of the world vertices with respect to rigid body DOF.
+///
+/// A vertex of a rigid body is \f$V = R(\theta) v + p\f$, so \f$\nabla_p V =
+/// I\f$, \f$\partial V / \partial \theta_k = (\partial R / \partial \theta_k)
+/// v\f$, and its Hessian only depends on the second derivatives of \f$R\f$.
+/// Only the derivatives of each body's rotation matrix are stored, and the
+/// Jacobian and Hessian of a vertex are built on demand. This takes memory
+/// proportional to the number of bodies, and only the vertices used by the
+/// constraints pay for their derivatives.
+class WorldVerticesDiff {
+public:
+    /// @brief Jacobian of a vertex with respect to its body's DOF.
+    typedef Eigen::
+        Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, 3, 6>
+            VertexJacobian;
+
+    /// @brief Compute the world vertices and the derivatives of the rotations.
+    WorldVerticesDiff(
+        const RigidBodyAssembler& bodies,
+        const PosesD& poses,
+        bool compute_jac,
+        bool compute_hess);
+
+    /// @brief The vertices of all rigid bodies as a \f$n \times {2, 3}\f$
+    /// matrix.
+    const Eigen::MatrixXd& vertices() const { return m_vertices; }
+
+    /// @brief Jacobian of a global vertex with respect to the DOF of its body
+    /// (\f$dim \times ndof\f$).
+    VertexJacobian vertex_jacobian(long vertex_id) const;
+
+    /// @brief Hessian of one coordinate of a global vertex with respect to the
+    /// DOF of its body (\f$ndof \times ndof\f$).
+    MatrixMax6d vertex_hessian(long vertex_id, int coord) const;
+
+protected:
+    /// @brief Compute the world vertices and the derivatives of the rotations
+    /// using autodiff scalars of the given order (DDouble1 or DDouble2).
+    template <typename DScalar>
+    void compute_rotation_derivatives(const PosesD& poses);
+
+    /// @brief Body and body-space coordinates of a global vertex.
+    void local_vertex(long vertex_id, long& body_id, VectorMax3d& v) const;
+
+    const RigidBodyAssembler& m_bodies;
+    Eigen::MatrixXd m_vertices;
+    bool m_has_jac;
+    bool m_has_hess;
+
+    /// @brief ∂R/∂θₖ of each body
+    std::vector<std::array<MatrixMax3d, 3>> m_rotation_jac;
+    /// @brief ∂²R/∂θₖ∂θₗ of each body stored at index k * rot_ndof + l
+    std::vector<std::array<MatrixMax3d, 9>> m_rotation_hess;
+};
+
+} // namespace ipc::rigid
@@ -1,5 +1,8 @@
 #include "distance_barrier_rb_problem.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 
@@ -16,6 +19,7 @@
 #include <geometry/distance.hpp>
 #include <solvers/solver_factory.hpp>
 #include <utils/not_implemented_error.hpp>
+#include <utils/union_find.hpp>
 
 #include <logger.hpp>
 #include <profiler.hpp>
@@ -25,24 +29,35 @@ namespace ipc::rigid {
 DistanceBarrierRBProblem::DistanceBarrierRBProblem()
     : m_barrier_stiffness(1)
     , min_distance(-1)
+    , use_contact_islands(false)
     , m_had_collisions(false)
     , static_friction_speed_bound(1e-3)
     , friction_iterations(1)
+    , sleep_steps(0)
+    , sleep_linear_velocity_threshold(1e-2)
+    , sleep_angular_velocity_threshold(3e-2)
+    , m_kinematic_pose_timestep(-1)
+    , m_kinematic_pose_time(0)
     , body_energy_integration_method(DEFAULT_BODY_ENERGY_INTEGRATION_METHOD)
 {
 }
 
 bool DistanceBarrierRBProblem::settings(const nlohmann::json& params)
 {
+    m_island_problems.clear();
     m_constraint.settings(params["distance_barrier_constraint"]);
     // Select the optimization solver
     std::string solver_name = params["solver"].get<std::string>();
     m_opt_solver = SolverFactory::factory().get_barrier_solver(solver_name);
     m_opt_solver->settings(params[solver_name]);
     m_opt_solver->set_problem(*this);
+    m_solver_settings = { { "solver", solver_name },
+                          { solver_name, params[solver_name] } };
     if (m_opt_solver->has_inner_solver()) {
-        m_opt_solver->inner_solver().settings(
-            params[m_opt_solver->inner_solver().name()]);
+        const std::string inner_solver_name =
+            m_opt_solver->inner_solver().name();
+        m_opt_solver->inner_solver().settings(params[inner_solver_name]);
+        m_solver_settings[inner_solver_name] = params[inner_solver_name];
     }
 
     // Friction
@@ -50,9 +65,22 @@ bool DistanceBarrierRBProblem::settings(const nlohmann::json& params)
         params["friction_constraints"]["static_friction_speed_bound"];
     friction_iterations = params["friction_constraints"]["iterations"];
 
+    // Scripted kinematic poses are given once per frame
+    m_kinematic_pose_timestep = params["timestep"];
+    m_kinematic_pose_time = 0;
+
+    // Sleeping
+    sleep_steps = params["body_sleeping"]["steps"];
+    sleep_linear_velocity_threshold =
+        params["body_sleeping"]["linear_velocity_threshold"];
+    sleep_angular_velocity_threshold =
+        params["body_sleeping"]["angular_velocity_threshold"];
+
     body_energy_integration_method =
         params["rigid_body_problem"]["time_stepper"]
             .get<BodyEnergyIntegrationMethod>();
+    use_contact_islands =
+        params["rigid_body_problem"]["solve_contact_islands"];
     bool success = RigidBodyProblem::settings(params["rigid_body_problem"]);
     if (!success) {
         return false;
@@ -85,6 +113,11 @@ nlohmann::json DistanceBarrierRBProblem::settings() const
     json["friction_iterations"] = friction_iterations;
     json["static_friction_speed_bound"] = static_friction_speed_bound;
     json["time_stepper"] = body_energy_integration_method;
+    json["solve_contact_islands"] = use_contact_islands;
+    json["sleep_steps"] = sleep_steps;
+    json["sleep_linear_velocity_threshold"] = sleep_linear_velocity_threshold;
+    json["sleep_angular_velocity_threshold"] =
+        sleep_angular_velocity_threshold;
     return json;
 }
 
@@ -96,9 +129,36 @@ nlohmann::json DistanceBarrierRBProblem::state() const
     } else {
         json["min_distance"] = min_distance;
     }
+    if (sleep_steps > 0) {
+        auto& rbs = json["rigid_bodies"];
+        for (size_t i = 0; i < rbs.size(); i++) {
+            rbs[i]["is_sleeping"] = is_body_sleeping(i);
+            rbs[i]["rest_steps"] =
+                i < m_body_rest_steps.size() ? m_body_rest_steps[i] : 0;
+        }
+    }
     return json;
 }
 
+void DistanceBarrierRBProblem::state(const nlohmann::json& s)
+{
+    RigidBodyProblem::state(s);
+
+    // States saved without sleeping have every body awake
+    m_is_body_sleeping.assign(num_bodies(), false);
+    m_body_rest_steps.assign(num_bodies(), 0);
+    const auto& rbs = s["rigid_bodies"];
+    for (size_t i = 0; i < num_bodies() && i < rbs.size(); i++) {
+        if (rbs[i].contains("is_sleeping")) {
+            m_is_body_sleeping[i] = rbs[i]["is_sleeping"].get<bool>();
+        }
+        if (rbs[i].contains("rest_steps")) {
+            // Interpolated states store a fractional number of steps
+            m_body_rest_steps[i] = int(rbs[i]["rest_steps"].get<double>());
+        }
+    }
+}
+
 Eigen::VectorXi DistanceBarrierRBProblem::free_dof() const
 {
     const VectorXb& is_dof_fixed = this->is_dof_fixed();
@@ -112,6 +172,46 @@ Eigen::VectorXi DistanceBarrierRBProblem::free_dof() const
     return Eigen::Map<Eigen::VectorXi>(free_dofs.data(), free_dofs.size());
 }
 
+Eigen::VectorXd
+DistanceBarrierRBProblem::warm_start_point(const Eigen::VectorXd& x)
+{
+    // Only the first solve of a time-step has a history to extrapolate (e.g.,
+    // friction lagging iterations start from the previous solution).
+    if (x.size() != x0_prev.size() || x != starting_point()) {
+        return x;
+    }
+
+    PROFILE_POINT("DistanceBarrierRBProblem::warm_start_point");
+    PROFILE_START();
+
+    // Repeat the displacement of the previous time-step for the free DoF
+    const VectorXb is_dof_frozen =
+        is_dof_fixed().array() || is_dof_satisfied.array();
+    Eigen::VectorXd dx = is_dof_frozen.select(0, x - x0_prev);
+    if (dx.squaredNorm() == 0) {
+        PROFILE_END();
+        return x;
+    }
+
+    // Stop short of the first impact. This is only a probe, so it should not
+    // count as a collision of the step.
+    const bool had_collisions = m_had_collisions;
+    double alpha = std::min(compute_earliest_toi(x, x + dx), 1.0);
+    m_had_collisions = had_collisions;
+    if (alpha < 1) {
+        alpha *= 0.8;
+    }
+    Eigen::VectorXd x_start = x + alpha * dx;
+
+    // Only keep the guess if it is better than the starting point
+    const double fx = compute_objective(x);
+    const double fx_start = compute_objective(x_start);
+    spdlog::debug(
+        "warm_start α={:g} f(x0)={:g} f(x_start)={:g}", alpha, fx, fx_start);
+    PROFILE_END();
+    return fx_start < fx ? x_start : x;
+}
+
 ////////////////////////////////////////////////////////////
 // Rigid Body Problem
 
@@ -125,6 +225,7 @@ void DistanceBarrierRBProblem::simulation_step(
     }
 
     // Update the stored poses and inital value for the solver
+    x0_prev = x0;
     update_dof();
 
     // Reset m_had_collision which will be filled in by has_collisions().
@@ -139,6 +240,7 @@ void DistanceBarrierRBProblem::simulation_step(
     opt_result = solve_constraints();
     _has_intersections = take_step(opt_result.x);
     step_kinematic_bodies();
+    sleep_resting_bodies();
     had_collisions = m_had_collisions;
 }
 
@@ -161,6 +263,7 @@ void DistanceBarrierRBProblem::update_constraints()
     update_friction_constraints(collision_constraints, poses_t0);
 
     init_augmented_lagrangian();
+    wake_sleeping_bodies();
 
     PROFILE_END();
 }
@@ -187,6 +290,154 @@ void DistanceBarrierRBProblem::update_friction_constraints(
     PROFILE_END();
 }
 
+bool DistanceBarrierRBProblem::is_body_restless(size_t body_id) const
+{
+    switch (m_assembler[body_id].type) {
+    case RigidBodyType::KINEMATIC:
+        return true;
+    case RigidBodyType::DYNAMIC:
+        return !is_body_sleeping(body_id)
+            && (body_id >= m_body_rest_steps.size()
+                || m_body_rest_steps[body_id] < sleep_steps);
+    default:
+        return false;
+    }
+}
+
+void DistanceBarrierRBProblem::sleep_resting_bodies()
+{
+    if (sleep_steps <= 0) {
+        return;
+    }
+
+    m_body_rest_steps.resize(num_bodies(), 0);
+    m_is_body_sleeping.resize(num_bodies(), false);
+    for (size_t i = 0; i < num_bodies(); i++) {
+        const RigidBody& rb = m_assembler[i];
+        if (rb.type != RigidBodyType::DYNAMIC || m_is_body_sleeping[i]) {
+            continue;
+        }
+        if (rb.velocity.position.norm() <= sleep_linear_velocity_threshold
+            && rb.velocity.rotation.norm()
+                <= sleep_angular_velocity_threshold) {
+            m_body_rest_steps[i]++;
+        } else {
+            m_body_rest_steps[i] = 0;
+        }
+    }
+
+    std::vector<bool> can_sleep(num_bodies());
+    for (size_t i = 0; i < num_bodies(); i++) {
+        can_sleep[i] = m_assembler[i].type == RigidBodyType::DYNAMIC
+            && !m_is_body_sleeping[i] && !is_body_restless(i);
+    }
+
+    // A body touching a restless body will be pushed, so a pile only falls
+    // asleep once all of its bodies are at rest.
+    std::vector<bool> has_contact(num_bodies(), false);
+    const PosesD poses = m_assembler.rb_poses_t1();
+    for (const auto& [i, j] : m_assembler.close_bodies(
+             poses, poses,
+             barrier_activation_distance()
+                 + m_constraint.minimum_separation_distance,
+             m_constraint.detection_method)) {
+        has_contact[i] = has_contact[j] = true;
+        if (is_body_restless(i)) {
+            can_sleep[j] = false;
+        }
+        if (is_body_restless(j)) {
+            can_sleep[i] = false;
+        }
+    }
+
+    // A slow body without contacts (e.g., at the top of its flight) is only
+    // at rest if nothing accelerates it. Sleeping bodies are only woken by
+    // restless bodies touching them, so it would sleep in mid-air.
+    for (size_t i = 0; i < num_bodies(); i++) {
+        if (can_sleep[i] && !has_contact[i]) {
+            const RigidBody& rb = m_assembler[i];
+            can_sleep[i] =
+                (rb.mass * gravity + rb.force.position).squaredNorm() == 0
+                && rb.force.rotation.squaredNorm() == 0;
+        }
+    }
+
+    int num_new_sleeping_bodies = 0;
+    for (size_t i = 0; i < num_bodies(); i++) {
+        if (!can_sleep[i]) {
+            continue;
+        }
+        RigidBody& rb = m_assembler[i];
+        rb.velocity = PoseD::Zero(dim());
+        rb.acceleration = PoseD::Zero(dim());
+        rb.Qdot.setZero();
+        rb.Qddot.setZero();
+        m_is_body_sleeping[i] = true;
+        num_new_sleeping_bodies++;
+    }
+
+    if (num_new_sleeping_bodies) {
+        spdlog::info(
+            "num_new_sleeping_bodies={:d} num_sleeping_bodies={:d}",
+            num_new_sleeping_bodies,
+            std::count(
+                m_is_body_sleeping.begin(), m_is_body_sleeping.end(), true));
+    }
+}
+
+void DistanceBarrierRBProblem::wake_sleeping_bodies()
+{
+    if (std::find(m_is_body_sleeping.begin(), m_is_body_sleeping.end(), true)
+        == m_is_body_sleeping.end()) {
+        return;
+    }
+
+    PROFILE_POINT("DistanceBarrierRBProblem::wake_sleeping_bodies");
+    PROFILE_START();
+
+    // Sleeping bodies do not move, so x_pred contains the motion of the
+    // restless bodies.
+    const std::vector<std::pair<int, int>> body_pairs =
+        m_assembler.close_bodies(
+            poses_t0, this->dofs_to_poses(x_pred),
+            barrier_activation_distance()
+                + m_constraint.minimum_separation_distance,
+            m_constraint.detection_method);
+
+    // Woken bodies are restless, so they in turn wake the bodies they touch.
+    int num_woken_bodies = 0;
+    bool woke_body;
+    do {
+        woke_body = false;
+        for (const auto& [i, j] : body_pairs) {
+            for (const auto& [a, b] :
+                 { std::make_pair(i, j), std::make_pair(j, i) }) {
+                if (is_body_sleeping(a) && is_body_restless(b)) {
+                    m_is_body_sleeping[a] = false;
+                    m_body_rest_steps[a] = 0;
+                    woke_body = true;
+                    num_woken_bodies++;
+                }
+            }
+        }
+    } while (woke_body);
+
+    if (num_woken_bodies) {
+        spdlog::info("num_woken_bodies={:d}", num_woken_bodies);
+    }
+
+    // Sleeping bodies are fixed like static bodies
+    const int ndof = PoseD::dim_to_ndof(dim());
+    for (size_t i = 0; i < num_bodies(); i++) {
+        if (is_body_sleeping(i)) {
+            is_dof_satisfied.segment(ndof * i, ndof).setOnes();
+            x_pred.segment(ndof * i, ndof) = x0.segment(ndof * i, ndof);
+        }
+    }
+
+    PROFILE_END();
+}
+
 void DistanceBarrierRBProblem::init_augmented_lagrangian()
 {
     int ndof = PoseD::dim_to_ndof(dim());
@@ -211,7 +462,7 @@ void DistanceBarrierRBProblem::init_augmented_lagrangian()
     x_pred = x0;
     for (int i = 0; i < num_bodies(); i++) {
         if (m_assembler[i].kinematic_poses.size()) {
-            const PoseD& pose = m_assembler[i].kinematic_poses.front();
+            const PoseD pose = kinematic_target_pose(i);
             // Kinematic position
             x_pred.segment(ndof * i, pos_ndof) = pose.position;
             // Kinematic rotation
@@ -234,17 +485,64 @@ void DistanceBarrierRBProblem::init_augmented_lagrangian()
     }
 }
 
+double DistanceBarrierRBProblem::kinematic_pose_timestep() const
+{
+    return m_kinematic_pose_timestep > 0 ? m_kinematic_pose_timestep
+                                         : timestep();
+}
+
+PoseD DistanceBarrierRBProblem::kinematic_target_pose(int body_id) const
+{
+    const std::deque<PoseD>& poses = m_assembler[body_id].kinematic_poses;
+    assert(!poses.empty());
+    const double pose_timestep = kinematic_pose_timestep();
+    // Avoid skipping a pose because of round-off in the accumulated time
+    const double time_tol = 1e-9 * pose_timestep;
+
+    // Time at the end of this step since the last consumed pose
+    const double t = m_kinematic_pose_time + timestep();
+    if (t <= pose_timestep + time_tol) {
+        // The step ends before the next pose: move towards it from the
+        // current pose.
+        const double remaining_time = pose_timestep - m_kinematic_pose_time;
+        return PoseD::interpolate(
+            m_assembler[body_id].pose, poses.front(),
+            std::min(timestep() / remaining_time, 1.0));
+    }
+
+    // The step crosses at least one pose: interpolate between the two poses
+    // around the end of the step.
+    const size_t k = size_t(std::ceil((t - time_tol) / pose_timestep)) - 1;
+    if (k >= poses.size()) {
+        return poses.back();
+    }
+    return PoseD::interpolate(
+        poses[k - 1], poses[k], std::clamp(t / pose_timestep - k, 0.0, 1.0));
+}
+
 void DistanceBarrierRBProblem::step_kinematic_bodies()
 {
+    // Count the poses passed by this step
+    const double pose_timestep = kinematic_pose_timestep();
+    const double time_tol = 1e-9 * pose_timestep;
+    m_kinematic_pose_time += timestep();
+    size_t num_passed_poses = 0;
+    while (m_kinematic_pose_time >= pose_timestep - time_tol) {
+        m_kinematic_pose_time -= pose_timestep;
+        num_passed_poses++;
+    }
+    m_kinematic_pose_time = std::max(m_kinematic_pose_time, 0.0);
+
     for (int i = 0; i < num_bodies(); i++) {
         if (m_assembler[i].type == RigidBodyType::KINEMATIC) {
             if (m_assembler[i].kinematic_max_time < 0) {
                 m_assembler[i].convert_to_static();
             } else {
                 m_assembler[i].kinematic_max_time -= timestep();
-                if (m_assembler[i].kinematic_poses.size()) {
-                    m_assembler[i].kinematic_poses.pop_front();
-                }
+                std::deque<PoseD>& poses = m_assembler[i].kinematic_poses;
+                poses.erase(
+                    poses.begin(),
+                    poses.begin() + std::min(num_passed_poses, poses.size()));
             }
         }
     }
@@ -434,13 +732,23 @@ bool DistanceBarrierRBProblem::are_equality_constraints_satisfied(
 OptimizationResults DistanceBarrierRBProblem::solve_constraints()
 {
     OptimizationResults opt_result;
+    // Without barriers every body is independent and the Newton solver
+    // already solves each body separately.
+    if (use_contact_islands && m_use_barriers
+        && solve_contact_islands(opt_result)) {
+        return opt_result;
+    }
+
     opt_result.x = starting_point();
     double momentum_balance, eps_d = 1e-2 * world_bbox_diagonal();
     int i = 0;
     int total_newton_iterations = 0;
+    double min_ccd_step_size = 1;
     do {
         opt_result = solver().solve(opt_result.x);
         total_newton_iterations += opt_result.num_iterations;
+        min_ccd_step_size =
+            std::min(min_ccd_step_size, opt_result.min_ccd_step_size);
         if (!opt_result.success) {
             break;
         }
@@ -459,6 +767,13 @@ OptimizationResults DistanceBarrierRBProblem::solve_constraints()
 
         Eigen::VectorXd tmp = grad_Ex + barrier_stiffness() * grad_Bx + grad_Dx;
         tmp = is_dof_fixed().select(0, tmp);
+        // Sleeping bodies are fixed
+        const int ndof = PoseD::dim_to_ndof(dim());
+        for (size_t bi = 0; bi < num_bodies(); bi++) {
+            if (is_body_sleeping(bi)) {
+                tmp.segment(ndof * bi, ndof).setZero();
+            }
+        }
 
         momentum_balance = tmp.norm();
 
@@ -482,9 +797,320 @@ OptimizationResults DistanceBarrierRBProblem::solve_constraints()
     }
 
     opt_result.num_iterations = total_newton_iterations;
+    opt_result.min_ccd_step_size = min_ccd_step_size;
     return opt_result;
 }
 
+std::vector<std::vector<int>>
+DistanceBarrierRBProblem::compute_contact_islands() const
+{
+    // Sleeping bodies are fixed like static bodies
+    auto is_static = [&](int i) {
+        return m_assembler[i].type == RigidBodyType::STATIC
+            || is_body_sleeping(i);
+    };
+
+    // x_pred is the unconstrained motion of the bodies
+    const std::vector<std::pair<int, int>> body_pairs =
+        m_assembler.close_bodies(
+            poses_t0, this->dofs_to_poses(x_pred),
+            barrier_activation_distance()
+                + m_constraint.minimum_separation_distance,
+            m_constraint.detection_method);
+
+    UnionFind body_sets(num_bodies());
+    std::vector<bool> has_close_body(num_bodies(), false);
+    for (const auto& [i, j] : body_pairs) {
+        has_close_body[i] = has_close_body[j] = true;
+        if (!is_static(i) && !is_static(j)) {
+            body_sets.merge(i, j);
+        }
+    }
+
+    // Bodies without any close body converge in a few iterations, so they
+    // are gathered in a single island instead of a problem per body.
+    int free_body = -1;
+    for (int i = 0; i < num_bodies(); i++) {
+        if (!is_static(i) && !has_close_body[i]) {
+            if (free_body < 0) {
+                free_body = i;
+            } else {
+                body_sets.merge(free_body, i);
+            }
+        }
+    }
+
+    std::vector<int> labels;
+    std::vector<std::vector<int>> islands(body_sets.components(labels));
+    for (int i = 0; i < num_bodies(); i++) {
+        if (!is_static(i)) {
+            islands[labels[i]].push_back(i);
+        }
+    }
+    for (const auto& [i, j] : body_pairs) {
+        if (is_static(i) != is_static(j)) {
+            islands[labels[is_static(i) ? j : i]].push_back(
+                is_static(i) ? i : j);
+        }
+    }
+
+    // Remove the sets of only static bodies
+    islands.erase(
+        std::remove_if(
+            islands.begin(), islands.end(),
+            [](const std::vector<int>& island) { return island.empty(); }),
+        islands.end());
+    for (std::vector<int>& island : islands) {
+        std::sort(island.begin(), island.end());
+        island.erase(std::unique(island.begin(), island.end()), island.end());
+    }
+    return islands;
+}
+
+std::unique_ptr<DistanceBarrierRBProblem>
+DistanceBarrierRBProblem::make_island_problem(
+    const std::vector<int>& body_ids) const
+{
+    auto island = std::make_unique<DistanceBarrierRBProblem>();
+
+    island->m_constraint.settings(m_constraint.settings());
+
+    // Each island needs its own solver because solvers store their state
+    const std::string solver_name = m_solver_settings["solver"];
+    island->m_opt_solver =
+        SolverFactory::factory().create_barrier_solver(solver_name);
+    island->m_opt_solver->settings(m_solver_settings[solver_name]);
+    island->m_opt_solver->set_problem(*island);
+    if (island->m_opt_solver->has_inner_solver()) {
+        island->m_opt_solver->inner_solver().settings(
+            m_solver_settings[island->m_opt_solver->inner_solver().name()]);
+    }
+
+    island->use_contact_islands = false;
+    island->do_intersection_check = false;
+
+    std::vector<RigidBody> rbs;
+    rbs.reserve(body_ids.size());
+    for (int body_id : body_ids) {
+        rbs.push_back(m_assembler[body_id]);
+    }
+    island->m_assembler.init(rbs);
+
+    // The bodies were just copied, so this cannot fail
+    update_island_problem(*island, body_ids);
+    return island;
+}
+
+bool DistanceBarrierRBProblem::update_island_problem(
+    DistanceBarrierRBProblem& island, const std::vector<int>& body_ids) const
+{
+    assert(island.num_bodies() == body_ids.size());
+
+    // Copy the state of the bodies but not their meshes
+    for (size_t i = 0; i < body_ids.size(); i++) {
+        const RigidBody& body = m_assembler[body_ids[i]];
+        RigidBody& island_body = island.m_assembler[i];
+        // The assembler of the island caches the fixed DoF of its bodies
+        if (island_body.type != body.type
+            || island_body.is_dof_fixed != body.is_dof_fixed) {
+            return false;
+        }
+        island_body.pose = body.pose;
+        island_body.pose_prev = body.pose_prev;
+        island_body.velocity = body.velocity;
+        island_body.velocity_prev = body.velocity_prev;
+        island_body.Qdot = body.Qdot;
+        island_body.acceleration = body.acceleration;
+        island_body.Qddot = body.Qddot;
+        island_body.force = body.force;
+        island_body.kinematic_max_time = body.kinematic_max_time;
+        island_body.kinematic_poses = body.kinematic_poses;
+    }
+
+    island.static_friction_speed_bound = static_friction_speed_bound;
+    island.friction_iterations = friction_iterations;
+    island.body_energy_integration_method = body_energy_integration_method;
+    island.m_use_barriers = m_use_barriers;
+
+    island.coefficient_restitution = coefficient_restitution;
+    island.coefficient_friction = coefficient_friction;
+    island.gravity = gravity;
+    island.collision_eps = collision_eps;
+    island.m_timestep = m_timestep;
+    island.m_kinematic_pose_timestep = m_kinematic_pose_timestep;
+    island.m_kinematic_pose_time = m_kinematic_pose_time;
+    island.m_had_collisions = false;
+    island.m_num_contacts = 0;
+
+    // The bodies were already woken by this problem
+    island.m_is_body_sleeping.resize(body_ids.size());
+    for (size_t i = 0; i < body_ids.size(); i++) {
+        island.m_is_body_sleeping[i] = is_body_sleeping(body_ids[i]);
+    }
+    island.sleep_steps = sleep_steps;
+    island.sleep_linear_velocity_threshold = sleep_linear_velocity_threshold;
+    island.sleep_angular_velocity_threshold = sleep_angular_velocity_threshold;
+    island.m_body_rest_steps.resize(body_ids.size());
+    for (size_t i = 0; i < body_ids.size(); i++) {
+        island.m_body_rest_steps[i] =
+            size_t(body_ids[i]) < m_body_rest_steps.size()
+            ? m_body_rest_steps[body_ids[i]]
+            : 0;
+    }
+
+    // Use the scales of the whole scene, so the objective scaling, the
+    // barrier stiffness bounds, and the tolerances are the same as solving
+    // all bodies together. The stiffness is needed before update_constraints()
+    // to compute the friction normal forces.
+    island.m_assembler.average_mass = m_assembler.average_mass;
+    island.init_bbox_diagonal = init_bbox_diagonal;
+    island.m_barrier_stiffness = m_barrier_stiffness;
+
+    island.update_constraints();
+    if (x0_prev.size() == x0.size()) {
+        const int ndof = PoseD::dim_to_ndof(dim());
+        island.x0_prev.resize(ndof * body_ids.size());
+        for (size_t i = 0; i < body_ids.size(); i++) {
+            island.x0_prev.segment(ndof * i, ndof) =
+                x0_prev.segment(ndof * body_ids[i], ndof);
+        }
+    } else {
+        island.x0_prev.resize(0);
+    }
+    return true;
+}
+
+bool DistanceBarrierRBProblem::solve_contact_islands(
+    OptimizationResults& opt_result)
+{
+    PROFILE_POINT("DistanceBarrierRBProblem::solve_contact_islands");
+    PROFILE_START();
+
+    const std::vector<std::vector<int>> islands = compute_contact_islands();
+    if (islands.size() <= 1) {
+        m_island_problems.clear();
+        PROFILE_END();
+        return false;
+    }
+
+    // Keep the problems of the islands whose bodies did not change, and drop
+    // the others.
+    IslandProblems previous_island_problems;
+    std::swap(previous_island_problems, m_island_problems);
+    std::vector<std::unique_ptr<DistanceBarrierRBProblem>*> island_problems(
+        islands.size());
+    for (size_t i = 0; i < islands.size(); i++) {
+        auto previous = previous_island_problems.find(islands[i]);
+        island_problems[i] = &m_island_problems[islands[i]];
+        if (previous != previous_island_problems.end()) {
+            *island_problems[i] = std::move(previous->second);
+        }
+    }
+
+    std::vector<OptimizationResults> island_results(islands.size());
+    auto solve_islands = [&](const tbb::blocked_range<size_t>& range) {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            std::unique_ptr<DistanceBarrierRBProblem>& island =
+                *island_problems[i];
+            if (!island || !update_island_problem(*island, islands[i])) {
+                island = make_island_problem(islands[i]);
+            }
+            island_results[i] = island->solve_constraints();
+        }
+    };
+#ifdef RIGID_IPC_PROFILE_FUNCTIONS
+    // The profiler is not thread-safe.
+    solve_islands(tbb::blocked_range<size_t>(size_t(0), islands.size()));
+#else
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), islands.size(), /*grainsize=*/1),
+        solve_islands);
+#endif
+
+    // Scatter the solution of each island into the DoF of the scene
+    const int ndof = PoseD::dim_to_ndof(dim());
+    Eigen::VectorXd x = starting_point();
+    std::vector<int> body_island(num_bodies(), -1);
+    for (size_t i = 0; i < islands.size(); i++) {
+        if (!island_results[i].success) {
+            spdlog::warn(
+                "failed to solve contact island {:d} of {:d} bodies; solving "
+                "all bodies together",
+                i, islands[i].size());
+            PROFILE_END();
+            return false;
+        }
+        for (size_t k = 0; k < islands[i].size(); k++) {
+            const int body_id = islands[i][k];
+            if (m_assembler[body_id].type == RigidBodyType::STATIC
+                || is_body_sleeping(body_id)) {
+                continue;
+            }
+            body_island[body_id] = i;
+            x.segment(ndof * body_id, ndof) =
+                island_results[i].x.segment(ndof * k, ndof);
+        }
+    }
+
+    // The islands were predicted from the unconstrained motion. If a body
+    // ended up close to a body of another island, then the islands were not
+    // independent and the scene has to be solved as a single problem.
+    const std::vector<std::pair<int, int>> body_pairs =
+        m_assembler.close_bodies(
+            poses_t0, this->dofs_to_poses(x),
+            barrier_activation_distance()
+                + m_constraint.minimum_separation_distance,
+            m_constraint.detection_method);
+    for (const auto& [i, j] : body_pairs) {
+        bool is_coupled;
+        if (body_island[i] >= 0 && body_island[j] >= 0) {
+            is_coupled = body_island[i] != body_island[j];
+        } else if (body_island[i] >= 0 || body_island[j] >= 0) {
+            // A static body has to be part of the island it touches
+            const int static_body = body_island[i] < 0 ? i : j;
+            const std::vector<int>& island =
+                islands[std::max(body_island[i], body_island[j])];
+            is_coupled =
+                !std::binary_search(island.begin(), island.end(), static_body);
+        } else {
+            is_coupled = false;
+        }
+        if (is_coupled) {
+            spdlog::info(
+                "contact islands interact (bodies {:d} and {:d}); solving all "
+                "bodies together",
+                i, j);
+            PROFILE_END();
+            return false;
+        }
+    }
+
+    opt_result.x = x;
+    opt_result.minf = 0;
+    opt_result.success = true;
+    opt_result.finished = true;
+    // The islands are solved in parallel, so the longest solve sets the cost.
+    opt_result.num_iterations = 0;
+    opt_result.min_ccd_step_size = 1;
+    for (size_t i = 0; i < islands.size(); i++) {
+        opt_result.minf += island_results[i].minf;
+        opt_result.finished &= island_results[i].finished;
+        opt_result.num_iterations = std::max(
+            opt_result.num_iterations, island_results[i].num_iterations);
+        opt_result.min_ccd_step_size = std::min(
+            opt_result.min_ccd_step_size, island_results[i].min_ccd_step_size);
+        m_had_collisions |= (*island_problems[i])->m_had_collisions;
+        m_num_contacts += (*island_problems[i])->m_num_contacts;
+    }
+
+    spdlog::info(
+        "solved {:d} contact islands in {:d} iteration(s)", islands.size(),
+        opt_result.num_iterations);
+
+    PROFILE_END();
+    return true;
+}
+
 bool DistanceBarrierRBProblem::take_step(const Eigen::VectorXd& x)
 {
     min_distance = compute_min_distance(x);
@@ -637,26 +1263,53 @@ double DistanceBarrierRBProblem::compute_objective(
     bool compute_grad,
     bool compute_hess)
 {
-    // Compute rigid body energy term
-    double Ex = compute_energy_term(x, grad, hess, compute_grad, compute_hess);
-    Ex /= average_mass();
-    if (compute_grad) {
-        grad /= average_mass();
-    }
+    // Assemble the Hessian from body-pair blocks. While the set of
+    // interacting bodies is unchanged this only overwrites the values of hess
+    // and keeps its storage.
+    BlockSparseMatrix hess_blocks;
+    double fx =
+        compute_objective_terms(x, grad, hess_blocks, compute_grad, compute_hess);
     if (compute_hess) {
-        hess /= average_mass();
+        hess_blocks.to_sparse(hess);
     }
+    return fx;
+}
+
+double DistanceBarrierRBProblem::compute_objective_blocks(
+    const Eigen::VectorXd& x, Eigen::VectorXd& grad, BlockSparseMatrix& hess)
+{
+    return compute_objective_terms(
+        x, grad, hess, /*compute_grad=*/true, /*compute_hess=*/true);
+}
+
+double DistanceBarrierRBProblem::compute_objective_terms(
+    const Eigen::VectorXd& x,
+    Eigen::VectorXd& grad,
+    BlockSparseMatrix& hess,
+    bool compute_grad,
+    bool compute_hess)
+{
+    // Compute rigid body energy term
+    Eigen::SparseMatrix<double> hess_Ex;
+    double Ex = compute_energy_term(x, grad, hess_Ex, compute_grad, compute_hess);
 
     Eigen::VectorXd grad_AL;
     Eigen::SparseMatrix<double> hess_AL;
-    double ALx = compute_augmented_lagrangian(
+    Ex += compute_augmented_lagrangian(
         x, grad_AL, hess_AL, compute_grad, compute_hess);
-    Ex += ALx / average_mass();
+
+    // The Hessians of the body energies and augmented Lagrangian are block
+    // diagonal, so they are cheap to add to the blocks.
+    Ex /= average_mass();
     if (compute_grad) {
-        grad += grad_AL / average_mass();
+        grad += grad_AL;
+        grad /= average_mass();
     }
     if (compute_hess) {
-        hess += hess_AL / average_mass();
+        hess = BlockSparseMatrix(num_bodies(), PoseD::dim_to_ndof(dim()));
+        hess += hess_Ex;
+        hess += hess_AL;
+        hess *= 1 / average_mass();
     }
 
     // The following is used to disable constraints if desired
@@ -680,15 +1333,15 @@ double DistanceBarrierRBProblem::compute_objective(
         constraints.fv_constraints.size());
 
     Eigen::VectorXd grad_Bx;
-    Eigen::SparseMatrix<double> hess_Bx;
+    BlockSparseMatrix hess_Bx;
     double Bx = compute_barrier_term(
         x, constraints, grad_Bx, hess_Bx, compute_grad, compute_hess);
 
     // D(x) is the friction potential (Equation 15 in the IPC paper)
     Eigen::VectorXd grad_Dx;
-    Eigen::SparseMatrix<double> hess_Dx;
-    double Dx =
-        compute_friction_term(x, grad_Dx, hess_Dx, compute_grad, compute_hess);
+    BlockSparseMatrix hess_Dx;
+    double Dx = compute_friction_term(
+        x, grad_Dx, hess_Dx, compute_grad, compute_hess);
 
     // Sum all the potentials
     double kappa_over_avg_mass = barrier_stiffness() / average_mass();
@@ -696,7 +1349,10 @@ double DistanceBarrierRBProblem::compute_objective(
         grad += kappa_over_avg_mass * grad_Bx + grad_Dx / average_mass();
     }
     if (compute_hess) {
-        hess += kappa_over_avg_mass * hess_Bx + hess_Dx / average_mass();
+        hess_Bx *= kappa_over_avg_mass;
+        hess_Dx *= 1 / average_mass();
+        hess += hess_Bx;
+        hess += hess_Dx;
     }
 
     return Ex + kappa_over_avg_mass * Bx + Dx / average_mass();
@@ -1155,25 +1811,20 @@ void local_gradient_to_global(
 }
 
 template <typename DerivedLocalHessian>
-void local_hessian_to_global_triplets(
+void local_hessian_to_global_blocks(
     const Eigen::MatrixBase<DerivedLocalHessian>& local_hessian,
     const std::array<long, 2>& body_ids,
     int ndof,
-    std::vector<Eigen::Triplet<double>>& triplets)
+    BlockSparseMatrix& hess_blocks)
 {
     assert(local_hessian.rows() == 2 * ndof);
     assert(local_hessian.cols() == 2 * ndof);
+    assert(hess_blocks.block_size() == ndof);
     for (int b_i = 0; b_i < body_ids.size(); b_i++) {
         for (int b_j = 0; b_j < body_ids.size(); b_j++) {
-            for (int dof_i = 0; dof_i < ndof; dof_i++) {
-                for (int dof_j = 0; dof_j < ndof; dof_j++) {
-                    double v =
-                        local_hessian(ndof * b_i + dof_i, ndof * b_j + dof_j);
-                    int r = ndof * body_ids[b_i] + dof_i;
-                    int c = ndof * body_ids[b_j] + dof_j;
-                    triplets.emplace_back(r, c, v);
-                }
-            }
+            hess_blocks.add_block(
+                body_ids[b_i], body_ids[b_j],
+                local_hessian.block(ndof * b_i, ndof * b_j, ndof, ndof));
         }
     }
 }
@@ -1181,15 +1832,14 @@ void local_hessian_to_global_triplets(
 // Apply the chain rule of f(V(x)) given ∇ᵥf(V) and ∇ₓV(x)
 void apply_chain_rule(
     const VectorMax12d& grad_f,
-    const Eigen::MatrixXd& jac_V,
     const MatrixMax12d& hess_f,
-    const Eigen::MatrixXd& hess_V,
+    const WorldVerticesDiff& V_diff,
     const std::vector<long>& vertex_ids,
     const std::vector<uint8_t>& local_body_ids,
     const std::array<long, 2>& body_ids,
     const int dim,
     Eigen::VectorXd& grad,
-    std::vector<Eigen::Triplet<double>>& hess_triplets,
+    BlockSparseMatrix& hess_blocks,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1207,7 +1857,7 @@ void apply_chain_rule(
         VectorMax12d local_grad = VectorMax12d::Zero(2 * rb_ndof);
         for (int i = 0; i < vertex_ids.size(); i++) {
             local_grad.segment(rb_ndof * local_body_ids[i], rb_ndof) +=
-                jac_V.middleRows(vertex_ids[i] * dim, dim).transpose()
+                V_diff.vertex_jacobian(vertex_ids[i]).transpose()
                 * grad_f.segment(i * dim, dim);
         }
 
@@ -1220,7 +1870,7 @@ void apply_chain_rule(
             MatrixMax12d::Zero(vertex_ids.size() * dim, 2 * rb_ndof);
         for (int i = 0; i < vertex_ids.size(); i++) {
             jac_Vi.block(i * dim, local_body_ids[i] * rb_ndof, dim, rb_ndof) =
-                jac_V.middleRows(vertex_ids[i] * dim, dim);
+                V_diff.vertex_jacobian(vertex_ids[i]);
         }
 
         // hess ∈ R^{2m × 2m}
@@ -1232,16 +1882,14 @@ void apply_chain_rule(
                 hess.block(
                     local_body_ids[i] * rb_ndof, local_body_ids[i] * rb_ndof,
                     rb_ndof, rb_ndof) +=
-                    hess_V.middleRows(
-                        rb_ndof * (vertex_ids[i] * dim + j), rb_ndof)
+                    V_diff.vertex_hessian(vertex_ids[i], j)
                     * grad_f[i * dim + j];
             }
         }
 
         hess = project_to_psd(hess);
 
-        local_hessian_to_global_triplets(
-            hess, body_ids, rb_ndof, hess_triplets);
+        local_hessian_to_global_blocks(hess, body_ids, rb_ndof, hess_blocks);
     }
 
     // PROFILE_END();
@@ -1249,10 +1897,15 @@ void apply_chain_rule(
 
 struct PotentialStorage {
     PotentialStorage() {}
-    PotentialStorage(size_t nvars) { gradient.setZero(nvars); }
+    PotentialStorage(size_t nvars, int rb_ndof)
+        : hessian_blocks(nvars / rb_ndof, rb_ndof)
+    {
+        gradient.setZero(nvars);
+    }
     double potential = 0;
     Eigen::VectorXd gradient;
-    std::vector<Eigen::Triplet<double>> hessian_triplets;
+    /// Hessian accumulated in rb_ndof × rb_ndof blocks per body pair
+    BlockSparseMatrix hessian_blocks;
 };
 typedef tbb::enumerable_thread_specific<PotentialStorage>
     ThreadSpecificPotentials;
@@ -1260,8 +1913,9 @@ typedef tbb::enumerable_thread_specific<PotentialStorage>
 double merge_derivative_storage(
     const ThreadSpecificPotentials& potentials,
     size_t nvars,
+    int rb_ndof,
     Eigen::VectorXd& grad,
-    Eigen::SparseMatrix<double>& hess,
+    BlockSparseMatrix& hess_blocks,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1271,11 +1925,10 @@ double merge_derivative_storage(
     if (compute_grad) {
         grad.setZero(nvars);
     }
-    if (compute_hess) {
-        hess.resize(nvars, nvars);
-    }
 
     double potential = 0;
+    // No thread may add to the Hessian
+    hess_blocks = BlockSparseMatrix(nvars / rb_ndof, rb_ndof);
     for (const auto& p : potentials) {
         potential += p.potential;
 
@@ -1284,10 +1937,11 @@ double merge_derivative_storage(
         }
 
         if (compute_hess) {
-            Eigen::SparseMatrix<double> p_hess(nvars, nvars);
-            p_hess.setFromTriplets(
-                p.hessian_triplets.begin(), p.hessian_triplets.end());
-            hess += p_hess;
+            if (hess_blocks.num_nonzero_blocks() == 0) {
+                hess_blocks = p.hessian_blocks;
+            } else {
+                hess_blocks += p.hessian_blocks;
+            }
         }
     }
 
@@ -1296,6 +1950,20 @@ double merge_derivative_storage(
     return potential;
 }
 
+// Compute a term with its Hessian as blocks and assemble the CSC matrix once,
+// reusing hess's pattern if possible.
+template <typename BlockTerm>
+double assemble_term_hessian(
+    BlockTerm term, Eigen::SparseMatrix<double>& hess, bool compute_hess)
+{
+    BlockSparseMatrix hess_blocks;
+    double potential = term(hess_blocks);
+    if (compute_hess) {
+        hess_blocks.to_sparse(hess);
+    }
+    return potential;
+}
+
 double DistanceBarrierRBProblem::compute_barrier_term(
     const Eigen::VectorXd& x,
     const Constraints& constraints,
@@ -1304,9 +1972,42 @@ double DistanceBarrierRBProblem::compute_barrier_term(
     bool compute_grad,
     bool compute_hess)
 {
+    double potential = assemble_term_hessian(
+        [&](BlockSparseMatrix& hess_blocks) {
+            return compute_barrier_term(
+                x, constraints, grad, hess_blocks, compute_grad, compute_hess);
+        },
+        hess, compute_hess);
+
+#ifdef RIGID_IPC_WITH_DERIVATIVE_CHECK
+    if (!is_checking_derivative) {
+        is_checking_derivative = true;
+        if (compute_grad) {
+            check_barrier_gradient(x, constraints, grad);
+        }
+        if (compute_hess) {
+            check_barrier_hessian(x, constraints, hess);
+        }
+        is_checking_derivative = false;
+    }
+#endif
+
+    return potential;
+}
+
+double DistanceBarrierRBProblem::compute_barrier_term(
+    const Eigen::VectorXd& x,
+    const Constraints& constraints,
+    Eigen::VectorXd& grad,
+    BlockSparseMatrix& hess,
+    bool compute_grad,
+    bool compute_hess)
+{
+    int rb_ndof = PoseD::dim_to_ndof(dim());
+
     if (constraints.size() == 0) {
         grad.setZero(x.size());
-        hess.resize(x.size(), x.size());
+        hess = BlockSparseMatrix(x.size() / rb_ndof, rb_ndof);
         return 0;
     }
 
@@ -1324,16 +2025,16 @@ double DistanceBarrierRBProblem::compute_barrier_term(
 
     PROFILE_START();
 
-    int rb_ndof = PoseD::dim_to_ndof(dim());
-
-    // Compute V(x)
-    Eigen::MatrixXd jac_V, hess_V;
-    Eigen::MatrixXd V = m_assembler.world_vertices_diff(
-        x, jac_V, hess_V, compute_grad || compute_hess, compute_hess);
+    // Compute V(x) and the derivatives of the rotations. The derivatives of
+    // the vertices are only evaluated for the vertices of the constraints.
+    WorldVerticesDiff V_diff(
+        m_assembler, PoseD::dofs_to_poses(x, dim()), compute_grad,
+        compute_hess);
+    const Eigen::MatrixXd& V = V_diff.vertices();
 
     double dhat = barrier_activation_distance();
 
-    ThreadSpecificPotentials thread_storage(x.size());
+    ThreadSpecificPotentials thread_storage(x.size(), rb_ndof);
     tbb::parallel_for(
         tbb::blocked_range<size_t>(size_t(0), constraints.size()),
         [&](const tbb::blocked_range<size_t>& range) {
@@ -1341,7 +2042,7 @@ double DistanceBarrierRBProblem::compute_barrier_term(
             auto& local_storage = thread_storage.local();
             auto& potential = local_storage.potential;
             auto& local_grad = local_storage.gradient;
-            auto& hess_triplets = local_storage.hessian_triplets;
+            auto& hess_blocks = local_storage.hessian_blocks;
 
             for (size_t ci = range.begin(); ci != range.end(); ++ci) {
                 const auto& constraint = constraints[ci];
@@ -1369,32 +2070,20 @@ double DistanceBarrierRBProblem::compute_barrier_term(
                 }
 
                 apply_chain_rule(
-                    grad_B, jac_V, hess_B, hess_V,
+                    grad_B, hess_B, V_diff,
                     constraint.vertex_indices(edges(), faces()),
                     vertex_local_body_ids(constraints, ci),
                     body_ids(m_assembler, constraints, ci), dim(), local_grad,
-                    hess_triplets, compute_grad, compute_hess);
+                    hess_blocks, compute_grad, compute_hess);
             }
         });
 
     double potential = merge_derivative_storage(
-        thread_storage, x.size(), grad, hess, compute_grad, compute_hess);
+        thread_storage, x.size(), rb_ndof, grad, hess, compute_grad,
+        compute_hess);
 
     PROFILE_END();
 
-#ifdef RIGID_IPC_WITH_DERIVATIVE_CHECK
-    if (!is_checking_derivative) {
-        is_checking_derivative = true;
-        if (compute_grad) {
-            check_barrier_gradient(x, constraints, grad);
-        }
-        if (compute_hess) {
-            check_barrier_hessian(x, constraints, hess);
-        }
-        is_checking_derivative = false;
-    }
-#endif
-
     return potential;
 }
 
@@ -1410,11 +2099,10 @@ double DistanceBarrierRBProblem::compute_barrier_term(
 template <typename RigidBodyConstraint, typename FrictionConstraint>
 double DistanceBarrierRBProblem::compute_friction_potential(
     const Eigen::MatrixXd& U,
-    const Eigen::MatrixXd& jac_V,
-    const Eigen::MatrixXd& hess_V,
+    const WorldVerticesDiff& V_diff,
     const FrictionConstraint& constraint,
     Eigen::VectorXd& grad,
-    std::vector<Eigen::Triplet<double>>& hess_triplets,
+    BlockSparseMatrix& hess_blocks,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1458,10 +2146,10 @@ double DistanceBarrierRBProblem::compute_friction_potential(
 
     RigidBodyConstraint rbc(m_assembler, constraint);
     apply_chain_rule(
-        grad_D, jac_V, hess_D, hess_V,
+        grad_D, hess_D, V_diff,
         constraint.vertex_indices(edges(), faces()),
         rbc.vertex_local_body_ids(), rbc.body_ids(), dim(), //
-        grad, hess_triplets, compute_grad, compute_hess);
+        grad, hess_blocks, compute_grad, compute_hess);
 
     return Dx;
 }
@@ -1473,21 +2161,52 @@ double DistanceBarrierRBProblem::compute_friction_term(
     bool compute_grad,
     bool compute_hess)
 {
+    double potential = assemble_term_hessian(
+        [&](BlockSparseMatrix& hess_blocks) {
+            return compute_friction_term(
+                x, grad, hess_blocks, compute_grad, compute_hess);
+        },
+        hess, compute_hess);
+
+#ifdef RIGID_IPC_WITH_DERIVATIVE_CHECK
+    if (!is_checking_derivative) {
+        is_checking_derivative = true;
+        if (compute_grad) {
+            check_friction_gradient(x, grad);
+        }
+        if (compute_hess) {
+            check_friction_hessian(x, hess);
+        }
+        is_checking_derivative = false;
+    }
+#endif
+
+    return potential;
+}
+
+double DistanceBarrierRBProblem::compute_friction_term(
+    const Eigen::VectorXd& x,
+    Eigen::VectorXd& grad,
+    BlockSparseMatrix& hess,
+    bool compute_grad,
+    bool compute_hess)
+{
+    int rb_ndof = PoseD::dim_to_ndof(dim());
+
     if (coefficient_friction <= 0 || friction_constraints.size() == 0) {
         grad.setZero(x.size());
-        hess.resize(x.size(), x.size());
+        hess = BlockSparseMatrix(x.size() / rb_ndof, rb_ndof);
         return 0;
     }
 
     PROFILE_POINT("DistanceBarrierRBProblem::compute_friction_term");
     PROFILE_START();
 
-    int rb_ndof = PoseD::dim_to_ndof(dim());
-
-    // Compute V(x)
-    Eigen::MatrixXd jac_V, hess_V;
-    Eigen::MatrixXd V1 = m_assembler.world_vertices_diff(
-        x, jac_V, hess_V, compute_grad || compute_hess, compute_hess);
+    // Compute V(x) and the derivatives of the rotations
+    WorldVerticesDiff V_diff(
+        m_assembler, PoseD::dofs_to_poses(x, dim()), compute_grad,
+        compute_hess);
+    const Eigen::MatrixXd& V1 = V_diff.vertices();
 
     NAMED_PROFILE_POINT(
         "DistanceBarrierRBProblem::compute_friction_term:displacement",
@@ -1497,7 +2216,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
     Eigen::MatrixXd U = V1 - m_assembler.world_vertices(poses_t0);
     PROFILE_END(DISPLACEMENT);
 
-    ThreadSpecificPotentials thread_storage(x.size());
+    ThreadSpecificPotentials thread_storage(x.size(), rb_ndof);
     tbb::parallel_for(
         tbb::blocked_range<size_t>(size_t(0), friction_constraints.size()),
         [&](const tbb::blocked_range<size_t>& range) {
@@ -1505,7 +2224,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
             auto& local_storage = thread_storage.local();
             auto& potential = local_storage.potential;
             auto& local_grad = local_storage.gradient;
-            auto& hess_triplets = local_storage.hessian_triplets;
+            auto& hess_blocks = local_storage.hessian_blocks;
 
             for (size_t ci = range.begin(); ci != range.end(); ++ci) {
                 size_t local_ci = ci;
@@ -1513,9 +2232,9 @@ double DistanceBarrierRBProblem::compute_friction_term(
                 if (local_ci < friction_constraints.vv_constraints.size()) {
                     potential += compute_friction_potential<
                         RigidBodyVertexVertexConstraint>(
-                        U, jac_V, hess_V,
+                        U, V_diff,
                         friction_constraints.vv_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
+                        local_grad, hess_blocks, compute_grad, compute_hess);
                     continue;
                 }
 
@@ -1523,9 +2242,9 @@ double DistanceBarrierRBProblem::compute_friction_term(
                 if (local_ci < friction_constraints.ev_constraints.size()) {
                     potential += compute_friction_potential<
                         RigidBodyEdgeVertexConstraint>(
-                        U, jac_V, hess_V,
+                        U, V_diff,
                         friction_constraints.ev_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
+                        local_grad, hess_blocks, compute_grad, compute_hess);
                     continue;
                 }
 
@@ -1533,9 +2252,9 @@ double DistanceBarrierRBProblem::compute_friction_term(
                 if (local_ci < friction_constraints.ee_constraints.size()) {
                     potential +=
                         compute_friction_potential<RigidBodyEdgeEdgeConstraint>(
-                            U, jac_V, hess_V,
+                            U, V_diff,
                             friction_constraints.ee_constraints[local_ci],
-                            local_grad, hess_triplets, compute_grad,
+                            local_grad, hess_blocks, compute_grad,
                             compute_hess);
                     continue;
                 }
@@ -1544,30 +2263,18 @@ double DistanceBarrierRBProblem::compute_friction_term(
                 assert(local_ci < friction_constraints.fv_constraints.size());
                 potential +=
                     compute_friction_potential<RigidBodyFaceVertexConstraint>(
-                        U, jac_V, hess_V,
+                        U, V_diff,
                         friction_constraints.fv_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
+                        local_grad, hess_blocks, compute_grad, compute_hess);
             }
         });
 
     double potential = merge_derivative_storage(
-        thread_storage, x.size(), grad, hess, compute_grad, compute_hess);
+        thread_storage, x.size(), rb_ndof, grad, hess, compute_grad,
+        compute_hess);
 
     PROFILE_END();
 
-#ifdef RIGID_IPC_WITH_DERIVATIVE_CHECK
-    if (!is_checking_derivative) {
-        is_checking_derivative = true;
-        if (compute_grad) {
-            check_friction_gradient(x, grad);
-        }
-        if (compute_hess) {
-            check_friction_hessian(x, hess);
-        }
-        is_checking_derivative = false;
-    }
-#endif
-
     return potential;
 }
 
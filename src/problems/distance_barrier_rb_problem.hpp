@@ -1,5 +1,9 @@
 #pragma once
 
+#include <map>
+#include <memory>
+#include <vector>
+
 #include <tbb/concurrent_vector.h>
 
 #include <ipc/collision_constraint.hpp>
@@ -9,8 +13,10 @@
 #include <opt/distance_barrier_constraint.hpp>
 #include <opt/optimization_problem.hpp>
 #include <physics/rigid_body_problem.hpp>
+#include <physics/world_vertices_diff.hpp>
 #include <problems/rigid_body_collision_constraint.hpp>
 #include <solvers/homotopy_solver.hpp>
+#include <utils/block_sparse_matrix.hpp>
 #include <utils/multiprecision.hpp>
 
 namespace ipc::rigid {
@@ -42,7 +48,10 @@ public:
     bool settings(const nlohmann::json& params) override;
     nlohmann::json settings() const override;
 
+    /// Get the current state, including which bodies are sleeping
     nlohmann::json state() const override;
+    /// Set the current state, including which bodies are sleeping
+    void state(const nlohmann::json& s) override;
 
     static std::string problem_name() { return "distance_barrier_rb_problem"; }
 
@@ -78,6 +87,16 @@ public:
 
     Eigen::VectorXi free_dof() const override;
 
+    /// @returns The number of DoF of a body.
+    int hessian_block_size() const override
+    {
+        return PoseD::dim_to_ndof(dim());
+    }
+
+    /// @brief Extrapolate the previous time-step, clipped by CCD, when
+    /// x is the start of a time-step.
+    Eigen::VectorXd warm_start_point(const Eigen::VectorXd& x) override;
+
     /// Determine if there is a collision between two configurations
     bool has_collisions(
         const Eigen::VectorXd& x_i, const Eigen::VectorXd& x_j) override;
@@ -127,6 +146,12 @@ public:
         bool compute_grad = true,
         bool compute_hess = true) override;
 
+    /// Compute f(x) with the contact Hessians kept as body-pair blocks
+    double compute_objective_blocks(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad,
+        BlockSparseMatrix& hess) override;
+
     /// Compute E(x) in f(x) = E(x) + κ ∑_{k ∈ C} b(d(x_k))
     double compute_energy_term(
         const Eigen::VectorXd& x,
@@ -151,6 +176,14 @@ public:
         bool compute_grad = true,
         bool compute_hess = true);
 
+    /// Compute the friction term with its Hessian as body-pair blocks
+    double compute_friction_term(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad,
+        BlockSparseMatrix& hess,
+        bool compute_grad,
+        bool compute_hess);
+
     virtual double compute_friction_term(const Eigen::VectorXd& x) final
     {
         Eigen::VectorXd grad;
@@ -172,6 +205,7 @@ public:
     // (http://www.cplusplus.com/forum/beginner/24978/)
     using BarrierProblem::compute_barrier_term;
     using BarrierProblem::compute_energy_term;
+    using BarrierProblem::compute_objective;
 
     /// Compute the minimum distance among geometry
     double compute_min_distance() const override;
@@ -207,6 +241,16 @@ public:
 
     int num_contacts() const override { return m_num_contacts; };
 
+    ////////////////////////////////////////////////////////////
+    // Sleeping bodies
+
+    /// @brief Is the body frozen in place until a moving body touches it?
+    bool is_body_sleeping(size_t body_id) const
+    {
+        return body_id < m_is_body_sleeping.size()
+            && m_is_body_sleeping[body_id];
+    }
+
     ////////////////////////////////////////////////////////////
     // Augmented Lagrangian for equality constraints
 
@@ -215,6 +259,15 @@ public:
     /// Update the target poses of kinematic bodies
     void step_kinematic_bodies();
 
+    /// @brief Time between consecutive scripted kinematic poses.
+    double kinematic_pose_timestep() const;
+
+    /// @brief Scripted pose of a kinematic body at the end of this step.
+    ///
+    /// Scripted poses are spaced by the frame time-step, so steps of any
+    /// size interpolate between the poses around their end time.
+    PoseD kinematic_target_pose(int body_id) const;
+
     /// Update the augmented Lagrangian for kinematic bodies.
     void update_augmented_lagrangian(const Eigen::VectorXd& x) override;
 
@@ -237,6 +290,16 @@ public:
         bool compute_grad,
         bool compute_hess);
 
+    /// @brief Compute f(x) and its derivatives with the Hessian as body-pair
+    /// blocks. Both compute_objective() and compute_objective_blocks() use
+    /// this, so they always agree.
+    double compute_objective_terms(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad,
+        BlockSparseMatrix& hess,
+        bool compute_grad,
+        bool compute_hess);
+
 protected:
     /// Update problem using current status of bodies.
     virtual void update_constraints() override;
@@ -245,6 +308,52 @@ protected:
     void update_friction_constraints(
         const Constraints& collision_constraints, const PosesD& poses);
 
+    /// @brief Is the body moving or about to move?
+    ///
+    /// Kinematic bodies are always restless, and dynamic bodies are restless
+    /// until they have been at rest for sleep_steps steps.
+    bool is_body_restless(size_t body_id) const;
+
+    /// @brief Count the steps each body has been at rest and put to sleep the
+    /// bodies at rest whose close bodies are not restless.
+    ///
+    /// A body without contacts only sleeps if no external force acts on it.
+    void sleep_resting_bodies();
+
+    /// @brief Wake the sleeping bodies that may touch a restless body during
+    /// this step, and fix the DoF of the bodies still sleeping.
+    void wake_sleeping_bodies();
+
+    /// @brief Group the bodies into islands that cannot interact during this
+    /// step.
+    ///
+    /// Islands are the connected components of the bodies close to each other
+    /// along their predicted unconstrained motion. Static bodies do not couple
+    /// the bodies they touch, so they are added to every island they touch.
+    /// @returns The sorted body ids of each island.
+    std::vector<std::vector<int>> compute_contact_islands() const;
+
+    /// @brief Create a problem of only the given bodies with the same settings
+    /// as this problem.
+    ///
+    /// The island keeps this problem's average mass, bounding box diagonal,
+    /// and barrier stiffness instead of computing them from its own bodies.
+    std::unique_ptr<DistanceBarrierRBProblem>
+    make_island_problem(const std::vector<int>& body_ids) const;
+
+    /// @brief Bring a problem made by make_island_problem() to the current
+    /// step without copying the meshes of its bodies.
+    /// @returns False if the island has to be made again (e.g., a kinematic
+    ///          body became static).
+    bool update_island_problem(
+        DistanceBarrierRBProblem& island,
+        const std::vector<int>& body_ids) const;
+
+    /// @brief Solve each contact island as its own problem in parallel.
+    /// @param[out] opt_result The merged results of the islands.
+    /// @returns False if the scene has to be solved as a single problem.
+    bool solve_contact_islands(OptimizationResults& opt_result);
+
     template <typename T>
     T compute_body_energy(
         const RigidBody& body,
@@ -254,11 +363,10 @@ protected:
     template <typename RigidBodyConstraint, typename FrictionConstraint>
     double compute_friction_potential(
         const Eigen::MatrixXd& U,
-        const Eigen::MatrixXd& jac_V,
-        const Eigen::MatrixXd& hess_V,
+        const WorldVerticesDiff& V_diff,
         const FrictionConstraint& constraint,
         Eigen::VectorXd& grad,
-        std::vector<Eigen::Triplet<double>>& hess_triplets,
+        BlockSparseMatrix& hess_blocks,
         bool compute_grad,
         bool compute_hess);
 
@@ -272,6 +380,15 @@ protected:
         bool compute_grad,
         bool compute_hess);
 
+    /// Computes the barrier term with its Hessian as body-pair blocks.
+    double compute_barrier_term(
+        const Eigen::VectorXd& x,
+        const Constraints& distance_constraints,
+        Eigen::VectorXd& grad,
+        BlockSparseMatrix& hess,
+        bool compute_grad,
+        bool compute_hess);
+
     virtual double compute_barrier_term(
         const Eigen::VectorXd& x, const Constraints& distance_constraints) final
     {
@@ -331,6 +448,21 @@ protected:
 
     /// @brief Solver for solving this optimization problem.
     std::shared_ptr<OptimizationSolver> m_opt_solver;
+    /// @brief Settings of the solver used to create the solvers of islands.
+    nlohmann::json m_solver_settings;
+
+    /// @brief Solve independent groups of contacting bodies separately.
+    bool use_contact_islands;
+
+    typedef std::map<
+        std::vector<int>,
+        std::unique_ptr<DistanceBarrierRBProblem>>
+        IslandProblems;
+    /// @brief Problems of the contact islands of the last step by body ids.
+    ///
+    /// An island with the same bodies in the next step reuses its problem, so
+    /// its bodies, broad-phase structures, and solver are not made again.
+    IslandProblems m_island_problems;
 
     /// @brief Multiplier of barrier term in objective, \f$\kappa\f$.
     double m_barrier_stiffness;
@@ -353,12 +485,30 @@ protected:
     int friction_iterations;
     FrictionConstraints friction_constraints;
 
+    // Sleeping
+    /// @brief Number of steps at rest before a body sleeps (zero disables).
+    int sleep_steps;
+    /// @brief Maximum linear speed of a body at rest.
+    double sleep_linear_velocity_threshold;
+    /// @brief Maximum angular speed of a body at rest.
+    double sleep_angular_velocity_threshold;
+    /// @brief Number of consecutive steps each body has been at rest.
+    std::vector<int> m_body_rest_steps;
+    std::vector<bool> m_is_body_sleeping;
+
+    // Scripted kinematic motion
+    /// @brief Time between consecutive scripted kinematic poses.
+    double m_kinematic_pose_timestep;
+    /// @brief Time elapsed since the last consumed kinematic pose.
+    double m_kinematic_pose_time;
+
     // Augmented Lagrangian
     double linear_augmented_lagrangian_penalty;
     double angular_augmented_lagrangian_penalty;
     Eigen::VectorXd linear_augmented_lagrangian_multiplier;
     Eigen::MatrixXd angular_augmented_lagrangian_multiplier;
     Eigen::VectorXd x_pred; ///< Predicted DoF using unconstrained timestep
+    Eigen::VectorXd x0_prev; ///< Starting DoF of the previous timestep
     VectorXb is_dof_satisfied;
 
 private:
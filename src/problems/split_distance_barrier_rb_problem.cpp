@@ -24,7 +24,13 @@ bool SplitDistanceBarrierRBProblem::settings(const nlohmann::json& params)
     m_time_stepper = time_stepper_name == "default"
         ? TimeStepperFactory::factory().get_default_time_stepper(dim())
         : TimeStepperFactory::factory().get_time_stepper(time_stepper_name);
-    return DistanceBarrierRBProblem::settings(params);
+    bool success = DistanceBarrierRBProblem::settings(params);
+    // Island problems use the energy of DistanceBarrierRBProblem
+    if (use_contact_islands) {
+        spdlog::warn("Contact islands are not supported by {}", name());
+        use_contact_islands = false;
+    }
+    return success;
 }
 
 nlohmann::json SplitDistanceBarrierRBProblem::settings() const
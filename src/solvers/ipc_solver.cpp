@@ -1,5 +1,7 @@
 #include "ipc_solver.hpp"
 
+#include <algorithm>
+
 #include <ipc/barrier/adaptive_stiffness.hpp>
 
 #include <autodiff/autodiff_types.hpp>
@@ -9,6 +11,7 @@ namespace ipc::rigid {
 
 IPCSolver::IPCSolver()
     : NewtonSolver()
+    , warm_start(false)
 {
     convergence_criteria = ConvergenceCriteria::VELOCITY;
 }
@@ -20,7 +23,9 @@ void IPCSolver::settings(const nlohmann::json& json)
     dhat_epsilon = json["dhat_epsilon"].get<double>();
     min_barrier_stiffness_scale =
         json["min_barrier_stiffness_scale"].get<double>();
+    warm_start = json["warm_start"];
     num_kappa_updates = 0;
+    m_has_solved = false;
 }
 
 // Export the state of the solver using the settings saved in JSON
@@ -29,6 +34,7 @@ nlohmann::json IPCSolver::settings() const
     nlohmann::json json = NewtonSolver::settings();
     json["dhat_epsilon"] = dhat_epsilon;
     json["min_barrier_stiffness_scale"] = min_barrier_stiffness_scale;
+    json["warm_start"] = warm_start;
     return json;
 }
 
@@ -54,6 +60,16 @@ void IPCSolver::init_solve(const Eigen::VectorXd& x0)
     double kappa = initial_barrier_stiffness(
         bbox_diagonal, dhat, average_mass, grad_E, grad_B,
         max_barrier_stiffness, min_barrier_stiffness_scale);
+    if (warm_start && m_has_solved) {
+        // The adaptive stiffness only grows during a solve, so the previous
+        // solve's stiffness avoids growing it again in steady contact. Before
+        // the first solve the problem's stiffness is only a placeholder.
+        kappa = std::max(
+            kappa,
+            std::min(
+                barrier_problem_ptr()->barrier_stiffness(),
+                max_barrier_stiffness));
+    }
 
     barrier_problem_ptr()->barrier_stiffness(kappa);
     spdlog::info(
@@ -91,7 +107,15 @@ void IPCSolver::post_step_update()
 OptimizationResults IPCSolver::solve(const Eigen::VectorXd& x0)
 {
     init_solve(x0);
-    OptimizationResults results = NewtonSolver::solve(x0);
+    OptimizationResults results;
+    if (warm_start) {
+        const Eigen::VectorXd x_start = problem_ptr->warm_start_point(x0);
+        prev_min_distance = problem_ptr->compute_min_distance(x_start);
+        results = minimize(x_start);
+    } else {
+        results = minimize(x0);
+    }
+    m_has_solved = true;
     spdlog::info(
         "solver={} min_dist={:g} {}", name(),
         problem_ptr->compute_min_distance(results.x), stats_string());
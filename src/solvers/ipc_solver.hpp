@@ -32,10 +32,20 @@ public:
     virtual std::string stats_string() const override;
     virtual nlohmann::json stats() const override;
 
+    /// @brief Start from the problem's warm start point and keep the barrier
+    /// stiffness of the previous solve if it is larger.
+    bool warm_start;
+
 protected:
     /// Adaptivly update the barrier stiffness at the end of each step
     void post_step_update() override;
 
+    /// Minimize the barrier problem starting from x0
+    virtual OptimizationResults minimize(const Eigen::VectorXd& x0)
+    {
+        return NewtonSolver::solve(x0);
+    }
+
     BarrierProblem* barrier_problem_ptr()
     {
         if (problem_ptr == nullptr) {
@@ -63,6 +73,9 @@ protected:
     /// @brief The minimum distance of the previous iteration.
     double prev_min_distance;
 
+    /// @brief Whether a previous solve set the problem's barrier stiffness.
+    bool m_has_solved = false;
+
 private:
     int num_kappa_updates = 0;
 };
@@ -0,0 +1,245 @@
+#include "lbfgs_ipc_solver.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <igl/slice.h>
+
+#include <logger.hpp>
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+LBFGSIPCSolver::LBFGSIPCSolver()
+    : IPCSolver()
+    , history_size(10)
+    , initial_hessian_refresh(10)
+{
+}
+
+// Initialize the state of the solver using the settings saved in JSON
+void LBFGSIPCSolver::settings(const nlohmann::json& json)
+{
+    IPCSolver::settings(json);
+    history_size = json["history_size"];
+    initial_hessian_refresh =
+        std::max(json["initial_hessian_refresh"].get<int>(), 1);
+    num_lbfgs_steps = 0;
+    num_initial_hessian_updates = 0;
+    num_history_resets = 0;
+}
+
+// Export the state of the solver using the settings saved in JSON
+nlohmann::json LBFGSIPCSolver::settings() const
+{
+    nlohmann::json json = IPCSolver::settings();
+    json["history_size"] = history_size;
+    json["initial_hessian_refresh"] = initial_hessian_refresh;
+    return json;
+}
+
+std::string LBFGSIPCSolver::stats_string() const
+{
+    return fmt::format(
+        "num_lbfgs_steps={:d} num_initial_hessian_updates={:d} "
+        "num_history_resets={:d} {}",
+        num_lbfgs_steps, num_initial_hessian_updates, num_history_resets,
+        IPCSolver::stats_string());
+}
+
+nlohmann::json LBFGSIPCSolver::stats() const
+{
+    nlohmann::json stats_json = IPCSolver::stats();
+    stats_json["num_lbfgs_steps"] = num_lbfgs_steps;
+    stats_json["num_initial_hessian_updates"] = num_initial_hessian_updates;
+    stats_json["num_history_resets"] = num_history_resets;
+    return stats_json;
+}
+
+void LBFGSIPCSolver::clear_history()
+{
+    if (!m_s.empty()) {
+        num_history_resets++;
+    }
+    m_s.clear();
+    m_y.clear();
+}
+
+double LBFGSIPCSolver::update_initial_hessian(const Eigen::VectorXd& x)
+{
+    PROFILE_POINT("LBFGSIPCSolver::update_initial_hessian");
+    PROFILE_START();
+
+    // Only the diagonal blocks are used, but the Hessian blocks are the only
+    // way to get the barrier's contribution to them.
+    double fx =
+        problem_ptr->compute_objective_blocks(x, gradient, hessian_blocks);
+    m_preconditioner.compute(hessian_blocks, m_is_dof_free);
+    num_initial_hessian_updates++;
+
+    PROFILE_END();
+    return fx;
+}
+
+void LBFGSIPCSolver::compute_lbfgs_direction(
+    const Eigen::VectorXd& g, Eigen::VectorXd& d)
+{
+    // Two-loop recursion (Nocedal and Wright Algorithm 7.4)
+    std::vector<double> alpha(m_s.size());
+    Eigen::VectorXd q = g;
+    for (int i = int(m_s.size()) - 1; i >= 0; i--) {
+        alpha[i] = m_s[i].dot(q) / m_y[i].dot(m_s[i]);
+        q -= alpha[i] * m_y[i];
+    }
+    d = m_preconditioner.solve(q);
+    for (int i = 0; i < int(m_s.size()); i++) {
+        const double beta = m_y[i].dot(d) / m_y[i].dot(m_s[i]);
+        d += (alpha[i] - beta) * m_s[i];
+    }
+    d = -d;
+
+    if (g.dot(d) >= 0) {
+        // The history is not positive definite along g
+        clear_history();
+        d = -m_preconditioner.solve(g);
+    }
+}
+
+OptimizationResults LBFGSIPCSolver::minimize(const Eigen::VectorXd& x0)
+{
+    assert(problem_ptr != nullptr);
+    x_prev = x0;
+    x = x0;
+
+    spdlog::debug("solver={} action=BEGIN", name());
+
+    std::string exit_reason = "exceeded the maximum allowable iterations";
+
+    const int num_vars = problem_ptr->num_vars();
+    direction.setZero(num_vars);
+    grad_direction.setZero(num_vars);
+
+    const Eigen::VectorXi free_dof = problem_ptr->free_dof();
+    m_is_dof_free.setConstant(num_vars, false);
+    for (int i = 0; i < free_dof.size(); i++) {
+        m_is_dof_free(free_dof(i)) = true;
+    }
+    clear_history();
+
+    is_energy_converged = false;
+    bool success = false;
+    min_ccd_step_size = 1;
+
+    Eigen::VectorXd prev_grad_direction;
+    double prev_kappa = barrier_problem_ptr()->barrier_stiffness();
+    double step_length = 1.0;
+
+    for (iteration_number = 0; iteration_number < max_iterations;
+         iteration_number++) {
+        // The barrier stiffness changes the objective, so the curvature of
+        // the previous objective is stale.
+        const bool kappa_changed =
+            barrier_problem_ptr()->barrier_stiffness() != prev_kappa;
+        prev_kappa = barrier_problem_ptr()->barrier_stiffness();
+        if (kappa_changed) {
+            clear_history();
+        }
+
+        double fx;
+        if (iteration_number % initial_hessian_refresh == 0 || kappa_changed) {
+            fx = update_initial_hessian(x);
+        } else {
+            fx = problem_ptr->compute_objective(x, gradient);
+        }
+        grad_direction = m_is_dof_free.select(gradient, 0);
+
+        if (iteration_number > 0 && !kappa_changed) {
+            Eigen::VectorXd s = x - x_prev;
+            Eigen::VectorXd y = grad_direction - prev_grad_direction;
+            // Skip pairs that violate the curvature condition
+            if (s.dot(y) > std::numeric_limits<double>::epsilon() * y.dot(y)) {
+                m_s.push_back(s);
+                m_y.push_back(y);
+                if (int(m_s.size()) > history_size) {
+                    m_s.pop_front();
+                    m_y.pop_front();
+                }
+            }
+        }
+        prev_grad_direction = grad_direction;
+
+        compute_lbfgs_direction(grad_direction, direction);
+        igl::slice(gradient, free_dof, gradient_free);
+        igl::slice(direction, free_dof, direction_free);
+
+        // check for termination
+        if (iteration_number > 0 && converged()) {
+            exit_reason = "found a local optimum with L-BFGS dir";
+            success = true;
+            break;
+        }
+
+        step_length = 1;
+        bool found_step =
+            line_search(x, direction, fx, grad_direction, step_length);
+
+        // Retry with only the initial Hessian
+        if (!found_step && !m_s.empty()) {
+            clear_history();
+            direction = -m_preconditioner.solve(grad_direction);
+            step_length = 1;
+            found_step =
+                line_search(x, direction, fx, grad_direction, step_length);
+        }
+
+        // Fall back to gradient descent
+        if (!found_step) {
+            spdlog::warn(
+                "solver={} iter={:d} failure=\"L-BFGS line-search\" "
+                "failsafe=\"gradient descent\"",
+                name(), iteration_number);
+            direction = -grad_direction;
+            step_length = 1;
+            if (!line_search(x, direction, fx, grad_direction, step_length)) {
+                if (iteration_number == 0 && converged()) {
+                    // Do not consider this a failure
+                    spdlog::info(
+                        "solver={} msg=\"converged without taking a step\"",
+                        name());
+                    exit_reason = "found a local optimum with -grad dir";
+                    success = true;
+                    break;
+                }
+                spdlog::error(
+                    "solver={} iter={:d} failure=\"gradient line-search\" "
+                    "failsafe=\"none\"",
+                    name(), iteration_number);
+                exit_reason = "line-search failed";
+                break;
+            }
+        }
+
+        spdlog::debug(
+            "solver={} iter={:d} step_length={:g} history_size={:d}", name(),
+            iteration_number, step_length, m_s.size());
+
+        x_prev = x;
+        x += step_length * direction;
+        assert(!problem_ptr->has_collisions(x_prev, x));
+        num_lbfgs_steps++;
+
+        post_step_update();
+    }
+
+    spdlog::info(
+        "solver={} action=END total_iter={:d} exit_reason=\"{}\"", name(),
+        iteration_number, exit_reason);
+
+    OptimizationResults results(
+        x, problem_ptr->compute_objective(x), success, true, iteration_number);
+    results.min_ccd_step_size = min_ccd_step_size;
+    return results;
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <deque>
+
+#include <solvers/ipc_solver.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief IPC solver that replaces Newton's method with L-BFGS.
+ *
+ * Each iteration only needs the gradient of the objective, so the Hessian is
+ * not assembled and factorized every iteration. The initial inverse Hessian
+ * approximation is the block-Jacobi preconditioner of the Hessian blocks
+ * (i.e., the mass and contact blocks of each body), refreshed every few
+ * iterations. The CCD filtered line search, adaptive barrier
+ * stiffness, and convergence criteria are the same as the IPC solver.
+ */
+class LBFGSIPCSolver : public virtual IPCSolver {
+public:
+    LBFGSIPCSolver();
+    virtual ~LBFGSIPCSolver() = default;
+
+    /// Initialize the state of the solver using the settings saved in JSON
+    virtual void settings(const nlohmann::json& params) override;
+    /// Export the state of the solver using the settings saved in JSON
+    virtual nlohmann::json settings() const override;
+
+    /// An identifier for the solver class
+    static std::string solver_name() { return "lbfgs_ipc_solver"; }
+    /// An identifier for this solver
+    virtual std::string name() const override
+    {
+        return LBFGSIPCSolver::solver_name();
+    }
+
+    virtual std::string stats_string() const override;
+    virtual nlohmann::json stats() const override;
+
+    /// @brief Number of correction pairs kept.
+    int history_size;
+    /// @brief Iterations between refreshes of the initial Hessian.
+    int initial_hessian_refresh;
+
+protected:
+    /// Minimize the barrier problem starting from x0 with L-BFGS
+    OptimizationResults minimize(const Eigen::VectorXd& x0) override;
+
+    /// @brief Factorize the diagonal blocks of the Hessian at x.
+    /// @returns The objective at x (the gradient is also updated).
+    double update_initial_hessian(const Eigen::VectorXd& x);
+
+    /// @brief Compute the L-BFGS direction with the two-loop recursion.
+    void compute_lbfgs_direction(const Eigen::VectorXd& g, Eigen::VectorXd& d);
+
+    /// @brief Forget all correction pairs.
+    void clear_history();
+
+    /// @brief Whether each DoF is free
+    VectorXb m_is_dof_free;
+
+    /// @brief Correction pairs sᵢ = xᵢ₊₁ - xᵢ and yᵢ = ∇f(xᵢ₊₁) - ∇f(xᵢ)
+    std::deque<Eigen::VectorXd> m_s, m_y;
+
+private:
+    size_t num_lbfgs_steps = 0;
+    size_t num_initial_hessian_updates = 0;
+    size_t num_history_resets = 0;
+};
+
+} // namespace ipc::rigid
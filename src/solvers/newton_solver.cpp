@@ -1,13 +1,22 @@
 // Functions for optimizing functions.
 #include "newton_solver.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+
+#include <Eigen/Dense>
 #include <igl/slice.h>
 #include <igl/slice_into.h>
 #include <igl/writeOBJ.h>
+#include <tbb/parallel_for.h>
 
 #include <constants.hpp>
 #include <logger.hpp>
 #include <profiler.hpp>
+#include <utils/eigen_ext.hpp>
+#include <utils/union_find.hpp>
 
 // #define USE_GRADIENT_DESCENT
 
@@ -15,6 +24,10 @@ namespace ipc::rigid {
 
 NewtonSolver::NewtonSolver()
     : max_iterations(1000)
+    , decompose_linear_solve(false)
+    , matrix_free(false)
+    , max_pcg_iterations(1000)
+    , accurate_pcg_tolerance(1e-8)
     , iteration_number(0)
     , convergence_criteria(ConvergenceCriteria::ENERGY)
     , m_line_search_lower_bound(Constants::DEFAULT_LINE_SEARCH_LOWER_BOUND)
@@ -34,6 +47,9 @@ void NewtonSolver::settings(const nlohmann::json& json)
     velocity_conv_tol = json["velocity_conv_tol"];
     is_velocity_conv_tol_abs = json["is_velocity_conv_tol_abs"];
     m_line_search_lower_bound = json["line_search_lower_bound"];
+    decompose_linear_solve = json["decompose_linear_solve"];
+    matrix_free = json["matrix_free"];
+    max_pcg_iterations = json["max_pcg_iterations"];
 
     linear_solver_settings = json["linear_solver"];
     try {
@@ -46,6 +62,7 @@ void NewtonSolver::settings(const nlohmann::json& json)
             polysolve::LinearSolver::create(linear_solver_settings["name"], "");
     }
     linear_solver->setParameters(linear_solver_settings);
+    m_analyzed_pattern.clear();
 
     reset_stats();
 }
@@ -56,6 +73,9 @@ nlohmann::json NewtonSolver::settings() const
     settings["max_iterations"] = max_iterations;
     settings["convergence_criteria"] = convergence_criteria;
     settings["linear_solver"] = linear_solver_settings;
+    settings["decompose_linear_solve"] = decompose_linear_solve;
+    settings["matrix_free"] = matrix_free;
+    settings["max_pcg_iterations"] = max_pcg_iterations;
     settings["energy_conv_tol"] = energy_conv_tol;
     settings["velocity_conv_tol"] = velocity_conv_tol;
     settings["is_velocity_conv_tol_abs"] = is_velocity_conv_tol_abs;
@@ -78,7 +98,8 @@ nlohmann::json NewtonSolver::stats() const
              { "count_grad", num_grad_fx },
              { "count_hess", num_hessian_fx },
              { "count_ccd", num_collision_check },
-             { "total_regularizations", regularization_iterations } };
+             { "total_regularizations", regularization_iterations },
+             { "total_pcg_iterations", pcg_iterations } };
 }
 
 std::string NewtonSolver::stats_string() const
@@ -87,10 +108,10 @@ std::string NewtonSolver::stats_string() const
         "total_newton_steps={:d} total_ls_steps={:d} "
         "num_newton_ls_fails={:d} num_grad_ls_fails={:d} count_fx={:d} "
         "count_grad={:d} count_hess={:d} count_ccd={:d} "
-        "total_regularizations={:d}",
+        "total_regularizations={:d} total_pcg_iterations={:d}",
         newton_iterations, ls_iterations, num_newton_ls_fails,
         num_grad_ls_fails, num_fx, num_grad_fx, num_hessian_fx,
-        num_collision_check, regularization_iterations);
+        num_collision_check, regularization_iterations, pcg_iterations);
 }
 
 void NewtonSolver::reset_stats()
@@ -104,6 +125,7 @@ void NewtonSolver::reset_stats()
     num_newton_ls_fails = 0;
     num_grad_ls_fails = 0;
     regularization_iterations = 0;
+    pcg_iterations = 0;
 }
 
 bool NewtonSolver::converged()
@@ -193,10 +215,14 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
 
     is_energy_converged = false;
     bool success = false;
+    min_ccd_step_size = 1;
+    m_prev_gradient_norm = -1;
 
     for (iteration_number = 0; iteration_number < max_iterations;
          iteration_number++) {
-        double fx = problem_ptr->compute_objective(x, gradient, hessian);
+        double fx = matrix_free
+            ? problem_ptr->compute_objective_blocks(x, gradient, hessian_blocks)
+            : problem_ptr->compute_objective(x, gradient, hessian);
 
         num_fx++;
         num_grad_fx++;
@@ -205,14 +231,18 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
         // Remove rows and cols of fixed DoF
         Eigen::VectorXi free_dof = problem_ptr->free_dof();
         igl::slice(gradient, free_dof, gradient_free);
-        igl::slice(hessian, free_dof, free_dof, hessian_free);
+        if (!matrix_free) {
+            slice_free_hessian(free_dof);
+        }
 
 #ifdef USE_GRADIENT_DESCENT
         direction_free = -gradient_free;
 #else
-        bool solve_success = compute_regularized_direction(
-            fx, gradient_free, hessian_free, direction_free,
-            regulariztion_coeff);
+        bool solve_success = matrix_free
+            ? compute_matrix_free_direction(gradient, free_dof, direction_free)
+            : compute_regularized_direction(
+                fx, gradient_free, hessian_free, direction_free,
+                regulariztion_coeff);
         if (!solve_success) {
             exit_reason = "regularization failed";
             break;
@@ -226,7 +256,19 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
         igl::slice_into(direction_free, free_dof, direction);
 
         // check for newton termination
-        if (iteration_number > 0 && converged()) {
+        bool is_converged = iteration_number > 0 && converged();
+        if (is_converged && matrix_free) {
+            // An inexact direction can be much shorter than the Newton step,
+            // so confirm convergence with an accurate direction.
+            if (!compute_matrix_free_direction(
+                    gradient, free_dof, direction_free, /*accurate=*/true)) {
+                exit_reason = "regularization failed";
+                break;
+            }
+            igl::slice_into(direction_free, free_dof, direction);
+            is_converged = converged();
+        }
+        if (is_converged) {
             exit_reason = "found a local optimum with newton dir";
             success = true;
             break;
@@ -307,8 +349,10 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
         "solver={} action=END total_iter={:d} exit_reason=\"{}\"", name(),
         iteration_number, exit_reason);
 
-    return OptimizationResults(
+    OptimizationResults results(
         x, problem_ptr->compute_objective(x), success, true, iteration_number);
+    results.min_ccd_step_size = min_ccd_step_size;
+    return results;
 }
 
 bool NewtonSolver::line_search(
@@ -340,6 +384,7 @@ bool NewtonSolver::line_search(
         max_step_size =
             std::min(problem_ptr->compute_earliest_toi(x, x + dir), 1.0);
         step_length = std::min(step_length, max_step_size);
+        min_ccd_step_size = std::min(min_ccd_step_size, max_step_size);
     }
     // #ifndef NDEBUG
     // while (problem_ptr->has_collisions(x, x + step_length * dir)) {
@@ -424,6 +469,85 @@ bool NewtonSolver::line_search(
     return success;
 }
 
+bool NewtonSolver::compute_matrix_free_direction(
+    const Eigen::VectorXd& gradient,
+    const Eigen::VectorXi& free_dof,
+    Eigen::VectorXd& delta_x_free,
+    bool accurate)
+{
+    PROFILE_POINT("NewtonSolver::compute_matrix_free_direction");
+    PROFILE_START();
+
+    // Solve in the full space with the fixed DoF masked out
+    VectorXb is_dof_free = VectorXb::Constant(gradient.size(), false);
+    for (int i = 0; i < free_dof.size(); i++) {
+        is_dof_free(free_dof(i)) = true;
+    }
+    const Eigen::VectorXd g = is_dof_free.select(gradient, 0);
+    m_preconditioner.compute(hessian_blocks, is_dof_free);
+
+    // Eisenstat–Walker forcing term (choice 2 with γ = 0.9 and α = 2). An
+    // accurate re-solve of the same iteration leaves the sequence unchanged.
+    const double gamma = 0.9, max_forcing_term = 0.5;
+    const double gradient_norm = g.norm();
+    if (!accurate) {
+        if (m_prev_gradient_norm <= 0) {
+            m_forcing_term = max_forcing_term;
+        } else {
+            const double ratio = gradient_norm / m_prev_gradient_norm;
+            double forcing_term = gamma * ratio * ratio;
+            // Safeguard against the forcing term decreasing too quickly
+            const double safeguard = gamma * m_forcing_term * m_forcing_term;
+            if (safeguard > 0.1) {
+                forcing_term = std::max(forcing_term, safeguard);
+            }
+            m_forcing_term = std::min(forcing_term, max_forcing_term);
+        }
+        m_prev_gradient_norm = gradient_norm;
+    }
+
+    const double tol =
+        (accurate ? accurate_pcg_tolerance : m_forcing_term) * gradient_norm;
+    Eigen::VectorXd delta_x = Eigen::VectorXd::Zero(g.size());
+    Eigen::VectorXd r = -g;
+    Eigen::VectorXd z = m_preconditioner.solve(r);
+    Eigen::VectorXd p = z;
+    double rz = r.dot(z);
+    int i = 0;
+    for (; i < max_pcg_iterations && r.norm() > tol; i++) {
+        const Eigen::VectorXd Hp = is_dof_free.select(hessian_blocks * p, 0);
+        const double pHp = p.dot(Hp);
+        if (pHp <= 0) {
+            // Non-positive curvature, so keep the direction found so far or
+            // the preconditioned gradient direction.
+            if (i == 0) {
+                delta_x = p;
+            }
+            break;
+        }
+        const double alpha = rz / pHp;
+        delta_x += alpha * p;
+        r -= alpha * Hp;
+        z = m_preconditioner.solve(r);
+        const double rz_next = r.dot(z);
+        p = z + (rz_next / rz) * p;
+        rz = rz_next;
+    }
+    pcg_iterations += i;
+
+    spdlog::debug(
+        "solver={} iter={:d} pcg_iterations={:d} forcing_term={:g} "
+        "relative_residual={:g}",
+        name(), iteration_number, i, m_forcing_term,
+        gradient_norm > 0 ? r.norm() / gradient_norm : 0.0);
+
+    igl::slice(delta_x, free_dof, delta_x_free);
+
+    PROFILE_END();
+
+    return delta_x.allFinite();
+}
+
 double norm_Linf(const Eigen::SparseMatrix<double>& M)
 {
     double norm = 0;
@@ -512,37 +636,12 @@ bool NewtonSolver::compute_direction(
     // Return true if the solve was successful.
     bool solve_success = false;
 
-    // if (hessian.rows() <= 1200) { // <= 200 bodies
-    //     Eigen::MatrixXd dense_hessian(hessian);
-    //     direction = dense_hessian.ldlt().solve(-gradient);
-    //     solve_success = true;
-    // } else {
-    linear_solver->analyzePattern(hessian, hessian.rows());
-    linear_solver->factorize(hessian);
-    nlohmann::json info;
-    linear_solver->getInfo(info);
-    // TODO: This check only works for direct Eigen solvers
-    if (!info.contains("solver_info") || info["solver_info"] == "Success") {
-        // TODO: Do we have a better initial guess for iterative
-        // solvers?
-        direction = Eigen::VectorXd::Zero(gradient.size());
-        linear_solver->solve(-gradient, direction);
-        linear_solver->getInfo(info);
-        if (!info.contains("solver_info") || info["solver_info"] == "Success") {
-            solve_success = true;
-        } else {
-            spdlog::warn(
-                "solver={} iter={:d} failure=\"sparse solve for newton "
-                "direction\" failsafe=\"gradient descent\"",
-                name(), iteration_number);
-        }
+    if (decompose_linear_solve) {
+        solve_success =
+            compute_decomposed_direction(gradient, hessian, direction);
     } else {
-        spdlog::warn(
-            "solver={} iter={:d} failure=\"sparse decomposition of the "
-            "hessian\" failsafe=\"gradient descent\"",
-            name(), iteration_number);
+        solve_success = compute_sparse_direction(gradient, hessian, direction);
     }
-    // }
 
     PROFILE_END();
 
@@ -591,6 +690,291 @@ bool NewtonSolver::compute_direction(
     return solve_success;
 }
 
+bool NewtonSolver::compute_sparse_direction(
+    const Eigen::VectorXd& gradient,
+    const Eigen::SparseMatrix<double>& hessian,
+    Eigen::VectorXd& direction)
+{
+    bool solve_success = false;
+
+    // The symbolic analysis only depends on the sparsity pattern, which only
+    // changes when the set of interacting bodies changes.
+    if (!m_analyzed_pattern.matches(hessian)) {
+        linear_solver->analyzePattern(hessian, hessian.rows());
+        m_analyzed_pattern.assign(hessian);
+    }
+    linear_solver->factorize(hessian);
+    nlohmann::json info;
+    linear_solver->getInfo(info);
+    // TODO: This check only works for direct Eigen solvers
+    if (!info.contains("solver_info") || info["solver_info"] == "Success") {
+        // TODO: Do we have a better initial guess for iterative
+        // solvers?
+        direction = Eigen::VectorXd::Zero(gradient.size());
+        linear_solver->solve(-gradient, direction);
+        linear_solver->getInfo(info);
+        if (!info.contains("solver_info") || info["solver_info"] == "Success") {
+            solve_success = true;
+        } else {
+            spdlog::warn(
+                "solver={} iter={:d} failure=\"sparse solve for newton "
+                "direction\" failsafe=\"gradient descent\"",
+                name(), iteration_number);
+        }
+    } else {
+        spdlog::warn(
+            "solver={} iter={:d} failure=\"sparse decomposition of the "
+            "hessian\" failsafe=\"gradient descent\"",
+            name(), iteration_number);
+    }
+
+    return solve_success;
+}
+
+bool NewtonSolver::compute_decomposed_direction(
+    const Eigen::VectorXd& gradient,
+    const Eigen::SparseMatrix<double>& hessian,
+    Eigen::VectorXd& direction)
+{
+    PROFILE_POINT("NewtonSolver::compute_decomposed_direction");
+    PROFILE_START();
+
+    // DoF only interact through nonzero entries of the Hessian, so each
+    // connected component of its graph is an independent linear system.
+    const int n = hessian.rows();
+    UnionFind dof_sets(n);
+    for (int j = 0; j < hessian.outerSize(); j++) {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(hessian, j); it;
+             ++it) {
+            if (it.value() != 0) {
+                dof_sets.merge(it.row(), it.col());
+            }
+        }
+    }
+    std::vector<int> labels;
+    const int num_components = dof_sets.components(labels);
+
+    if (num_components <= 1) {
+        PROFILE_END();
+        return compute_sparse_direction(gradient, hessian, direction);
+    }
+
+    // Sort the DoF by component (counting sort keeps them increasing)
+    std::vector<int> offsets(num_components + 1, 0);
+    for (int i = 0; i < n; i++) {
+        offsets[labels[i] + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<int> component_dofs(n);
+    {
+        std::vector<int> next(offsets.begin(), offsets.end() - 1);
+        for (int i = 0; i < n; i++) {
+            component_dofs[next[labels[i]]++] = i;
+        }
+    }
+
+    // Components no larger than a single 3D body are solved densely. The
+    // remaining DoF are coupled by contacts and solved together with the
+    // sparse solver.
+    constexpr int MAX_DENSE_SIZE = 6;
+    std::vector<int> dense_components;
+    std::vector<int> coupled_dofs;
+    for (int c = 0; c < num_components; c++) {
+        if (offsets[c + 1] - offsets[c] <= MAX_DENSE_SIZE) {
+            dense_components.push_back(c);
+        } else {
+            coupled_dofs.insert(
+                coupled_dofs.end(), component_dofs.begin() + offsets[c],
+                component_dofs.begin() + offsets[c + 1]);
+        }
+    }
+
+    direction.resize(n);
+    std::atomic<bool> dense_success(true);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), dense_components.size()),
+        [&](const tbb::blocked_range<size_t>& range) {
+            for (size_t ci = range.begin(); ci != range.end(); ++ci) {
+                const int c = dense_components[ci];
+                const int* dofs = component_dofs.data() + offsets[c];
+                const int size = offsets[c + 1] - offsets[c];
+
+                MatrixMax6d H(size, size);
+                VectorMax6d g(size);
+                for (int i = 0; i < size; i++) {
+                    g(i) = gradient(dofs[i]);
+                    for (int j = 0; j < size; j++) {
+                        H(i, j) = hessian.coeff(dofs[i], dofs[j]);
+                    }
+                }
+
+                // LDLT "succeeds" on singular matrices (e.g., a zero 1×1
+                // block), so also reject (numerically) zero pivots.
+                Eigen::LDLT<MatrixMax6d> ldlt(H);
+                const double min_pivot = size
+                    * std::numeric_limits<double>::epsilon()
+                    * H.cwiseAbs().maxCoeff();
+                if (ldlt.info() != Eigen::Success
+                    || (ldlt.vectorD().array().abs() <= min_pivot).any()) {
+                    dense_success = false;
+                    continue;
+                }
+                const VectorMax6d d = ldlt.solve(-g);
+                for (int i = 0; i < size; i++) {
+                    direction(dofs[i]) = d(i);
+                }
+            }
+        });
+
+    bool solve_success = dense_success;
+    if (!solve_success) {
+        spdlog::warn(
+            "solver={} iter={:d} failure=\"dense decomposition of a "
+            "hessian block\" failsafe=\"gradient descent\"",
+            name(), iteration_number);
+    }
+
+    if (solve_success && !coupled_dofs.empty()) {
+        Eigen::VectorXi coupled = Eigen::Map<Eigen::VectorXi>(
+            coupled_dofs.data(), coupled_dofs.size());
+        Eigen::SparseMatrix<double> coupled_hessian;
+        Eigen::VectorXd coupled_gradient, coupled_direction;
+        igl::slice(hessian, coupled, coupled, coupled_hessian);
+        igl::slice(gradient, coupled, coupled_gradient);
+        solve_success = compute_sparse_direction(
+            coupled_gradient, coupled_hessian, coupled_direction);
+        igl::slice_into(coupled_direction, coupled, direction);
+    }
+
+    PROFILE_MESSAGE(
+        , "num_components,num_dense_components,num_coupled_dofs",
+        fmt::format(
+            "{:d},{:d},{:d}", num_components, dense_components.size(),
+            coupled_dofs.size()));
+
+    PROFILE_END();
+    return solve_success;
+}
+
+void NewtonSolver::slice_free_hessian(const Eigen::VectorXi& free_dof)
+{
+    PROFILE_POINT("NewtonSolver::slice_free_hessian");
+    PROFILE_START();
+
+    if (m_sliced_pattern.matches(hessian)
+        && free_dof.size() == m_sliced_free_dof.size()
+        && free_dof == m_sliced_free_dof && hessian_free.isCompressed()
+        && hessian_free.nonZeros() == m_free_hessian_value_ids.size()) {
+        // Same pattern: only copy the values into the preallocated matrix.
+        // hessian_free may have been regularized in place, but adding to its
+        // diagonal only changes the pattern if it increases nonZeros().
+        double* values = hessian_free.valuePtr();
+        for (size_t i = 0; i < m_free_hessian_value_ids.size(); i++) {
+            values[i] = hessian.valuePtr()[m_free_hessian_value_ids[i]];
+        }
+        PROFILE_END();
+        return;
+    }
+
+    if (!hessian.isCompressed()
+        || !std::is_sorted(free_dof.data(), free_dof.data() + free_dof.size())) {
+        igl::slice(hessian, free_dof, free_dof, hessian_free);
+        m_sliced_pattern.clear();
+        PROFILE_END();
+        return;
+    }
+
+    // Keep every stored entry (including explicit zeros), so later Hessians
+    // with the same pattern map onto hessian_free.
+    std::vector<int> free_id(hessian.rows(), -1);
+    for (int i = 0; i < free_dof.size(); i++) {
+        free_id[free_dof(i)] = i;
+    }
+
+    const int* outer = hessian.outerIndexPtr();
+    const int* inner = hessian.innerIndexPtr();
+    m_free_hessian_value_ids.clear();
+    hessian_free.resize(free_dof.size(), free_dof.size());
+    std::vector<int> free_inner;
+    for (int j = 0; j < free_dof.size(); j++) {
+        hessian_free.outerIndexPtr()[j] = m_free_hessian_value_ids.size();
+        for (int k = outer[free_dof(j)]; k < outer[free_dof(j) + 1]; k++) {
+            if (free_id[inner[k]] >= 0) {
+                free_inner.push_back(free_id[inner[k]]);
+                m_free_hessian_value_ids.push_back(k);
+            }
+        }
+    }
+    hessian_free.outerIndexPtr()[free_dof.size()] =
+        m_free_hessian_value_ids.size();
+    hessian_free.resizeNonZeros(m_free_hessian_value_ids.size());
+    for (size_t i = 0; i < m_free_hessian_value_ids.size(); i++) {
+        hessian_free.innerIndexPtr()[i] = free_inner[i];
+        hessian_free.valuePtr()[i] =
+            hessian.valuePtr()[m_free_hessian_value_ids[i]];
+    }
+
+    m_sliced_pattern.assign(hessian);
+    m_sliced_free_dof = free_dof;
+
+    PROFILE_END();
+}
+
+size_t sparsity_pattern_fingerprint(const Eigen::SparseMatrix<double>& A)
+{
+    if (!A.isCompressed()) {
+        return 0;
+    }
+
+    // FNV-1a over the size and the indices of the stored entries
+    size_t hash = 14695981039346656037ULL;
+    const auto combine = [&hash](size_t value) {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+    combine(A.rows());
+    combine(A.cols());
+    for (long j = 0; j <= A.outerSize(); j++) {
+        combine(A.outerIndexPtr()[j]);
+    }
+    for (long k = 0; k < A.nonZeros(); k++) {
+        combine(A.innerIndexPtr()[k]);
+    }
+    return hash == 0 ? 1 : hash; // 0 is reserved for uncompressed matrices
+}
+
+bool SparsityPattern::matches(const Eigen::SparseMatrix<double>& A) const
+{
+    if (m_fingerprint == 0 || A.rows() != m_rows || A.cols() != m_cols
+        || !A.isCompressed() || A.nonZeros() != m_inner.size()
+        || sparsity_pattern_fingerprint(A) != m_fingerprint) {
+        return false;
+    }
+    return std::equal(m_outer.begin(), m_outer.end(), A.outerIndexPtr())
+        && std::equal(m_inner.begin(), m_inner.end(), A.innerIndexPtr());
+}
+
+void SparsityPattern::assign(const Eigen::SparseMatrix<double>& A)
+{
+    m_fingerprint = sparsity_pattern_fingerprint(A);
+    if (m_fingerprint == 0) {
+        clear();
+        return;
+    }
+    m_rows = A.rows();
+    m_cols = A.cols();
+    m_outer.assign(A.outerIndexPtr(), A.outerIndexPtr() + A.outerSize() + 1);
+    m_inner.assign(A.innerIndexPtr(), A.innerIndexPtr() + A.nonZeros());
+}
+
+void SparsityPattern::clear()
+{
+    m_fingerprint = 0;
+    m_rows = m_cols = 0;
+    m_outer.clear();
+    m_inner.clear();
+}
+
 // Make the matrix positive definite (x^T A x > 0).
 double make_matrix_positive_definite(Eigen::SparseMatrix<double>& A)
 {
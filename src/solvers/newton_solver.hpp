@@ -1,10 +1,15 @@
 #pragma once
 
+#include <vector>
+
 #include <Eigen/Core>
+#include <Eigen/Sparse>
 #include <polysolve/LinearSolver.hpp>
 
 #include <constants.hpp>
 #include <solvers/optimization_solver.hpp>
+#include <utils/block_jacobi_preconditioner.hpp>
+#include <utils/block_sparse_matrix.hpp>
 #include <utils/not_implemented_error.hpp>
 
 namespace ipc::rigid {
@@ -17,6 +22,28 @@ enum ConvergenceCriteria {
 NLOHMANN_JSON_SERIALIZE_ENUM(
     ConvergenceCriteria, { { VELOCITY, "velocity" }, { ENERGY, "energy" } });
 
+/// @brief Copy of the sparsity pattern of a compressed sparse matrix.
+///
+/// The fingerprint only rules out different patterns quickly. A match
+/// compares the outer and inner index arrays exactly, so a hash collision
+/// cannot reuse a stale symbolic factorization.
+class SparsityPattern {
+public:
+    /// @brief Whether A is compressed and has exactly the stored pattern.
+    bool matches(const Eigen::SparseMatrix<double>& A) const;
+
+    /// @brief Store the pattern of A (clear it if A is not compressed).
+    void assign(const Eigen::SparseMatrix<double>& A);
+
+    /// @brief Forget the stored pattern, so nothing matches it.
+    void clear();
+
+protected:
+    size_t m_fingerprint = 0; ///< 0 if no pattern is stored
+    long m_rows = 0, m_cols = 0;
+    std::vector<int> m_outer, m_inner;
+};
+
 class NewtonSolver : public virtual OptimizationSolver {
 public:
     NewtonSolver();
@@ -81,6 +108,55 @@ public:
         Eigen::VectorXd& delta_x,
         bool make_psd = false);
 
+    /// @brief Solve for the Newton direction with the sparse linear solver.
+    bool compute_sparse_direction(
+        const Eigen::VectorXd& gradient,
+        const Eigen::SparseMatrix<double>& hessian,
+        Eigen::VectorXd& delta_x);
+
+    /**
+     * @brief Solve for the Newton direction one independent block at a time.
+     *
+     * The connected components of the Hessian's graph (found with a
+     * union-find over its nonzero entries) are independent linear systems.
+     * Components of at most six DoF (e.g., a body without contacts) are
+     * solved in parallel with a dense LDLT, and the remaining DoF (bodies
+     * coupled by contacts) are solved together with the sparse solver.
+     *
+     * @return Returns true if all solves were successful. A dense block with
+     *         a (numerically) zero pivot is singular and fails the solve.
+     */
+    bool compute_decomposed_direction(
+        const Eigen::VectorXd& gradient,
+        const Eigen::SparseMatrix<double>& hessian,
+        Eigen::VectorXd& delta_x);
+
+    /**
+     * @brief Solve for an inexact Newton direction without assembling the
+     *        Hessian.
+     *
+     * The Hessian blocks of the last objective evaluation are applied as a
+     * linear operator in a conjugate gradient solve preconditioned by their
+     * block diagonal. The relative residual tolerance is the
+     * Eisenstat–Walker forcing term, so the solve is loose far from the
+     * optimum. The solve stops early at a direction of non-positive
+     * curvature.
+     *
+     * @param[in]  gradient      Gradient of the objective function.
+     * @param[in]  free_dof      Indices of the free DoF.
+     * @param[out] delta_x_free  Newton direction of the free DoF.
+     * @param[in]  accurate      Solve to accurate_pcg_tolerance instead of
+     *                           the forcing term (e.g., to confirm
+     *                           convergence).
+     *
+     * @return Returns true if the direction is finite.
+     */
+    bool compute_matrix_free_direction(
+        const Eigen::VectorXd& gradient,
+        const Eigen::VectorXi& free_dof,
+        Eigen::VectorXd& delta_x_free,
+        bool accurate = false);
+
     virtual bool compute_regularized_direction(
         double& fx,
         Eigen::VectorXd& gradient,
@@ -93,6 +169,19 @@ public:
 
     int max_iterations;
 
+    /// @brief Solve independent blocks of the Hessian separately.
+    ///
+    /// Off by default: the coupled DoF are re-sliced into a new matrix every
+    /// iteration, so this only pays off with many bodies out of contact.
+    bool decompose_linear_solve;
+
+    /// @brief Compute Newton directions with PCG on the Hessian blocks
+    bool matrix_free;
+    /// @brief Maximum number of PCG iterations per direction
+    int max_pcg_iterations;
+    /// @brief Relative residual of the PCG solves that confirm convergence
+    double accurate_pcg_tolerance;
+
 protected:
     virtual bool converged();
 
@@ -122,6 +211,8 @@ protected:
     double velocity_conv_tol;      ///< @brief Velocity convergence tolerance
     bool is_velocity_conv_tol_abs; ///< @brief Absolute velocity tol
     bool is_energy_converged;
+    /// @brief Smallest step length allowed by CCD in the current solve
+    double min_ccd_step_size;
 
     // State variables
     Eigen::VectorXd x, x_prev;
@@ -129,11 +220,37 @@ protected:
     Eigen::VectorXd direction, direction_free;
     Eigen::VectorXd grad_direction; ///< Gradient with fixed DoF set to zero
     Eigen::SparseMatrix<double> hessian, hessian_free;
+    BlockSparseMatrix hessian_blocks; ///< Unassembled Hessian (matrix free)
+
+    /// @brief Preconditioner of the matrix-free solves
+    BlockJacobiPreconditioner m_preconditioner;
+    /// @brief Eisenstat–Walker forcing term of the last matrix-free solve
+    double m_forcing_term = 1;
+    /// @brief Norm of the gradient at the last matrix-free solve
+    double m_prev_gradient_norm = -1;
 
     // Linear solver pointer
     std::unique_ptr<polysolve::LinearSolver> linear_solver;
     nlohmann::json linear_solver_settings;
 
+    /// @brief Extract the rows and columns of the free DoF of hessian into
+    /// hessian_free.
+    ///
+    /// If the sparsity pattern of the Hessian and the free DoF are the same
+    /// as the previous call, the values are copied into the existing
+    /// hessian_free without reallocating it.
+    void slice_free_hessian(const Eigen::VectorXi& free_dof);
+
+    /// @brief Pattern analyzed by the linear solver
+    SparsityPattern m_analyzed_pattern;
+
+    /// @brief Pattern of the last sliced Hessian
+    SparsityPattern m_sliced_pattern;
+    /// @brief Free DoF of the last sliced Hessian
+    Eigen::VectorXi m_sliced_free_dof;
+    /// @brief Index into hessian's values of each value of hessian_free
+    std::vector<int> m_free_hessian_value_ids;
+
 private:
     void reset_stats();
 
@@ -146,6 +263,7 @@ private:
     size_t num_newton_ls_fails = 0;
     size_t num_grad_ls_fails = 0;
     size_t regularization_iterations = 0;
+    size_t pcg_iterations = 0;
 };
 
 /**
@@ -157,6 +275,18 @@ private:
  */
 double make_matrix_positive_definite(Eigen::SparseMatrix<double>& A);
 
+/**
+ * @brief Hash the sparsity pattern of a compressed sparse matrix.
+ *
+ * Matrices with different fingerprints have different patterns. Equal
+ * fingerprints do not guarantee equal patterns (see SparsityPattern).
+ *
+ * @param A The matrix whose pattern to hash.
+ *
+ * @return The hash of the pattern (0 if A is not compressed).
+ */
+size_t sparsity_pattern_fingerprint(const Eigen::SparseMatrix<double>& A);
+
 /**
  * @brief Log values along a search direction.
  *
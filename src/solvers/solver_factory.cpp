@@ -2,6 +2,7 @@
 
 #include <solvers/homotopy_solver.hpp>
 #include <solvers/ipc_solver.hpp>
+#include <solvers/lbfgs_ipc_solver.hpp>
 
 namespace ipc::rigid {
 
@@ -18,6 +19,8 @@ SolverFactory::SolverFactory()
         HomotopySolver::solver_name(), std::make_shared<HomotopySolver>());
     barrier_solvers.emplace(
         IPCSolver::solver_name(), std::make_shared<IPCSolver>());
+    barrier_solvers.emplace(
+        LBFGSIPCSolver::solver_name(), std::make_shared<LBFGSIPCSolver>());
 }
 
 std::shared_ptr<OptimizationSolver>
@@ -28,4 +31,17 @@ SolverFactory::get_barrier_solver(const std::string& solver_name) const
     return it->second;
 }
 
+std::shared_ptr<OptimizationSolver>
+SolverFactory::create_barrier_solver(const std::string& solver_name) const
+{
+    if (solver_name == HomotopySolver::solver_name()) {
+        return std::make_shared<HomotopySolver>();
+    }
+    if (solver_name == LBFGSIPCSolver::solver_name()) {
+        return std::make_shared<LBFGSIPCSolver>();
+    }
+    assert(solver_name == IPCSolver::solver_name());
+    return std::make_shared<IPCSolver>();
+}
+
 } // namespace ipc::rigid
@@ -12,6 +12,10 @@ public:
     std::shared_ptr<OptimizationSolver>
     get_barrier_solver(const std::string& solver_name) const;
 
+    /// @brief Create a new barrier solver not shared with any other problem.
+    std::shared_ptr<OptimizationSolver>
+    create_barrier_solver(const std::string& solver_name) const;
+
 private:
     SolverFactory();
 
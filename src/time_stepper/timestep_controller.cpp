@@ -0,0 +1,79 @@
+#include "timestep_controller.hpp"
+
+#include <algorithm>
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+TimestepController::TimestepController()
+    : enabled(false)
+    , min_timestep(1e-5)
+    , max_timestep(1e-2)
+    , newton_iteration_budget(50)
+    , min_ccd_step_size(0.1)
+    , shrink_factor(0.5)
+    , growth_factor(1.25)
+{
+}
+
+bool TimestepController::settings(const nlohmann::json& json, double timestep)
+{
+    enabled = json["enabled"].get<bool>();
+    min_timestep = json["min_timestep"].is_null()
+        ? timestep / 128
+        : json["min_timestep"].get<double>();
+    max_timestep = json["max_timestep"].is_null()
+        ? 4 * timestep
+        : json["max_timestep"].get<double>();
+    newton_iteration_budget = json["newton_iteration_budget"].get<int>();
+    min_ccd_step_size = json["min_ccd_step_size"].get<double>();
+    shrink_factor = json["shrink_factor"].get<double>();
+    growth_factor = json["growth_factor"].get<double>();
+
+    if (!(0 < min_timestep && min_timestep <= max_timestep)) {
+        spdlog::error(
+            "Invalid adaptive time-step bounds (min_timestep={:g}, "
+            "max_timestep={:g})!",
+            min_timestep, max_timestep);
+        return false;
+    }
+    if (!(0 < shrink_factor && shrink_factor < 1 && growth_factor >= 1)) {
+        spdlog::error(
+            "Invalid adaptive time-step factors (shrink_factor={:g} must be "
+            "in (0, 1) and growth_factor={:g} must be at least 1)!",
+            shrink_factor, growth_factor);
+        return false;
+    }
+    return true;
+}
+
+nlohmann::json TimestepController::settings() const
+{
+    nlohmann::json json;
+    json["enabled"] = enabled;
+    json["min_timestep"] = min_timestep;
+    json["max_timestep"] = max_timestep;
+    json["newton_iteration_budget"] = newton_iteration_budget;
+    json["min_ccd_step_size"] = min_ccd_step_size;
+    json["shrink_factor"] = shrink_factor;
+    json["growth_factor"] = growth_factor;
+    return json;
+}
+
+double TimestepController::next_timestep(
+    double timestep, int num_newton_iterations, double ccd_step_size) const
+{
+    if (num_newton_iterations > newton_iteration_budget
+        || ccd_step_size < min_ccd_step_size) {
+        timestep *= shrink_factor;
+    } else if (
+        2 * num_newton_iterations <= newton_iteration_budget
+        && ccd_step_size >= 1) {
+        // Cheap solve that CCD never had to cut short
+        timestep *= growth_factor;
+    }
+    return std::clamp(timestep, min_timestep, max_timestep);
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Choose the size of the next time-step from how hard the last one
+/// was to solve.
+///
+/// The time-step shrinks when the Newton solve exceeds its iteration budget
+/// or when CCD collapses the line search step (i.e., a fast impact), and
+/// grows again once the solves are cheap and unobstructed.
+class TimestepController {
+public:
+    TimestepController();
+
+    /// @brief Load the settings.
+    /// @param json Settings of the controller.
+    /// @param timestep Nominal time-step used to fill in missing bounds.
+    /// @return False if the bounds or scale factors are invalid.
+    bool settings(const nlohmann::json& json, double timestep);
+    nlohmann::json settings() const;
+
+    /// @brief Size of the next time-step.
+    /// @param timestep Size of the time-step just taken.
+    /// @param num_newton_iterations Newton iterations used by the step.
+    /// @param ccd_step_size Smallest step length allowed by CCD in the step's
+    ///                      line searches.
+    double next_timestep(
+        double timestep, int num_newton_iterations, double ccd_step_size) const;
+
+    bool enabled;                ///< @brief Adapt the time-step size
+    double min_timestep;         ///< @brief Smallest allowed time-step
+    double max_timestep;         ///< @brief Largest allowed time-step
+    int newton_iteration_budget; ///< @brief Shrink above this many iterations
+    double min_ccd_step_size;    ///< @brief Shrink below this CCD step length
+    double shrink_factor;        ///< @brief Scale applied to shrink the step
+    double growth_factor;        ///< @brief Scale applied to grow the step
+};
+
+} // namespace ipc::rigid
@@ -2,6 +2,8 @@
 #include <ghc/fs_std.hpp> // filesystem
 
 #include <SimState.hpp>
+#include <io/results_reader.hpp>
+#include <io/write_obj.hpp>
 #include <logger.hpp>
 
 int main(int argc, char* argv[])
@@ -13,7 +15,7 @@ int main(int argc, char* argv[])
     std::string sim_path = "";
     app.add_option(
            "sim_path,-i,-s,--sim-path", sim_path,
-           "JSON file with simulation results")
+           "JSON or .traj file with simulation results")
         ->required();
 
     std::string output_dir = "";
@@ -22,6 +24,14 @@ int main(int argc, char* argv[])
            "directory for OBJ sequence")
         ->required();
 
+    int first_frame = 0;
+    app.add_option("--first-frame", first_frame, "first frame to export");
+
+    int last_frame = -1;
+    app.add_option(
+        "--last-frame", last_frame,
+        "last frame to export (-1 for the last frame)");
+
     spdlog::level::level_enum loglevel = spdlog::level::warn;
     app.add_option("--log,--loglevel", loglevel, "log level")
         ->default_val(loglevel)
@@ -37,13 +47,22 @@ int main(int argc, char* argv[])
     set_logger_level(loglevel);
 
     // Create the output directory if it does not exist
-    fs::create_directories(fs::path(output_dir));
+    fs::path dir_path(output_dir);
+    fs::create_directories(dir_path);
 
+    // Only decode the frames that are exported
+    SimulationResultsReader results;
     SimState sim;
-    bool success = sim.load_scene(sim_path);
-    if (!success) {
+    if (!results.open(sim_path) || !sim.init(results.args())) {
         return app.exit(
             CLI::Error("load_sim_failed", "Unable to load simulation result!"));
     }
-    sim.save_obj_sequence(output_dir);
+
+    results.clamp_frame_range(first_frame, last_frame);
+    for (int i = first_frame; i <= last_frame; i++) {
+        sim.problem_ptr->state(results.frame_state(i));
+        write_obj(
+            (dir_path / fmt::format("{:05d}.obj", i)).string(),
+            *sim.problem_ptr, false);
+    }
 }
@@ -125,6 +125,25 @@ inline FrameBuffer create_frame_buffer(
     return frame_buffer;
 }
 
+// Resize a frame buffer to the resolution (if needed) and reset every pixel to
+// the background color and infinite depth
+inline void clear_frame_buffer(
+    FrameBuffer& frame_buffer,
+    const Eigen::Vector2i& resolution,
+    const Eigen::Matrix<uint8_t, 4, 1>& bg_color)
+{
+    if (frame_buffer.rows() != resolution.x()
+        || frame_buffer.cols() != resolution.y()) {
+        frame_buffer.resize(resolution.x(), resolution.y());
+    }
+    for (int i = 0; i < frame_buffer.rows(); i++) {
+        for (int j = 0; j < frame_buffer.cols(); j++) {
+            frame_buffer(i, j).color = bg_color;
+            frame_buffer(i, j).depth = std::numeric_limits<Float>::infinity();
+        }
+    }
+}
+
 class UniformAttributes {
 public:
     Matrix4F M;
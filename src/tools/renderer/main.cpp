@@ -1,19 +1,22 @@
+#include <algorithm>
+#include <memory>
 #include <string>
 
 #include <CLI/CLI.hpp>
 #include <ghc/fs_std.hpp> // filesystem
-#include <igl/Timer.h>
 #include <nlohmann/json.hpp>
-#include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
 
 #include <io/read_obj.hpp>
 #include <io/read_rb_scene.hpp>
 #include <io/serialize_json.hpp>
+#include <io/results_reader.hpp>
 #include <logger.hpp>
 #include <physics/pose.hpp>
 #include <physics/rigid_body_assembler.hpp>
 
+#include "render_frames.hpp"
 #include "render_mesh.hpp"
 
 using namespace swr;
@@ -23,6 +26,9 @@ struct SimRenderArgs {
     fs::path output_path = fs::path("sim.mp4");
     spdlog::level::level_enum loglevel = spdlog::level::level_enum::info;
     int fps = -1;
+    int first_frame = 0;
+    int last_frame = -1;
+    int jobs = tbb::this_task_arena::max_concurrency();
 };
 
 SimRenderArgs parse_args(int argc, char* argv[])
@@ -33,7 +39,8 @@ SimRenderArgs parse_args(int argc, char* argv[])
 
     app.add_option(
            "sim_path,-i,-s,--sim-path", args.sim_path,
-           "path to simulation JSON or folder with a sequence of OBJs")
+           "path to simulation JSON/trajectory or folder with a sequence of "
+           "OBJs")
         ->required();
     app.add_option("-o,--output", args.output_path, "path to output render");
     app.add_option(
@@ -41,6 +48,16 @@ SimRenderArgs parse_args(int argc, char* argv[])
         "set log level 0=trace, 1=debug, 2=info, 3=warn, 4=error, 5=critical, "
         "6=off");
     app.add_option("--fps", args.fps, "output video frames per second");
+    app.add_option(
+           "-j,--jobs", args.jobs,
+           "maximum number of threads used to render frames")
+        ->default_val(args.jobs);
+    app.add_option(
+        "--first-frame", args.first_frame,
+        "first frame of the simulation to render");
+    app.add_option(
+        "--last-frame", args.last_frame,
+        "last frame of the simulation to render (-1 for the last frame)");
 
     try {
         app.parse(argc, argv);
@@ -48,6 +65,10 @@ SimRenderArgs parse_args(int argc, char* argv[])
         exit(app.exit(e));
     }
 
+    if (args.jobs <= 0) {
+        args.jobs = tbb::this_task_arena::max_concurrency();
+    }
+
     if (!fs::exists(args.sim_path)) {
         exit(app.exit(CLI::Error(
             "input does not exist",
@@ -57,13 +78,13 @@ SimRenderArgs parse_args(int argc, char* argv[])
 
     if (!fs::is_directory(args.sim_path)
         && args.sim_path.extension().string() != ".json"
-        && args.sim_path.extension().string() != ".JSON") {
+        && args.sim_path.extension().string() != ".JSON"
+        && args.sim_path.extension().string() != ".traj") {
         exit(app.exit(CLI::Error(
             "invalid input",
             fmt::format(
                 "invalid input path ({}) must be a simulation JSON or "
-                "directory "
-                "containing an OBJ sequence",
+                "trajectory, or a directory containing an OBJ sequence",
                 args.sim_path.string()))));
     }
 
@@ -157,20 +178,15 @@ protected:
 
 class RigidBodySequence : public MeshGenerator {
 public:
-    RigidBodySequence(const fs::path& input)
+    RigidBodySequence(const fs::path& input, int first_frame, int last_frame)
     {
-        // Read the simulation json file
-        nlohmann::json sim;
-        if (!read_json(input.string(), sim)) {
-            spdlog::error("Invalid simulation JSON file");
+        // Only the args are parsed, the frames are decoded when rendered
+        if (!results.open(input.string())) {
             exit(1);
         }
 
-        state_sequence = sim["animation"]["state_sequence"]
-                             .get<std::vector<nlohmann::json>>();
-
         std::vector<ipc::rigid::RigidBody> rbs;
-        ipc::rigid::read_rb_scene(sim["args"]["rigid_body_problem"], rbs);
+        ipc::rigid::read_rb_scene(results.args()["rigid_body_problem"], rbs);
         bodies.init(rbs);
 
         // Per-vertex colors
@@ -182,23 +198,22 @@ public:
             start_i += body.vertices.rows();
         }
 
-        m_fps = int(1 / sim["args"]["timestep"].get<double>());
+        m_fps = int(1 / results.timestep());
+
+        results.clamp_frame_range(first_frame, last_frame);
+        m_first_frame = first_frame;
+        m_num_meshes = std::max(last_frame - first_frame + 1, 0);
     }
 
     virtual ~RigidBodySequence() override {};
 
-    size_t num_meshes() override { return state_sequence.size(); }
+    size_t num_meshes() override { return m_num_meshes; }
 
     Eigen::MatrixXd vertices(size_t i) override
     {
         assert(i < num_meshes());
-        ipc::rigid::PosesD poses(bodies.num_bodies());
-        assert(state_sequence[i]["rigid_bodies"].size() == bodies.num_bodies());
-        for (int j = 0; j < bodies.num_bodies(); j++) {
-            const auto& jrb = state_sequence[i]["rigid_bodies"][j];
-            ipc::rigid::from_json(jrb["position"], poses[j].position);
-            ipc::rigid::from_json(jrb["rotation"], poses[j].rotation);
-        }
+        ipc::rigid::PosesD poses = results.frame_poses(m_first_frame + i);
+        assert(poses.size() == bodies.num_bodies());
         return bodies.world_vertices(poses);
     }
 
@@ -211,10 +226,12 @@ public:
     int fps() override { return m_fps; }
 
 protected:
-    std::vector<nlohmann::json> state_sequence;
+    ipc::rigid::SimulationResultsReader results;
     ipc::rigid::RigidBodyAssembler bodies;
     Eigen::VectorXi vertex_colors;
     int m_fps;
+    int m_first_frame;
+    size_t m_num_meshes;
 };
 
 int main(int argc, char* argv[])
@@ -240,7 +257,8 @@ int main(int argc, char* argv[])
     if (fs::is_directory(args.sim_path)) {
         mesh_generator = std::make_unique<OBJSequence>(args.sim_path);
     } else {
-        mesh_generator = std::make_unique<RigidBodySequence>(args.sim_path);
+        mesh_generator = std::make_unique<RigidBodySequence>(
+            args.sim_path, args.first_frame, args.last_frame);
     }
     if (mesh_generator->num_meshes() == 0) {
         return 0;
@@ -263,25 +281,18 @@ int main(int argc, char* argv[])
         mesh_generator->vertices(0), mesh_generator->faces(0));
     ///////////////////////////////////////////////////////////////////////////
 
-    tbb::parallel_for(size_t(0), mesh_generator->num_meshes(), [&](size_t i) {
-        std::string frame_name =
-            (frames_dir / fmt::format("frame{:06d}.png", i)).string();
-
-        igl::Timer render_timer;
-        render_timer.start();
-        bool wrote_frame = render_mesh(
-            scene, mesh_generator->vertices(i), mesh_generator->edges(i),
-            mesh_generator->faces(i), mesh_generator->colors(i), frame_name);
-        render_timer.stop();
-
-        if (wrote_frame) {
-            spdlog::info(
-                "Rendered frame {:d} to '{}' in {:g} seconds", //
-                i, frame_name, render_timer.getElapsedTime());
-        } else {
-            spdlog::error("Unable to render frame {:d} to '{}'", i, frame_name);
-        }
-    });
+    ///////////////////////////////////////////////////////////////////////////
+    // Render the frames to PNGs
+    render_frames(
+        mesh_generator->num_meshes(), args.jobs,
+        [&](size_t i, FrameBuffer& frame_buffer) {
+            render_mesh(
+                scene, mesh_generator->vertices(i), mesh_generator->edges(i),
+                mesh_generator->faces(i), mesh_generator->colors(i),
+                frame_buffer);
+        },
+        frames_dir);
+    ///////////////////////////////////////////////////////////////////////////
 
     ///////////////////////////////////////////////////////////////////////////
     // Combine PNG frames to video
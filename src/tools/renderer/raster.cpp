@@ -1,6 +1,8 @@
 #include "raster.hpp"
 
+#include <cmath>
 #include <iostream>
+#include <limits>
 
 #include <Eigen/LU> // Needed for .inverse()
 
@@ -9,68 +11,220 @@
 
 namespace swr {
 
-void rasterize_triangle(
-    const Shaders& shaders,
-    const UniformAttributes& uniform,
-    const VertexAttributes& v1,
-    const VertexAttributes& v2,
-    const VertexAttributes& v3,
-    FrameBuffer& frameBuffer)
-{
-    // Collect coordinates into a matrix and convert to canonical representation
-    Eigen::Matrix<Float, 3, 4> p;
-    p.row(0) = v1.position.array() / v1.position.w();
-    p.row(1) = v2.position.array() / v2.position.w();
-    p.row(2) = v3.position.array() / v3.position.w();
+namespace {
+    // Side in pixels of the square tiles the frame buffer is split into
+    constexpr int TILE_SIZE = 8;
 
-    // Coordinates are in -1..1, rescale to pixel size (x,y only)
-    p.col(0) = ((p.col(0).array() + 1.0) / 2.0) * frameBuffer.rows();
-    p.col(1) = ((p.col(1).array() + 1.0) / 2.0) * frameBuffer.cols();
+    // Values of a row of pixels in a tile
+    typedef Eigen::Array<Float, TILE_SIZE, 1> TileRowF;
 
-    // Find bounding box in pixels
-    int lx = std::floor(p.col(0).minCoeff());
-    int ly = std::floor(p.col(1).minCoeff());
-    int ux = std::ceil(p.col(0).maxCoeff());
-    int uy = std::ceil(p.col(1).maxCoeff());
+    // Screen space representation of a triangle shared by all its pixels
+    struct TriangleSetup {
+        TriangleSetup() = default;
+        TriangleSetup(
+            const VertexAttributes& v1,
+            const VertexAttributes& v2,
+            const VertexAttributes& v3,
+            const FrameBuffer& frameBuffer)
+        {
+            // Collect coordinates into a matrix and convert to canonical
+            // representation
+            Eigen::Matrix<Float, 3, 4> p;
+            p.row(0) = v1.position.array() / v1.position.w();
+            p.row(1) = v2.position.array() / v2.position.w();
+            p.row(2) = v3.position.array() / v3.position.w();
 
-    // Clamp to framebuffer
-    lx = std::min(std::max(lx, int(0)), int(frameBuffer.rows() - 1));
-    ly = std::min(std::max(ly, int(0)), int(frameBuffer.cols() - 1));
-    ux = std::max(std::min(ux, int(frameBuffer.rows() - 1)), int(0));
-    uy = std::max(std::min(uy, int(frameBuffer.cols() - 1)), int(0));
+            // Coordinates are in -1..1, rescale to pixel size (x,y only)
+            p.col(0) = ((p.col(0).array() + 1.0) / 2.0) * frameBuffer.rows();
+            p.col(1) = ((p.col(1).array() + 1.0) / 2.0) * frameBuffer.cols();
 
-    // Build the implicit triangle representation
-    Matrix3F A;
-    A.col(0) = p.row(0).head<3>();
-    A.col(1) = p.row(1).head<3>();
-    A.col(2) = p.row(2).head<3>();
-    A.row(2) << 1.0, 1.0, 1.0;
+            // Find bounding box in pixels
+            lx = std::floor(p.col(0).minCoeff());
+            ly = std::floor(p.col(1).minCoeff());
+            ux = std::ceil(p.col(0).maxCoeff());
+            uy = std::ceil(p.col(1).maxCoeff());
 
-    Matrix3F Ai = A.inverse();
+            // Clamp to framebuffer
+            lx = std::min(std::max(lx, int(0)), int(frameBuffer.rows() - 1));
+            ly = std::min(std::max(ly, int(0)), int(frameBuffer.cols() - 1));
+            ux = std::max(std::min(ux, int(frameBuffer.rows() - 1)), int(0));
+            uy = std::max(std::min(uy, int(frameBuffer.cols() - 1)), int(0));
 
-    // Rasterize the triangle
-    tbb::parallel_for(
-        tbb::blocked_range2d<size_t>(lx, ux + 1, ly, uy + 1),
-        [&](const tbb::blocked_range2d<size_t>& r) {
-            for (size_t i = r.rows().begin(); i != r.rows().end(); ++i) {
-                for (size_t j = r.cols().begin(); j != r.cols().end(); ++j) {
-                    // The pixel center is offset by 0.5, 0.5
-                    Vector3F pixel(i + 0.5, j + 0.5, 1);
-                    Vector3F b = Ai * pixel;
-                    if (b.minCoeff() >= 0) {
-                        VertexAttributes va = VertexAttributes::interpolate(
-                            v1, v2, v3, b[0], b[1], b[2]);
-                        // Only render fragments within the bi-unit cube
-                        if (va.position.z() >= -1 && va.position.z() <= 1) {
-                            FragmentAttributes frag =
-                                shaders.fragment_shader(va, uniform);
+            // Build the implicit triangle representation
+            Matrix3F A;
+            A.col(0) = p.row(0).head<3>();
+            A.col(1) = p.row(1).head<3>();
+            A.col(2) = p.row(2).head<3>();
+            A.row(2) << 1.0, 1.0, 1.0;
+
+            Ai = A.inverse();
+
+            // The barycentric coordinates of a pixel are Ai * (x, y, 1), so
+            // two ways of evaluating them differ by at most a few ulps of
+            // the sum of the magnitudes of the terms.
+            const Float eps = std::numeric_limits<Float>::epsilon();
+            margin = 8 * eps
+                * (Ai.col(0).cwiseAbs() * frameBuffer.rows()
+                   + Ai.col(1).cwiseAbs() * frameBuffer.cols()
+                   + Ai.col(2).cwiseAbs());
+
+            // The barycentric coordinates sum to one up to the rounding of
+            // Ai, so the depth (-z) of a fragment is at least the minimum
+            // depth of the vertices up to that rounding.
+            const Vector3F depths(
+                -v1.position.z(), -v2.position.z(), -v3.position.z());
+            const Vector3F sums = Ai.colwise().sum().transpose();
+            const Float sum_error = std::abs(sums[0]) * frameBuffer.rows()
+                + std::abs(sums[1]) * frameBuffer.cols()
+                + std::abs(sums[2] - 1) + margin.sum();
+            min_depth = depths.minCoeff()
+                - std::abs(depths.minCoeff()) * sum_error
+                - 4 * eps * (1 + sum_error) * depths.cwiseAbs().maxCoeff();
+            if (!std::isfinite(min_depth) || !(sum_error < 1)) {
+                min_depth = -std::numeric_limits<Float>::infinity();
+            }
+        }
+
+        // Check if the pixels [x0, x1] x [y0, y1] are all outside the
+        // triangle. Because the barycentric coordinates are linear, it is
+        // enough to check the corners.
+        bool misses(int x0, int y0, int x1, int y1) const
+        {
+            for (int k = 0; k < 3; k++) {
+                const Float b00 =
+                    (Ai(k, 0) * (x0 + 0.5) + Ai(k, 1) * (y0 + 0.5)) + Ai(k, 2);
+                const Float dx = Ai(k, 0) * (x1 - x0);
+                const Float dy = Ai(k, 1) * (y1 - y0);
+                const Float b_max =
+                    b00 + std::max(dx, Float(0)) + std::max(dy, Float(0));
+                if (b_max < -2 * margin[k]) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Inclusive bounding box in pixels, clamped to the frame buffer
+        int lx, ly, ux, uy;
+        // Maps a pixel center (x, y, 1) to its barycentric coordinates
+        Matrix3F Ai;
+        // Bound on the rounding error of each barycentric coordinate
+        Vector3F margin;
+        // Lower bound on the depth of the fragments of the triangle
+        Float min_depth;
+    };
+
+    // Rasterizes the pixels [x0, x1) x [y0, y1) covered by a triangle, where
+    // x1 - x0 <= TILE_SIZE. Returns true if any fragment was blended.
+    bool rasterize_triangle_tile(
+        const Shaders& shaders,
+        const UniformAttributes& uniform,
+        const VertexAttributes& v1,
+        const VertexAttributes& v2,
+        const VertexAttributes& v3,
+        const TriangleSetup& t,
+        int x0,
+        int y0,
+        int x1,
+        int y1,
+        bool lock_pixels,
+        FrameBuffer& frameBuffer)
+    {
+        assert(x1 - x0 <= TILE_SIZE);
+
+        // The pixel centers of a row are offset by 0.5
+        TileRowF xs;
+        for (int l = 0; l < TILE_SIZE; l++) {
+            xs[l] = x0 + l + 0.5;
+        }
+
+        bool blended = false;
+        for (int j = y0; j < y1; j++) {
+            const Float y = j + 0.5;
+
+            // Evaluate the barycentric coordinates of the whole row at once
+            // and discard the pixels that are outside by more than the
+            // rounding error.
+            const TileRowF b0 = (t.Ai(0, 0) * xs + t.Ai(0, 1) * y) + t.Ai(0, 2);
+            const TileRowF b1 = (t.Ai(1, 0) * xs + t.Ai(1, 1) * y) + t.Ai(1, 2);
+            const TileRowF b2 = (t.Ai(2, 0) * xs + t.Ai(2, 1) * y) + t.Ai(2, 2);
+            const Eigen::Array<bool, TILE_SIZE, 1> maybe_inside =
+                (b0 >= -t.margin[0]) && (b1 >= -t.margin[1])
+                && (b2 >= -t.margin[2]);
+            if (!maybe_inside.any()) {
+                continue;
+            }
+
+            for (int i = x0; i < x1; i++) {
+                if (!maybe_inside[i - x0]) {
+                    continue;
+                }
+                // Decide coverage exactly as for a single pixel so the
+                // rendered image does not depend on the evaluation above
+                Vector3F pixel(i + 0.5, y, 1);
+                Vector3F b = t.Ai * pixel;
+                if (b.minCoeff() >= 0) {
+                    VertexAttributes va = VertexAttributes::interpolate(
+                        v1, v2, v3, b[0], b[1], b[2]);
+                    // Only render fragments within the bi-unit cube
+                    if (va.position.z() >= -1 && va.position.z() <= 1) {
+                        FragmentAttributes frag =
+                            shaders.fragment_shader(va, uniform);
+                        if (lock_pixels) {
                             frameBuffer(i, j).lock.lock();
-                            shaders.blending_shader(frag, frameBuffer(i, j));
+                        }
+                        shaders.blending_shader(frag, frameBuffer(i, j));
+                        if (lock_pixels) {
                             frameBuffer(i, j).lock.unlock();
                         }
+                        blended = true;
                     }
                 }
             }
+        }
+        return blended;
+    }
+
+    // Maximum depth of the pixels [x0, x1) x [y0, y1)
+    Float max_depth(
+        const FrameBuffer& frameBuffer, int x0, int y0, int x1, int y1)
+    {
+        Float depth = -std::numeric_limits<Float>::infinity();
+        for (int j = y0; j < y1; j++) {
+            for (int i = x0; i < x1; i++) {
+                depth = std::max(depth, frameBuffer(i, j).depth);
+            }
+        }
+        return depth;
+    }
+} // namespace
+
+void rasterize_triangle(
+    const Shaders& shaders,
+    const UniformAttributes& uniform,
+    const VertexAttributes& v1,
+    const VertexAttributes& v2,
+    const VertexAttributes& v3,
+    FrameBuffer& frameBuffer)
+{
+    if (frameBuffer.size() == 0) {
+        return;
+    }
+    const TriangleSetup t(v1, v2, v3, frameBuffer);
+
+    // Rasterize the triangle one tile row at a time. Other triangles can be
+    // drawn at the same time, so the pixels are locked.
+    const int num_tiles_x = (t.ux - t.lx) / TILE_SIZE + 1;
+    tbb::parallel_for(
+        tbb::blocked_range2d<int>(0, num_tiles_x, 1, t.ly, t.uy + 1, TILE_SIZE),
+        [&](const tbb::blocked_range2d<int>& r) {
+            for (int tx = r.rows().begin(); tx != r.rows().end(); ++tx) {
+                const int x0 = t.lx + tx * TILE_SIZE;
+                const int x1 = std::min(x0 + TILE_SIZE, t.ux + 1);
+                rasterize_triangle_tile(
+                    shaders, uniform, v1, v2, v3, t, x0, r.cols().begin(), x1,
+                    r.cols().end(), /*lock_pixels=*/true, frameBuffer);
+            }
         });
 }
 
@@ -80,18 +234,68 @@ void rasterize_triangles(
     const std::vector<VertexAttributes>& vertices,
     FrameBuffer& frameBuffer)
 {
+    if (frameBuffer.size() == 0) {
+        return;
+    }
+
     // Call vertex shader on all vertices (parallel)
     std::vector<VertexAttributes> v(vertices.size());
     tbb::parallel_for(size_t(0), vertices.size(), [&](size_t i) {
         v[i] = shaders.vertex_shader(vertices[i], uniform);
     });
 
-    // Call the rasterization function on every triangle
+    // Set up every triangle (parallel)
     assert(vertices.size() % 3 == 0);
-    tbb::parallel_for(size_t(0), vertices.size() / 3, [&](size_t i) {
-        rasterize_triangle(
-            shaders, uniform, v[i * 3 + 0], v[i * 3 + 1], v[i * 3 + 2],
-            frameBuffer);
+    const size_t num_triangles = vertices.size() / 3;
+    std::vector<TriangleSetup> triangles(num_triangles);
+    tbb::parallel_for(size_t(0), num_triangles, [&](size_t i) {
+        triangles[i] = TriangleSetup(
+            v[i * 3 + 0], v[i * 3 + 1], v[i * 3 + 2], frameBuffer);
+    });
+
+    // Bin the triangles into the tiles overlapped by their bounding box
+    const int num_tiles_x = (frameBuffer.rows() + TILE_SIZE - 1) / TILE_SIZE;
+    const int num_tiles_y = (frameBuffer.cols() + TILE_SIZE - 1) / TILE_SIZE;
+    std::vector<std::vector<size_t>> bins(num_tiles_x * num_tiles_y);
+    for (size_t i = 0; i < num_triangles; i++) {
+        const TriangleSetup& t = triangles[i];
+        for (int ty = t.ly / TILE_SIZE; ty <= t.uy / TILE_SIZE; ty++) {
+            for (int tx = t.lx / TILE_SIZE; tx <= t.ux / TILE_SIZE; tx++) {
+                bins[ty * num_tiles_x + tx].push_back(i);
+            }
+        }
+    }
+
+    // Rasterize the tiles in parallel. Each tile is drawn by a single task
+    // in triangle order, so the pixels do not need to be locked.
+    tbb::parallel_for(size_t(0), bins.size(), [&](size_t tile) {
+        if (bins[tile].empty()) {
+            return;
+        }
+        const int tx0 = (tile % num_tiles_x) * TILE_SIZE;
+        const int ty0 = (tile / num_tiles_x) * TILE_SIZE;
+        const int tx1 = std::min(tx0 + TILE_SIZE, int(frameBuffer.rows()));
+        const int ty1 = std::min(ty0 + TILE_SIZE, int(frameBuffer.cols()));
+
+        // Farthest depth in the tile used to skip hidden triangles
+        Float tile_depth = shaders.early_depth_test
+            ? max_depth(frameBuffer, tx0, ty0, tx1, ty1)
+            : std::numeric_limits<Float>::infinity();
+
+        for (size_t i : bins[tile]) {
+            const TriangleSetup& t = triangles[i];
+            const int x0 = std::max(tx0, t.lx), x1 = std::min(tx1, t.ux + 1);
+            const int y0 = std::max(ty0, t.ly), y1 = std::min(ty1, t.uy + 1);
+            if (t.min_depth >= tile_depth || t.misses(x0, y0, x1 - 1, y1 - 1)) {
+                continue;
+            }
+            const bool blended = rasterize_triangle_tile(
+                shaders, uniform, v[i * 3 + 0], v[i * 3 + 1], v[i * 3 + 2], t,
+                x0, y0, x1, y1, /*lock_pixels=*/false, frameBuffer);
+            if (blended && shaders.early_depth_test) {
+                tile_depth = max_depth(frameBuffer, tx0, ty0, tx1, ty1);
+            }
+        }
     });
 }
 
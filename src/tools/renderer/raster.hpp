@@ -22,6 +22,10 @@ public:
     // Blending Shader
     std::function<void(const FragmentAttributes&, FrameBufferAttributes&)>
         blending_shader;
+    // Set if the fragment depth is the negated z of the interpolated position
+    // and the blending shader discards fragments that are not closer than the
+    // pixel depth. This lets the rasterizer skip triangles hidden in a tile.
+    bool early_depth_test = false;
 };
 
 // Rasterizes a single triangle v1,v2,v3 using the provided shaders and
@@ -37,7 +41,8 @@ void rasterize_triangle(
 
 // Rasterizes a collection of triangles, assembling one triangle for each 3
 // consecutive vertices. Note: the vertices will be processed by the vertex
-// shader
+// shader. The frame buffer is split into tiles that are rasterized in
+// parallel, each drawing the triangles overlapping it in order.
 void rasterize_triangles(
     const Shaders& shaders,
     const UniformAttributes& uniform,
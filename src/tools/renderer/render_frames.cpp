@@ -0,0 +1,102 @@
+#include "render_frames.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <igl/Timer.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/global_control.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_arena.h>
+
+#include <logger.hpp>
+
+#include "raster.hpp"
+#include "write_png.hpp"
+
+namespace swr {
+
+std::string frame_filename(const fs::path& frames_dir, size_t index)
+{
+    return (frames_dir / fmt::format("frame{:06d}.png", index)).string();
+}
+
+bool render_frames(
+    size_t num_frames,
+    int max_jobs,
+    const std::function<void(size_t, FrameBuffer&)>& render_frame,
+    const fs::path& frames_dir)
+{
+    struct RenderedFrame {
+        size_t index;
+        std::vector<uint8_t> image;
+        int width, height;
+        double render_time;
+    };
+    typedef std::shared_ptr<RenderedFrame> RenderedFramePtr;
+
+    if (max_jobs <= 0) {
+        max_jobs = tbb::this_task_arena::max_concurrency();
+    }
+    tbb::global_control thread_limiter(
+        tbb::global_control::max_allowed_parallelism, max_jobs);
+    tbb::enumerable_thread_specific<FrameBuffer> frame_buffers;
+
+    std::atomic<bool> success(true);
+    size_t next_frame = 0;
+    tbb::parallel_pipeline(
+        /*max_number_of_live_tokens=*/2 * max_jobs,
+        tbb::make_filter<void, size_t>(
+            tbb::filter::serial_in_order,
+            [&](tbb::flow_control& fc) -> size_t {
+                if (next_frame >= num_frames) {
+                    fc.stop();
+                    return 0;
+                }
+                return next_frame++;
+            })
+            & tbb::make_filter<size_t, RenderedFramePtr>(
+                tbb::filter::parallel,
+                [&](size_t i) {
+                    auto frame = std::make_shared<RenderedFrame>();
+                    frame->index = i;
+
+                    igl::Timer render_timer;
+                    render_timer.start();
+                    // The rasterizer is itself parallel. Isolate it so this
+                    // thread does not start another frame (and reuse its frame
+                    // buffer) while waiting for it.
+                    tbb::this_task_arena::isolate([&] {
+                        FrameBuffer& frame_buffer = frame_buffers.local();
+                        render_frame(i, frame_buffer);
+                        framebuffer_to_uint8(frame_buffer, frame->image);
+                        frame->width = frame_buffer.rows();
+                        frame->height = frame_buffer.cols();
+                    });
+                    render_timer.stop();
+                    frame->render_time = render_timer.getElapsedTime();
+                    return frame;
+                })
+            & tbb::make_filter<RenderedFramePtr, void>(
+                tbb::filter::parallel, [&](RenderedFramePtr frame) {
+                    std::string frame_name =
+                        frame_filename(frames_dir, frame->index);
+                    if (write_png(
+                            frame->image, frame->width, frame->height,
+                            frame_name)) {
+                        spdlog::info(
+                            "Rendered frame {:d} to '{}' in {:g} seconds", //
+                            frame->index, frame_name, frame->render_time);
+                    } else {
+                        spdlog::error(
+                            "Unable to render frame {:d} to '{}'",
+                            frame->index, frame_name);
+                        success = false;
+                    }
+                }));
+
+    return success;
+}
+
+} // namespace swr
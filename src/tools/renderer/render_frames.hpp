@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include "attributes.hpp"
+
+namespace swr {
+
+/// Path of the PNG of a frame in frames_dir. The names follow the
+/// frame%06d.png pattern, so they sort in frame order.
+std::string frame_filename(const fs::path& frames_dir, size_t index);
+
+/// Render the frames 0..num_frames-1 with render_frame and write them as PNGs
+/// to frames_dir (see frame_filename).
+///
+/// Frames are rendered in a pipeline: they are rasterized in parallel into
+/// per-thread frame buffers, and the PNGs of rendered frames are encoded while
+/// other frames are rasterized. At most 2 * max_jobs frames are in flight, so
+/// memory does not grow with the number of frames.
+///
+/// @param render_frame Renders the frame of the given index into a frame
+///                     buffer that is reused between frames.
+/// @returns True if every frame was written.
+bool render_frames(
+    size_t num_frames,
+    int max_jobs,
+    const std::function<void(size_t, FrameBuffer&)>& render_frame,
+    const fs::path& frames_dir);
+
+} // namespace swr
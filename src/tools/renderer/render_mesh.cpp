@@ -117,6 +117,7 @@ Shaders create_face_shaders()
             pixel.depth = fa.depth;
         }
     };
+    shaders.early_depth_test = true;
 
     return shaders;
 }
@@ -154,18 +155,18 @@ Shaders create_edge_shaders()
 }
 
 // Render a mesh with vertices V, edges E, faces F, and vertex colors C
-bool render_mesh(
+void render_mesh(
     const Scene& scene,
     const Eigen::MatrixXd& V,
     const Eigen::MatrixXi& E,
     const Eigen::MatrixXi& F,
     const Eigen::VectorXi& C,
-    const std::string& filename)
+    FrameBuffer& frame_buffer)
 {
     UniformAttributes uniform = build_uniform(scene);
 
-    FrameBuffer frame_buffer = create_frame_buffer(
-        scene.camera.resolution,
+    clear_frame_buffer(
+        frame_buffer, scene.camera.resolution,
         round(scene.background_color.array().max(0).min(1) * 255)
             .cast<uint8_t>());
 
@@ -199,23 +200,23 @@ bool render_mesh(
             create_edge_shaders(), uniform, edge_vertex_attributes,
             scene.line_thickness, frame_buffer);
     }
+}
 
-    // Convert Framebuffer to RGBA matrices
-    Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> R, G, B, A;
-    R.resizeLike(frame_buffer);
-    G.resizeLike(frame_buffer);
-    B.resizeLike(frame_buffer);
-    A.resizeLike(frame_buffer);
-    for (int i = 0; i < frame_buffer.rows(); i++) {
-        for (int j = 0; j < frame_buffer.cols(); j++) {
-            R(i, j) = frame_buffer(i, j).color(0);
-            G(i, j) = frame_buffer(i, j).color(1);
-            B(i, j) = frame_buffer(i, j).color(2);
-            A(i, j) = frame_buffer(i, j).color(3);
-        }
-    }
+bool render_mesh(
+    const Scene& scene,
+    const Eigen::MatrixXd& V,
+    const Eigen::MatrixXi& E,
+    const Eigen::MatrixXi& F,
+    const Eigen::VectorXi& C,
+    const std::string& filename)
+{
+    FrameBuffer frame_buffer;
+    render_mesh(scene, V, E, F, C, frame_buffer);
 
-    return write_png(R, G, B, A, filename);
+    std::vector<uint8_t> image;
+    framebuffer_to_uint8(frame_buffer, image);
+    return write_png(
+        image, frame_buffer.rows(), frame_buffer.cols(), filename);
 }
 
 } // namespace swr
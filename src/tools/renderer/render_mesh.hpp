@@ -23,7 +23,18 @@ struct Scene {
 };
 
 /// Render a mesh with vertices V, edges E, faces F, and vertex material
-/// indicies C
+/// indicies C into a frame buffer. The frame buffer is resized to the camera
+/// resolution and cleared first, so it can be reused between frames.
+void render_mesh(
+    const Scene& scene,
+    const Eigen::MatrixXd& V,
+    const Eigen::MatrixXi& E,
+    const Eigen::MatrixXi& F,
+    const Eigen::VectorXi& C,
+    FrameBuffer& frame_buffer);
+
+/// Render a mesh with vertices V, edges E, faces F, and vertex material
+/// indicies C to a PNG file
 bool render_mesh(
     const Scene& scene,
     const Eigen::MatrixXd& V,
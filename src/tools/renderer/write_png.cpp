@@ -37,4 +37,18 @@ bool write_png(
     return true;
 }
 
+bool write_png(
+    const std::vector<uint8_t>& image,
+    int width,
+    int height,
+    const std::string& filename)
+{
+    const int comp = 4; // 4 Channels Red, Green, Blue, Alpha
+    assert(image.size() == size_t(width) * height * comp);
+    return igl::stbi_write_png(
+               filename.c_str(), width, height, comp, image.data(),
+               width * comp)
+        != 0;
+}
+
 } // namespace swr
@@ -2,6 +2,7 @@
 
 #include <Eigen/Core>
 #include <algorithm>
+#include <string>
 #include <vector>
 
 namespace swr {
@@ -13,4 +14,12 @@ bool write_png(
     const Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>& A,
     const std::string& filename);
 
+// Write a RGBA image stored row by row from the top (see
+// framebuffer_to_uint8)
+bool write_png(
+    const std::vector<uint8_t>& image,
+    int width,
+    int height,
+    const std::string& filename);
+
 } // namespace swr
@@ -1,8 +1,11 @@
 #include <CLI/CLI.hpp>
 #include <ghc/fs_std.hpp> // filesystem
 
-#include <SimState.hpp>
+#include <io/read_rb_scene.hpp>
+#include <io/results_reader.hpp>
+#include <io/write_gltf.hpp>
 #include <logger.hpp>
+#include <physics/rigid_body_assembler.hpp>
 
 int main(int argc, char* argv[])
 {
@@ -13,12 +16,20 @@ int main(int argc, char* argv[])
     std::string sim_path = "";
     app.add_option(
            "sim_path,-i,-s,--sim-path", sim_path,
-           "JSON file with simulation results")
+           "JSON or .traj file with simulation results")
         ->required();
 
     std::string output = "";
     app.add_option("output,-o,--output", output, "output filename")->required();
 
+    int first_frame = 0;
+    app.add_option("--first-frame", first_frame, "first frame to export");
+
+    int last_frame = -1;
+    app.add_option(
+        "--last-frame", last_frame,
+        "last frame to export (-1 for the last frame)");
+
     spdlog::level::level_enum loglevel = spdlog::level::warn;
     app.add_option("--log,--loglevel", loglevel, "log level")
         ->default_val(loglevel)
@@ -39,11 +50,30 @@ int main(int argc, char* argv[])
         fs::create_directories(output_path.parent_path());
     }
 
-    SimState sim;
-    bool success = sim.load_scene(sim_path);
-    if (!success) {
+    // Only decode the poses of the frames that are exported
+    SimulationResultsReader results;
+    if (!results.open(sim_path)) {
         return app.exit(
             CLI::Error("load_sim_failed", "Unable to load simulation result!"));
     }
-    sim.save_gltf(output);
+
+    std::vector<RigidBody> rbs;
+    if (!read_rb_scene(results.args()["rigid_body_problem"], rbs)) {
+        return app.exit(
+            CLI::Error("load_sim_failed", "Unable to load simulation scene!"));
+    }
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    results.clamp_frame_range(first_frame, last_frame);
+    if (last_frame < first_frame) {
+        return app.exit(CLI::Error("no_frames", "No frames to export!"));
+    }
+    std::vector<PosesD> poses;
+    poses.reserve(last_frame - first_frame + 1);
+    for (int i = first_frame; i <= last_frame; i++) {
+        poses.push_back(results.frame_poses(i));
+    }
+
+    write_gltf(output, bodies, poses, results.timestep());
 }
@@ -0,0 +1,60 @@
+#include "block_jacobi_preconditioner.hpp"
+
+#include <tbb/parallel_for.h>
+
+namespace ipc::rigid {
+
+void BlockJacobiPreconditioner::compute(
+    const BlockSparseMatrix& A, const VectorXb& is_dof_free)
+{
+    assert(is_dof_free.size() == A.rows());
+    const int bs = A.block_size();
+    m_block_size = bs;
+    m_is_dof_free = is_dof_free;
+    m_blocks.resize(A.num_blocks());
+
+    tbb::parallel_for(
+        tbb::blocked_range<long>(0, A.num_blocks()),
+        [&](const tbb::blocked_range<long>& range) {
+            for (long b = range.begin(); b != range.end(); ++b) {
+                Eigen::MatrixXd block = Eigen::MatrixXd::Zero(bs, bs);
+                if (const double* values = A.find_block(b, b)) {
+                    block = Eigen::Map<const Eigen::MatrixXd>(values, bs, bs);
+                }
+                for (int i = 0; i < bs; i++) {
+                    if (!is_dof_free(b * bs + i)) {
+                        block.row(i).setZero();
+                        block.col(i).setZero();
+                        block(i, i) = 1;
+                    }
+                }
+
+                m_blocks[b].compute(block);
+                if (m_blocks[b].info() != Eigen::Success
+                    || !m_blocks[b].isPositive()) {
+                    // Fall back to Jacobi
+                    Eigen::VectorXd diag = block.diagonal().cwiseAbs();
+                    diag = (diag.array() > 0).select(diag, 1);
+                    m_blocks[b].compute(Eigen::MatrixXd(diag.asDiagonal()));
+                }
+            }
+        });
+}
+
+Eigen::VectorXd BlockJacobiPreconditioner::solve(const Eigen::VectorXd& r) const
+{
+    assert(r.size() == m_blocks.size() * m_block_size);
+    const int bs = m_block_size;
+    Eigen::VectorXd z(r.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, m_blocks.size()),
+        [&](const tbb::blocked_range<size_t>& range) {
+            for (size_t b = range.begin(); b != range.end(); ++b) {
+                z.segment(b * bs, bs) =
+                    m_blocks[b].solve(r.segment(b * bs, bs));
+            }
+        });
+    return m_is_dof_free.select(z, 0);
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+#include <utils/block_sparse_matrix.hpp>
+#include <utils/eigen_ext.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Inverse of the block diagonal of a block sparse matrix.
+///
+/// Each diagonal block is factorized with a dense LDLT. Fixed DoF are
+/// replaced by identity rows and columns, and a block that is not positive
+/// definite falls back to the absolute value of its diagonal.
+class BlockJacobiPreconditioner {
+public:
+    /// @brief Factorize the diagonal blocks of A.
+    /// @param A Matrix to precondition.
+    /// @param is_dof_free Whether each DoF is free.
+    void compute(const BlockSparseMatrix& A, const VectorXb& is_dof_free);
+
+    /// @brief Apply the inverse of the block diagonal to the free DoF of r.
+    Eigen::VectorXd solve(const Eigen::VectorXd& r) const;
+
+protected:
+    int m_block_size = 1;
+    VectorXb m_is_dof_free;
+    std::vector<Eigen::LDLT<Eigen::MatrixXd>> m_blocks;
+};
+
+} // namespace ipc::rigid
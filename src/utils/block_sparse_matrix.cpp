@@ -0,0 +1,166 @@
+#include "block_sparse_matrix.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ipc::rigid {
+
+void BlockSparseMatrix::clear()
+{
+    m_block_ids.clear();
+    m_block_indices.clear();
+    m_values.clear();
+}
+
+double* BlockSparseMatrix::block_data(long i, long j)
+{
+    assert(i >= 0 && i < m_num_blocks && j >= 0 && j < m_num_blocks);
+    const size_t block_entries = m_block_size * m_block_size;
+
+    auto [it, inserted] =
+        m_block_ids.try_emplace(i * m_num_blocks + j, m_block_indices.size());
+    if (inserted) {
+        m_block_indices.emplace_back(i, j);
+        m_values.resize(m_values.size() + block_entries, 0.0);
+    }
+    return m_values.data() + it->second * block_entries;
+}
+
+BlockSparseMatrix& BlockSparseMatrix::operator+=(const BlockSparseMatrix& other)
+{
+    assert(m_num_blocks == other.m_num_blocks);
+    assert(m_block_size == other.m_block_size);
+    const size_t block_entries = m_block_size * m_block_size;
+
+    for (size_t b = 0; b < other.m_block_indices.size(); b++) {
+        const auto& [i, j] = other.m_block_indices[b];
+        double* values = block_data(i, j);
+        const double* other_values = other.m_values.data() + b * block_entries;
+        for (size_t k = 0; k < block_entries; k++) {
+            values[k] += other_values[k];
+        }
+    }
+    return *this;
+}
+
+BlockSparseMatrix&
+BlockSparseMatrix::operator+=(const Eigen::SparseMatrix<double>& other)
+{
+    assert(other.rows() == rows() && other.cols() == cols());
+    const int bs = m_block_size;
+    for (int c = 0; c < other.outerSize(); c++) {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(other, c); it;
+             ++it) {
+            block_data(it.row() / bs, c / bs)[(c % bs) * bs + it.row() % bs] +=
+                it.value();
+        }
+    }
+    return *this;
+}
+
+BlockSparseMatrix& BlockSparseMatrix::operator*=(double s)
+{
+    for (double& value : m_values) {
+        value *= s;
+    }
+    return *this;
+}
+
+Eigen::VectorXd BlockSparseMatrix::operator*(const Eigen::VectorXd& x) const
+{
+    assert(x.size() == cols());
+    const int bs = m_block_size;
+    const size_t block_entries = bs * bs;
+
+    Eigen::VectorXd y = Eigen::VectorXd::Zero(rows());
+    for (size_t b = 0; b < m_block_indices.size(); b++) {
+        const auto& [i, j] = m_block_indices[b];
+        y.segment(i * bs, bs).noalias() +=
+            Eigen::Map<const Eigen::MatrixXd>(
+                m_values.data() + b * block_entries, bs, bs)
+            * x.segment(j * bs, bs);
+    }
+    return y;
+}
+
+const double* BlockSparseMatrix::find_block(long i, long j) const
+{
+    auto it = m_block_ids.find(i * m_num_blocks + j);
+    if (it == m_block_ids.end()) {
+        return nullptr;
+    }
+    return m_values.data() + it->second * m_block_size * m_block_size;
+}
+
+void BlockSparseMatrix::to_sparse(Eigen::SparseMatrix<double>& matrix) const
+{
+    typedef Eigen::SparseMatrix<double>::StorageIndex StorageIndex;
+    const int bs = m_block_size;
+    const size_t block_entries = bs * bs;
+
+    // Sort the blocks by block column and then by block row
+    std::vector<size_t> order(m_block_indices.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::make_pair(
+                   m_block_indices[a].second, m_block_indices[a].first)
+            < std::make_pair(
+                   m_block_indices[b].second, m_block_indices[b].first);
+    });
+
+    // Every column of a block column has the same number of nonzeros
+    std::vector<StorageIndex> outer(cols() + 1, 0);
+    {
+        std::vector<StorageIndex> blocks_per_column(m_num_blocks, 0);
+        for (const auto& [i, j] : m_block_indices) {
+            blocks_per_column[j]++;
+        }
+        for (long c = 0; c < cols(); c++) {
+            outer[c + 1] = outer[c] + blocks_per_column[c / bs] * bs;
+        }
+    }
+    const StorageIndex nnz = outer.back();
+
+    bool reuse_pattern = matrix.rows() == rows() && matrix.cols() == cols()
+        && matrix.isCompressed() && matrix.nonZeros() == nnz
+        && std::equal(outer.begin(), outer.end(), matrix.outerIndexPtr());
+
+    if (!reuse_pattern) {
+        matrix.resize(rows(), cols());
+        matrix.resizeNonZeros(nnz);
+        std::copy(outer.begin(), outer.end(), matrix.outerIndexPtr());
+    }
+
+    StorageIndex* inner = matrix.innerIndexPtr();
+    double* values = matrix.valuePtr();
+    for (size_t k = 0; k < order.size();) {
+        // Blocks of the same block column are contiguous in order
+        const long j = m_block_indices[order[k]].second;
+        size_t end = k;
+        while (end < order.size() && m_block_indices[order[end]].second == j) {
+            end++;
+        }
+
+        for (int c = 0; c < bs; c++) {
+            StorageIndex pos = outer[j * bs + c];
+            for (size_t b = k; b < end; b++) {
+                const long i = m_block_indices[order[b]].first;
+                const double* block_values =
+                    m_values.data() + order[b] * block_entries + c * bs;
+                for (int r = 0; r < bs; r++, pos++) {
+                    if (reuse_pattern && inner[pos] != i * bs + r) {
+                        // Same number of nonzeros but a different pattern
+                        matrix.resize(0, 0);
+                        to_sparse(matrix);
+                        return;
+                    }
+                    inner[pos] = i * bs + r;
+                    values[pos] = block_values[r];
+                }
+            }
+        }
+        k = end;
+    }
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+namespace ipc::rigid {
+
+/// @brief Accumulator for a sparse matrix made of square dense blocks.
+///
+/// Blocks are keyed by their (block row, block column) and summed in place,
+/// so adding a local Hessian costs one hash lookup per block instead of one
+/// triplet per entry. The compressed matrix is assembled directly in
+/// column-major order without sorting any triplets, and if the output
+/// matrix already has the same sparsity pattern only its values are
+/// overwritten. The blocks can also be used directly as a linear operator
+/// without assembling the compressed matrix.
+class BlockSparseMatrix {
+public:
+    BlockSparseMatrix() : BlockSparseMatrix(0, 0) { }
+
+    /// @param num_blocks Number of block rows (and block columns).
+    /// @param block_size Number of rows (and columns) of each block.
+    BlockSparseMatrix(long num_blocks, int block_size)
+        : m_num_blocks(num_blocks)
+        , m_block_size(block_size)
+    {
+    }
+
+    long num_blocks() const { return m_num_blocks; }
+    int block_size() const { return m_block_size; }
+    long rows() const { return m_num_blocks * m_block_size; }
+    long cols() const { return rows(); }
+
+    /// @brief Number of nonzero blocks.
+    size_t num_nonzero_blocks() const { return m_block_indices.size(); }
+
+    /// @brief Remove all blocks.
+    void clear();
+
+    /// @brief Add a dense block to block (i, j).
+    template <typename Derived>
+    void add_block(long i, long j, const Eigen::MatrixBase<Derived>& block)
+    {
+        assert(block.rows() == m_block_size && block.cols() == m_block_size);
+        Eigen::Map<Eigen::MatrixXd>(
+            block_data(i, j), m_block_size, m_block_size) += block;
+    }
+
+    /// @brief Add all blocks of another matrix of the same size.
+    BlockSparseMatrix& operator+=(const BlockSparseMatrix& other);
+
+    /// @brief Add the entries of a sparse matrix to the blocks containing
+    /// them.
+    BlockSparseMatrix& operator+=(const Eigen::SparseMatrix<double>& other);
+
+    /// @brief Scale all blocks.
+    BlockSparseMatrix& operator*=(double s);
+
+    /// @brief Matrix-vector product without assembling the matrix.
+    Eigen::VectorXd operator*(const Eigen::VectorXd& x) const;
+
+    /// @brief Column-major values of block (i, j) or nullptr if it is zero.
+    const double* find_block(long i, long j) const;
+
+    /// @brief Assemble the blocks into a compressed column-major matrix.
+    ///
+    /// The sparsity pattern of matrix is reused if it matches the blocks.
+    void to_sparse(Eigen::SparseMatrix<double>& matrix) const;
+
+protected:
+    /// @brief Pointer to the column-major values of block (i, j).
+    ///
+    /// The block is zero-initialized if it does not exist.
+    double* block_data(long i, long j);
+
+    long m_num_blocks;
+    int m_block_size;
+
+    /// @brief Index of each block in m_block_indices from i * num_blocks + j
+    std::unordered_map<long, size_t> m_block_ids;
+    /// @brief (block row, block column) of each block
+    std::vector<std::pair<long, long>> m_block_indices;
+    /// @brief Column-major values of the blocks stored one after the other
+    std::vector<double> m_values;
+};
+
+} // namespace ipc::rigid
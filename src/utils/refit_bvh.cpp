@@ -0,0 +1,257 @@
+#include "refit_bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+namespace ipc::rigid {
+
+namespace {
+    double surface_area(const Eigen::Array3d& min, const Eigen::Array3d& max)
+    {
+        Eigen::Array3d d = (max - min).max(0);
+        return 2 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+    }
+} // namespace
+
+void RefitBVH::clear()
+{
+    m_nodes.clear();
+    m_leaf_of_box.clear();
+    m_num_boxes = 0;
+    m_build_cost = 0;
+}
+
+void RefitBVH::init(const std::vector<Box>& boxes)
+{
+    clear();
+    m_num_boxes = boxes.size();
+    if (boxes.empty()) {
+        return;
+    }
+
+    m_nodes.reserve(2 * boxes.size() - 1);
+    m_leaf_of_box.resize(boxes.size());
+
+    std::vector<int> ids(boxes.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    build(boxes, ids, 0, ids.size());
+
+    m_build_cost = cost();
+}
+
+int RefitBVH::build(
+    const std::vector<Box>& boxes,
+    std::vector<int>& ids,
+    size_t begin,
+    size_t end)
+{
+    assert(begin < end);
+
+    int node_id = int(m_nodes.size());
+    m_nodes.emplace_back();
+
+    if (end - begin == 1) {
+        Node& leaf = m_nodes[node_id];
+        leaf.box_id = leaf.max_box_id = ids[begin];
+        leaf.min = boxes[leaf.box_id][0].array();
+        leaf.max = boxes[leaf.box_id][1].array();
+        m_leaf_of_box[leaf.box_id] = node_id;
+        return node_id;
+    }
+
+    // Split at the median centroid along the longest axis of the centroids
+    Eigen::Array3d cmin = Eigen::Array3d::Constant(
+                       std::numeric_limits<double>::infinity()),
+                   cmax = -cmin;
+    for (size_t i = begin; i < end; i++) {
+        const Box& box = boxes[ids[i]];
+        Eigen::Array3d c = 0.5 * (box[0] + box[1]).array();
+        cmin = cmin.min(c);
+        cmax = cmax.max(c);
+    }
+    int axis;
+    (cmax - cmin).maxCoeff(&axis);
+
+    size_t mid = (begin + end) / 2;
+    std::nth_element(
+        ids.begin() + begin, ids.begin() + mid, ids.begin() + end,
+        [&](int a, int b) {
+            return boxes[a][0][axis] + boxes[a][1][axis]
+                < boxes[b][0][axis] + boxes[b][1][axis];
+        });
+
+    // NOTE: m_nodes may reallocate, so do not hold references across builds
+    int left = build(boxes, ids, begin, mid);
+    int right = build(boxes, ids, mid, end);
+
+    Node& node = m_nodes[node_id];
+    node.left = left;
+    node.right = right;
+    node.max_box_id =
+        std::max(m_nodes[left].max_box_id, m_nodes[right].max_box_id);
+    node.min = m_nodes[left].min.min(m_nodes[right].min);
+    node.max = m_nodes[left].max.max(m_nodes[right].max);
+    return node_id;
+}
+
+void RefitBVH::refit(const std::vector<Box>& boxes)
+{
+    assert(boxes.size() == m_num_boxes);
+
+    for (size_t i = 0; i < boxes.size(); i++) {
+        Node& leaf = m_nodes[m_leaf_of_box[i]];
+        leaf.min = boxes[i][0].array();
+        leaf.max = boxes[i][1].array();
+    }
+
+    // Children are stored after their parents, so a reverse sweep visits
+    // every child before its parent.
+    for (int i = int(m_nodes.size()) - 1; i >= 0; i--) {
+        Node& node = m_nodes[i];
+        if (!node.is_leaf()) {
+            node.min = m_nodes[node.left].min.min(m_nodes[node.right].min);
+            node.max = m_nodes[node.left].max.max(m_nodes[node.right].max);
+        }
+    }
+}
+
+bool RefitBVH::update(const std::vector<Box>& boxes, double max_cost_ratio)
+{
+    if (boxes.size() != m_num_boxes || m_nodes.empty()) {
+        init(boxes);
+        return true;
+    }
+
+    refit(boxes);
+
+    if (cost() > max_cost_ratio * m_build_cost) {
+        init(boxes);
+        return true;
+    }
+    return false;
+}
+
+double RefitBVH::cost() const
+{
+    if (m_nodes.empty()) {
+        return 0;
+    }
+    double root_area = surface_area(m_nodes[0].min, m_nodes[0].max);
+    if (root_area <= 0) {
+        return 0;
+    }
+    double inner_area = 0;
+    for (const Node& node : m_nodes) {
+        if (!node.is_leaf()) {
+            inner_area += surface_area(node.min, node.max);
+        }
+    }
+    return inner_area / root_area;
+}
+
+template <typename Func>
+void RefitBVH::traverse(
+    const Eigen::Array3d& box_min,
+    const Eigen::Array3d& box_max,
+    const int min_box_id,
+    std::vector<int>& stack,
+    Func f) const
+{
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    stack.clear();
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        if (node.max_box_id <= min_box_id || (node.min > box_max).any()
+            || (box_min > node.max).any()) {
+            continue;
+        }
+
+        if (node.is_leaf()) {
+            f(node.box_id);
+        } else {
+            stack.push_back(node.right);
+            stack.push_back(node.left);
+        }
+    }
+}
+
+void RefitBVH::intersect_box(
+    const Eigen::Vector3d& box_min,
+    const Eigen::Vector3d& box_max,
+    std::vector<unsigned int>& ids) const
+{
+    ids.clear();
+    std::vector<int> stack;
+    traverse(
+        box_min.array(), box_max.array(), /*min_box_id=*/-1, stack,
+        [&](int id) { ids.push_back(id); });
+}
+
+void RefitBVH::intersect_self(
+    std::vector<std::pair<int, int>>& pairs,
+    const std::function<bool(size_t, size_t)>& can_collide) const
+{
+    pairs.clear();
+
+    struct LocalStorage {
+        std::vector<std::pair<int, int>> pairs;
+        /// (first box, first pair, end pair) of each processed range
+        std::vector<std::array<size_t, 3>> ranges;
+        std::vector<int> stack;
+    };
+    tbb::enumerable_thread_specific<LocalStorage> storages;
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), m_num_boxes),
+        [&](const tbb::blocked_range<size_t>& range) {
+            LocalStorage& local = storages.local();
+            size_t pairs_begin = local.pairs.size();
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                const Node& leaf = m_nodes[m_leaf_of_box[i]];
+                // Only boxes with a larger id are visited, so each pair is
+                // found once.
+                traverse(
+                    leaf.min, leaf.max, int(i), local.stack, [&](int j) {
+                        if (can_collide(i, j)) {
+                            local.pairs.emplace_back(int(i), j);
+                        }
+                    });
+            }
+            local.ranges.push_back(
+                { { range.begin(), pairs_begin, local.pairs.size() } });
+        });
+
+    // Deterministic merge: concatenate the ranges in order of their first box
+    std::vector<std::pair<const LocalStorage*, std::array<size_t, 3>>> ranges;
+    size_t num_pairs = 0;
+    for (const LocalStorage& local : storages) {
+        for (const auto& range : local.ranges) {
+            ranges.emplace_back(&local, range);
+        }
+        num_pairs += local.pairs.size();
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) {
+        return a.second[0] < b.second[0];
+    });
+
+    pairs.reserve(num_pairs);
+    for (const auto& [local, range] : ranges) {
+        pairs.insert(
+            pairs.end(), local->pairs.begin() + range[1],
+            local->pairs.begin() + range[2]);
+    }
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace ipc::rigid {
+
+/// @brief A binary AABB tree whose topology can be kept across queries.
+///
+/// Unlike BVH::BVH, the boxes of the leaves can be updated in place (refit)
+/// without rebuilding the tree. The quality of the tree is measured as the
+/// total surface area of the inner nodes relative to the root. When a refit
+/// degrades this cost too much compared to the last build, the tree is
+/// rebuilt from scratch.
+class RefitBVH {
+public:
+    typedef std::array<Eigen::Vector3d, 2> Box;
+
+    /// @brief Build the tree from scratch.
+    void init(const std::vector<Box>& boxes);
+
+    /// @brief Update the leaf boxes and recompute the inner boxes bottom-up.
+    /// @warning The number of boxes must match the one used to build.
+    void refit(const std::vector<Box>& boxes);
+
+    /// @brief Refit the tree or rebuild it if the quality degraded.
+    ///
+    /// @param boxes New boxes (one per leaf).
+    /// @param max_cost_ratio Rebuild if the cost after refitting is larger
+    ///                       than this times the cost after the last build.
+    /// @returns True if the tree was rebuilt.
+    bool update(
+        const std::vector<Box>& boxes,
+        const double max_cost_ratio = DEFAULT_MAX_COST_RATIO);
+
+    /// @brief Find the ids of all boxes overlapping the query box.
+    void intersect_box(
+        const Eigen::Vector3d& box_min,
+        const Eigen::Vector3d& box_max,
+        std::vector<unsigned int>& ids) const;
+
+    /// @brief Find all pairs of overlapping boxes.
+    ///
+    /// Every pair is visited exactly once and reported as (i, j) with i < j.
+    /// The query runs in parallel over the boxes, but the output order is
+    /// deterministic: pairs are grouped by i in increasing order.
+    ///
+    /// @param[out] pairs       Overlapping pairs of box ids.
+    /// @param[in]  can_collide Optional filter on the box ids.
+    void intersect_self(
+        std::vector<std::pair<int, int>>& pairs,
+        const std::function<bool(size_t, size_t)>& can_collide =
+            [](size_t, size_t) { return true; }) const;
+
+    /// @brief Surface area of the inner nodes relative to the root.
+    double cost() const;
+
+    void clear();
+    size_t size() const { return m_num_boxes; }
+    bool empty() const { return m_num_boxes == 0; }
+
+    static constexpr double DEFAULT_MAX_COST_RATIO = 1.5;
+
+protected:
+    struct Node {
+        Eigen::Array3d min, max;
+        int left = -1;   ///< Index of the left child (-1 for leaves)
+        int right = -1;  ///< Index of the right child (-1 for leaves)
+        int box_id = -1; ///< Index of the box stored in a leaf
+        int max_box_id = -1; ///< Largest box index in the subtree
+        bool is_leaf() const { return left < 0; }
+    };
+
+    int build(
+        const std::vector<Box>& boxes,
+        std::vector<int>& ids,
+        size_t begin,
+        size_t end);
+
+    /// @brief Call f on every box overlapping [box_min, box_max] whose index
+    /// is larger than min_box_id.
+    template <typename Func>
+    void traverse(
+        const Eigen::Array3d& box_min,
+        const Eigen::Array3d& box_max,
+        const int min_box_id,
+        std::vector<int>& stack,
+        Func f) const;
+
+    /// @brief Nodes stored so that children always come after their parent.
+    std::vector<Node> m_nodes;
+    /// @brief Node index of each box's leaf.
+    std::vector<int> m_leaf_of_box;
+    size_t m_num_boxes = 0;
+    /// @brief Cost of the tree right after the last build.
+    double m_build_cost = 0;
+};
+
+} // namespace ipc::rigid
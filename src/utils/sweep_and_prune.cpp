@@ -0,0 +1,116 @@
+#include "sweep_and_prune.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace ipc::rigid {
+
+void SweepAndPrune::clear()
+{
+    m_axis = 0;
+    m_order.clear();
+    m_keys.clear();
+    m_boxes.clear();
+    m_num_swaps = 0;
+}
+
+void SweepAndPrune::update(const std::vector<Box>& boxes)
+{
+    m_num_swaps = 0;
+
+    if (boxes.size() != m_boxes.size()) {
+        m_boxes = boxes;
+
+        // Sweep along the axis with the largest spread of box centers
+        Eigen::Array3d mean = Eigen::Array3d::Zero(),
+                       mean_sq = Eigen::Array3d::Zero();
+        size_t num_active = 0;
+        for (const Box& box : m_boxes) {
+            if (is_active(box)) {
+                Eigen::Array3d c = 0.5 * (box[0] + box[1]).array();
+                mean += c;
+                mean_sq += c * c;
+                num_active++;
+            }
+        }
+        if (num_active) {
+            mean /= num_active;
+            mean_sq /= num_active;
+        }
+        (mean_sq - mean * mean).maxCoeff(&m_axis);
+
+        m_keys.resize(m_boxes.size());
+        for (size_t i = 0; i < m_boxes.size(); i++) {
+            // Inactive boxes are moved to the end of the sweep
+            m_keys[i] = is_active(m_boxes[i])
+                ? m_boxes[i][0][m_axis]
+                : std::numeric_limits<double>::infinity();
+        }
+
+        m_order.resize(m_boxes.size());
+        std::iota(m_order.begin(), m_order.end(), 0);
+        std::sort(m_order.begin(), m_order.end(), [&](int a, int b) {
+            return m_keys[a] < m_keys[b];
+        });
+        return;
+    }
+
+    for (size_t i = 0; i < boxes.size(); i++) {
+        m_boxes[i] = boxes[i];
+        // Inactive boxes keep their previous key to avoid moving them
+        if (is_active(boxes[i])) {
+            m_keys[i] = boxes[i][0][m_axis];
+        }
+    }
+
+    // Insertion sort exploiting the order from the previous update
+    for (size_t i = 1; i < m_order.size(); i++) {
+        int id = m_order[i];
+        double key = m_keys[id];
+        size_t j = i;
+        while (j > 0 && m_keys[m_order[j - 1]] > key) {
+            m_order[j] = m_order[j - 1];
+            j--;
+        }
+        m_order[j] = id;
+        m_num_swaps += i - j;
+    }
+}
+
+void SweepAndPrune::intersect_self(
+    std::vector<std::pair<int, int>>& pairs,
+    const std::function<bool(size_t, size_t)>& can_collide) const
+{
+    pairs.clear();
+
+    for (size_t i = 0; i < m_order.size(); i++) {
+        const int a = m_order[i];
+        const Box& box_a = m_boxes[a];
+        if (!is_active(box_a)) {
+            continue;
+        }
+
+        // Every box after a in the sweep starts after a's lower endpoint, so
+        // stop as soon as one starts after a's upper endpoint.
+        for (size_t j = i + 1; j < m_order.size(); j++) {
+            const int b = m_order[j];
+            if (m_keys[b] > box_a[1][m_axis]) {
+                break;
+            }
+
+            const Box& box_b = m_boxes[b];
+            if (!is_active(box_b)
+                || (box_a[0].array() > box_b[1].array()).any()
+                || (box_b[0].array() > box_a[1].array()).any()) {
+                continue;
+            }
+
+            if (can_collide(a, b)) {
+                pairs.emplace_back(std::min(a, b), std::max(a, b));
+            }
+        }
+    }
+}
+
+} // namespace ipc::rigid
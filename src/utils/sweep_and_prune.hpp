@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace ipc::rigid {
+
+/// @brief Sweep-and-prune over a fixed set of boxes with temporal coherence.
+///
+/// The boxes are kept sorted by their lower endpoint along a single sweep
+/// axis. The order is persistent across updates and restored with an
+/// insertion sort, so when the boxes barely move between calls sorting is
+/// close to linear in the number of boxes.
+///
+/// Boxes can be marked inactive by giving them an empty extent (min > max).
+/// Inactive boxes keep their previous place in the sorted order and are
+/// skipped by the sweep.
+class SweepAndPrune {
+public:
+    typedef std::array<Eigen::Vector3d, 2> Box;
+
+    /// @brief Update the boxes and restore the sorted order.
+    ///
+    /// If the number of boxes changed, the sweep axis is recomputed and the
+    /// boxes are sorted from scratch.
+    void update(const std::vector<Box>& boxes);
+
+    /// @brief Find all pairs of overlapping active boxes.
+    ///
+    /// @param[out] pairs       Overlapping pairs (i, j) with i < j.
+    /// @param[in]  can_collide Optional filter on the box ids.
+    void intersect_self(
+        std::vector<std::pair<int, int>>& pairs,
+        const std::function<bool(size_t, size_t)>& can_collide =
+            [](size_t, size_t) { return true; }) const;
+
+    void clear();
+    size_t size() const { return m_boxes.size(); }
+
+    /// @brief Number of swaps performed by the last update.
+    size_t num_swaps() const { return m_num_swaps; }
+
+protected:
+    static bool is_active(const Box& box)
+    {
+        return (box[0].array() <= box[1].array()).all();
+    }
+
+    /// @brief Axis along which the boxes are sorted.
+    int m_axis = 0;
+    /// @brief Box ids sorted by the lower endpoint along the sweep axis.
+    std::vector<int> m_order;
+    /// @brief Lower endpoint of every box along the sweep axis.
+    std::vector<double> m_keys;
+    std::vector<Box> m_boxes;
+    size_t m_num_swaps = 0;
+};
+
+} // namespace ipc::rigid
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace ipc::rigid {
+
+/// @brief Disjoint sets of the integers [0, n) with path halving and union by
+/// size.
+class UnionFind {
+public:
+    explicit UnionFind(size_t n = 0) { reset(n); }
+
+    /// @brief Make every element its own set.
+    void reset(size_t n)
+    {
+        m_parent.resize(n);
+        std::iota(m_parent.begin(), m_parent.end(), 0);
+        m_size.assign(n, 1);
+    }
+
+    size_t size() const { return m_parent.size(); }
+
+    /// @brief Representative of the set containing i.
+    int find(int i)
+    {
+        while (m_parent[i] != i) {
+            m_parent[i] = m_parent[m_parent[i]];
+            i = m_parent[i];
+        }
+        return i;
+    }
+
+    /// @brief Merge the sets containing i and j.
+    void merge(int i, int j)
+    {
+        i = find(i);
+        j = find(j);
+        if (i == j) {
+            return;
+        }
+        if (m_size[i] < m_size[j]) {
+            std::swap(i, j);
+        }
+        m_parent[j] = i;
+        m_size[i] += m_size[j];
+    }
+
+    /// @brief Label each element with the index of its set.
+    ///
+    /// Sets are numbered in order of their smallest element.
+    /// @param[out] labels Set index of each element.
+    /// @returns The number of sets.
+    int components(std::vector<int>& labels)
+    {
+        labels.assign(size(), -1);
+        std::vector<int> root_label(size(), -1);
+        int num_components = 0;
+        for (size_t i = 0; i < size(); i++) {
+            int& label = root_label[find(i)];
+            if (label < 0) {
+                label = num_components++;
+            }
+            labels[i] = label;
+        }
+        return num_components;
+    }
+
+protected:
+    std::vector<int> m_parent;
+    std::vector<int> m_size;
+};
+
+} // namespace ipc::rigid
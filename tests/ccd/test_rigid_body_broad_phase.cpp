@@ -0,0 +1,183 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+#include <tbb/task_arena.h>
+
+#include <igl/edges.h>
+
+#include <ccd/rigid/broad_phase.hpp>
+#include <ccd/rigid/rigid_body_bvh.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+typedef std::vector<std::pair<long, long>> CandidatePairs;
+
+// A grid of unit cubes with random orientations that overlap their neighbors
+RigidBodyAssembler random_cubes(std::mt19937& gen, int n)
+{
+    Eigen::MatrixXd V(8, 3);
+    V << -0.5, -0.5, -0.5, //
+        0.5, -0.5, -0.5,   //
+        -0.5, 0.5, -0.5,   //
+        0.5, 0.5, -0.5,    //
+        -0.5, -0.5, 0.5,   //
+        0.5, -0.5, 0.5,    //
+        -0.5, 0.5, 0.5,    //
+        0.5, 0.5, 0.5;
+    Eigen::MatrixXi F(12, 3);
+    F << 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4, //
+        2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5;
+    Eigen::MatrixXi E;
+    igl::edges(F, E);
+
+    std::uniform_real_distribution<double> jitter(-0.2, 0.2), angle(-3, 3);
+    std::vector<RigidBody> rbs;
+    for (int i = 0; i < n; i++) {
+        PoseD pose = PoseD::Zero(/*dim=*/3);
+        pose.position << i % 2 + jitter(gen), (i / 2) % 2 + jitter(gen),
+            i / 4 + jitter(gen);
+        pose.rotation << angle(gen), angle(gen), angle(gen);
+        rbs.emplace_back(
+            V, E, F, pose, /*velocity=*/PoseD::Zero(3),
+            /*force=*/PoseD::Zero(3), /*density=*/1.0,
+            /*is_dof_fixed=*/VectorMax6b::Zero(6), /*oriented=*/false,
+            /*group_id=*/i);
+    }
+
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+    return bodies;
+}
+
+std::array<CandidatePairs, 3> sorted_pairs(const Candidates& candidates)
+{
+    std::array<CandidatePairs, 3> pairs;
+    for (const auto& c : candidates.ev_candidates) {
+        pairs[0].emplace_back(c.edge_index, c.vertex_index);
+    }
+    for (const auto& c : candidates.ee_candidates) {
+        pairs[1].emplace_back(c.edge0_index, c.edge1_index);
+    }
+    for (const auto& c : candidates.fv_candidates) {
+        pairs[2].emplace_back(c.face_index, c.vertex_index);
+    }
+    for (auto& p : pairs) {
+        std::sort(p.begin(), p.end());
+    }
+    return pairs;
+}
+
+// Candidates computed without a BodyPairCache: every pair transforms the
+// smaller body's vertices and recomputes the larger body's local AABBs.
+Candidates uncached_candidates(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses,
+    const int collision_types,
+    const double inflation_radius)
+{
+    const Poses<Interval> posesI = cast<Interval>(poses);
+    Candidates candidates;
+    for (auto [bodyA_id, bodyB_id] :
+         bodies.close_bodies(poses, poses, inflation_radius)) {
+        sort_body_pair(bodies, bodyA_id, bodyB_id);
+        const MatrixMax3I RA = posesI[bodyA_id].construct_rotation_matrix();
+        const MatrixMax3I RB = posesI[bodyB_id].construct_rotation_matrix();
+        const VectorMax3I pA_minus_pB =
+            posesI[bodyA_id].position - posesI[bodyB_id].position;
+        const MatrixXI VA =
+            ((bodies[bodyA_id].vertices.cast<Interval>() * RA.transpose())
+                 .rowwise()
+             + pA_minus_pB.transpose())
+            * RB;
+        detect_body_pair_collision_candidates_from_aabbs(
+            bodies, vertex_aabbs(VA, inflation_radius),
+            vertex_aabbs(bodies[bodyB_id].vertices, inflation_radius),
+            bodyA_id, bodyB_id, collision_types, candidates,
+            inflation_radius);
+    }
+    return candidates;
+}
+
+bool is_subset(const CandidatePairs& a, const CandidatePairs& b)
+{
+    return std::includes(b.begin(), b.end(), a.begin(), a.end());
+}
+
+} // namespace
+
+TEST_CASE(
+    "Cached body-pair AABBs give the same candidates",
+    "[ccd][broad_phase][rigid_body][bvh]")
+{
+    std::mt19937 gen(GENERATE(0, 1, 2));
+    const RigidBodyAssembler bodies = random_cubes(gen, 8);
+    const PosesD poses = bodies.rb_poses_t1();
+    const int collision_types =
+        CollisionType::EDGE_EDGE | CollisionType::FACE_VERTEX;
+    const double inflation_radius = GENERATE(0.0, 1e-2);
+
+    const auto expected = sorted_pairs(
+        uncached_candidates(bodies, poses, collision_types, inflation_radius));
+    CHECK(expected[0].size() + expected[1].size() + expected[2].size() > 0);
+
+    Candidates candidates;
+    detect_collision_candidates_rigid_bvh(
+        bodies, poses, collision_types, candidates, inflation_radius);
+    CHECK(sorted_pairs(candidates) == expected);
+
+    // The result does not depend on how the pairs are split between threads
+    Candidates serial_candidates;
+    tbb::task_arena(1).execute([&] {
+        detect_collision_candidates_rigid_bvh(
+            bodies, poses, collision_types, serial_candidates,
+            inflation_radius);
+    });
+    CHECK(sorted_pairs(serial_candidates) == expected);
+}
+
+TEST_CASE(
+    "Cached body-pair AABBs are conservative along a trajectory",
+    "[ccd][broad_phase][rigid_body][bvh]")
+{
+    std::mt19937 gen(GENERATE(0, 1, 2));
+    const RigidBodyAssembler bodies = random_cubes(gen, 8);
+    const PosesD poses_t0 = bodies.rb_poses_t1();
+    PosesD poses_t1 = poses_t0;
+    std::uniform_real_distribution<double> step(-0.2, 0.2);
+    for (auto& pose : poses_t1) {
+        pose.position += Eigen::Vector3d(step(gen), step(gen), step(gen));
+        pose.rotation += Eigen::Vector3d(step(gen), step(gen), step(gen));
+    }
+    const int collision_types =
+        CollisionType::EDGE_EDGE | CollisionType::FACE_VERTEX;
+
+    Candidates candidates;
+    detect_collision_candidates_rigid_bvh(
+        bodies, poses_t0, poses_t1, collision_types, candidates);
+    const auto trajectory_pairs = sorted_pairs(candidates);
+
+    // Every candidate of a pose along the trajectory is a candidate of the
+    // whole trajectory.
+    for (int i = 0; i <= 10; i++) {
+        const PosesD poses = interpolate(poses_t0, poses_t1, i / 10.0);
+        const auto pairs = sorted_pairs(
+            uncached_candidates(bodies, poses, collision_types, 0.0));
+        for (int j = 0; j < 3; j++) {
+            CAPTURE(i, j);
+            CHECK(is_subset(pairs[j], trajectory_pairs[j]));
+        }
+    }
+
+    Candidates serial_candidates;
+    tbb::task_arena(1).execute([&] {
+        detect_collision_candidates_rigid_bvh(
+            bodies, poses_t0, poses_t1, collision_types, serial_candidates);
+    });
+    CHECK(sorted_pairs(serial_candidates) == trajectory_pairs);
+}
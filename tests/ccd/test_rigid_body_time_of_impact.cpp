@@ -8,6 +8,7 @@
 
 // #include <ccd.hpp>
 #include <ccd/piecewise_linear/time_of_impact.hpp>
+#include <ccd/rigid/rigid_trajectory_aabb.hpp>
 #include <ccd/rigid/time_of_impact.hpp>
 #include <constants.hpp>
 #include <io/serialize_json.hpp>
@@ -165,6 +166,156 @@ TEST_CASE("Rigid edge-vertex time of impact", "[ccd][rigid_toi][edge_vertex]")
     }
 }
 
+TEST_CASE(
+    "Rigid edge-vertex time of impact lower bound",
+    "[ccd][rigid_toi][edge_vertex][toi_lower_bound]")
+{
+    int dim = 2;
+    Eigen::MatrixXd bodyA_vertices(2, dim);
+    bodyA_vertices.row(0) << -1, 0;
+    bodyA_vertices.row(1) << 1, 0;
+    Eigen::MatrixXd bodyB_vertices(2, dim);
+    bodyB_vertices.row(0) << -2, 0;
+    bodyB_vertices.row(1) << 2, 0;
+    Eigen::MatrixXi edges(1, 2);
+    edges.row(0) << 0, 1;
+
+    RigidBody bodyA = create_body(bodyA_vertices, edges);
+    RigidBody bodyB = create_body(bodyB_vertices, edges);
+
+    double y_t0 = GENERATE(0.5, 2.0, 10.0);
+    double theta = GENERATE(0.0, igl::PI / 6.0, igl::PI);
+    Pose<double> bodyA_pose_t0(0, y_t0, 0);
+    Pose<double> bodyA_pose_t1(0, y_t0 - 1, theta);
+    Pose<double> bodyB_pose = Pose<double>::Zero(dim);
+
+    double toi_lower_bound = compute_edge_vertex_time_of_impact_lower_bound(
+        bodyA, bodyA_pose_t0, bodyA_pose_t1, /*vertex_id=*/0, //
+        bodyB, bodyB_pose, bodyB_pose, /*edge_id=*/0);
+    CHECK(toi_lower_bound >= 0);
+
+    double toi;
+    bool is_impacting = compute_edge_vertex_time_of_impact(
+        bodyA, bodyA_pose_t0, bodyA_pose_t1, /*vertex_id=*/0, //
+        bodyB, bodyB_pose, bodyB_pose, /*edge_id=*/0,         //
+        toi, /*earliest_toi=*/1, /*toi_tolerance=*/TESTING_TOI_TOLERANCE);
+    CAPTURE(y_t0, theta, toi, toi_lower_bound);
+    if (is_impacting) {
+        CHECK(toi_lower_bound <= toi + TESTING_TOI_TOLERANCE);
+    }
+    if (y_t0 == 10.0) {
+        // The bodies are too far apart to reach each other
+        CHECK(toi_lower_bound >= 1);
+        CHECK(!is_impacting);
+    }
+}
+
+TEST_CASE(
+    "Rigid edge-edge time of impact lower bound",
+    "[ccd][rigid_toi][edge_edge][toi_lower_bound]")
+{
+    int dim = 3;
+    Eigen::MatrixXd bodyA_vertices(2, dim);
+    bodyA_vertices.row(0) << -1, 0, 0;
+    bodyA_vertices.row(1) << 1, 0, 0;
+    Eigen::MatrixXd bodyB_vertices(2, dim);
+    bodyB_vertices.row(0) << 0, 0, -1;
+    bodyB_vertices.row(1) << 0, 0, 1;
+    Eigen::MatrixXi edges(1, 2);
+    edges.row(0) << 0, 1;
+
+    RigidBody bodyA = create_body(bodyA_vertices, edges);
+    RigidBody bodyB = create_body(bodyB_vertices, edges);
+
+    double y_t0 = GENERATE(0.5, 2.0, 10.0);
+    double theta = GENERATE(0.0, igl::PI / 6.0, igl::PI);
+    Pose<double> bodyA_pose_t0 = Pose<double>::Zero(dim);
+    bodyA_pose_t0.position.y() = y_t0;
+    Pose<double> bodyA_pose_t1 = bodyA_pose_t0;
+    bodyA_pose_t1.position.y() -= 2;
+    bodyA_pose_t1.rotation << 0, theta, theta;
+    Pose<double> bodyB_pose = Pose<double>::Zero(dim);
+
+    double toi_lower_bound = compute_edge_edge_time_of_impact_lower_bound(
+        bodyA, bodyA_pose_t0, bodyA_pose_t1, /*edgeA_id=*/0, //
+        bodyB, bodyB_pose, bodyB_pose, /*edgeB_id=*/0);
+    CHECK(toi_lower_bound >= 0);
+
+    double toi;
+    bool is_impacting = compute_edge_edge_time_of_impact(
+        bodyA, bodyA_pose_t0, bodyA_pose_t1, /*edgeA_id=*/0, //
+        bodyB, bodyB_pose, bodyB_pose, /*edgeB_id=*/0,       //
+        toi, /*earliest_toi=*/1, /*toi_tolerance=*/TESTING_TOI_TOLERANCE);
+    CAPTURE(y_t0, theta, toi, toi_lower_bound);
+    if (is_impacting) {
+        CHECK(toi_lower_bound <= toi + TESTING_TOI_TOLERANCE);
+    }
+    if (y_t0 == 0.5 && theta == 0) {
+        CHECK(is_impacting);
+    }
+    if (y_t0 == 10.0) {
+        // The bodies are too far apart to reach each other
+        CHECK(toi_lower_bound >= 1);
+        CHECK(!is_impacting);
+    }
+}
+
+TEST_CASE(
+    "Rigid face-vertex time of impact lower bound",
+    "[ccd][rigid_toi][face_vertex][toi_lower_bound]")
+{
+    int dim = 3;
+    Eigen::MatrixXd bodyA_vertices(3, dim);
+    bodyA_vertices.row(0) << 0, 0, 0;
+    bodyA_vertices.row(1) << 1, 0, 1;
+    bodyA_vertices.row(2) << 0, 1, 1;
+    Eigen::MatrixXd bodyB_vertices(3, dim);
+    bodyB_vertices.row(0) << -2, -2, 0;
+    bodyB_vertices.row(1) << 2, -2, 0;
+    bodyB_vertices.row(2) << 0, 2, 0;
+    Eigen::MatrixXi faces(1, 3);
+    faces.row(0) << 0, 1, 2;
+    Eigen::MatrixXi edges;
+    igl::edges(faces, edges);
+
+    RigidBody bodyA = create_body(bodyA_vertices, edges, faces);
+    RigidBody bodyB = create_body(bodyB_vertices, edges, faces);
+
+    // The vertex is at the origin of bodyA, so it only translates
+    double z_t0 = GENERATE(0.5, 1.0, 10.0);
+    double theta = GENERATE(0.0, igl::PI / 6.0, igl::PI);
+    Pose<double> bodyA_pose_t0 = Pose<double>::Zero(dim);
+    bodyA_pose_t0.position.z() = z_t0;
+    Pose<double> bodyA_pose_t1 = bodyA_pose_t0;
+    bodyA_pose_t1.position.z() -= 2;
+    bodyA_pose_t1.rotation << theta, 0, theta;
+    Pose<double> bodyB_pose = Pose<double>::Zero(dim);
+
+    double toi_lower_bound = compute_face_vertex_time_of_impact_lower_bound(
+        bodyA, bodyA_pose_t0, bodyA_pose_t1, /*vertex_id=*/0, //
+        bodyB, bodyB_pose, bodyB_pose, /*face_id=*/0);
+    CHECK(toi_lower_bound >= 0);
+
+    double toi;
+    bool is_impacting = compute_face_vertex_time_of_impact(
+        bodyA, bodyA_pose_t0, bodyA_pose_t1, /*vertex_id=*/0, //
+        bodyB, bodyB_pose, bodyB_pose, /*face_id=*/0,         //
+        toi, /*earliest_toi=*/1, /*toi_tolerance=*/TESTING_TOI_TOLERANCE);
+    CAPTURE(z_t0, theta, toi, toi_lower_bound);
+    if (z_t0 < 2) {
+        CHECK(is_impacting);
+        CHECK(toi == Approx(z_t0 / 2).margin(Constants::RIGID_CCD_LENGTH_TOL));
+    }
+    if (is_impacting) {
+        CHECK(toi_lower_bound <= toi + TESTING_TOI_TOLERANCE);
+    }
+    if (z_t0 == 10.0) {
+        // The bodies are too far apart to reach each other
+        CHECK(toi_lower_bound >= 1);
+        CHECK(!is_impacting);
+    }
+}
+
 TEST_CASE("Rigid edge-edge time of impact", "[ccd][rigid_toi][edge_edge]")
 {
     int dim = 3;
@@ -228,6 +379,73 @@ TEST_CASE("Rigid edge-edge time of impact", "[ccd][rigid_toi][edge_edge]")
     }
 }
 
+TEST_CASE(
+    "Fixed-dimension rigid trajectory AABBs",
+    "[ccd][rigid_toi][edge_edge][face_vertex]")
+{
+    int dim = 3;
+    Eigen::MatrixXd vertices(3, dim);
+    vertices.row(0) << -1, 0, 0;
+    vertices.row(1) << 1, 0, 0;
+    vertices.row(2) << 0, 1, 0.5;
+    Eigen::MatrixXi faces(1, 3);
+    faces.row(0) << 0, 1, 2;
+    Eigen::MatrixXi edges;
+    igl::edges(faces, edges);
+
+    RigidBody bodyA = create_body(vertices, edges, faces);
+    RigidBody bodyB = create_body(vertices, edges, faces);
+
+    Pose<double> poseA_t0 = Pose<double>::Zero(dim);
+    Pose<double> poseA_t1 = Pose<double>::Zero(dim);
+    poseA_t1.position << 0.1, 0.5, -0.2;
+    poseA_t1.rotation << 0.3, -1.2, 2.0;
+    Pose<double> poseB_t0 = Pose<double>::Zero(dim);
+    poseB_t0.position.y() = 1;
+    Pose<double> poseB_t1 = poseB_t0;
+    poseB_t1.rotation << igl::PI, 0, 0;
+
+    const Pose<Interval> poseIA_t0 = poseA_t0.cast<Interval>(),
+                         poseIA_t1 = poseA_t1.cast<Interval>(),
+                         poseIB_t0 = poseB_t0.cast<Interval>(),
+                         poseIB_t1 = poseB_t1.cast<Interval>();
+
+    RigidTrajectoryPairAABB<3> trajectory(
+        bodyA, poseA_t0, poseA_t1, bodyB, poseB_t0, poseB_t1);
+
+    // Revisit time intervals after more than the cache holds
+    std::vector<Interval> ts;
+    for (int i = 0; i < 2 * RigidTrajectoryPairAABB<3>::CACHE_SIZE; i++) {
+        ts.emplace_back(i / 20.0, (i + 1) / 10.0);
+    }
+    ts.emplace_back(0, 1);
+    ts.emplace_back(1);
+    ts.insert(ts.end(), ts.rbegin(), ts.rend());
+    Interval a(0.2, 0.3), b(0.4, 1);
+
+    for (const Interval& t : ts) {
+        CAPTURE(t.lower(), t.upper());
+        const Vector3I ee = trajectory.edge_edge(0, 1, t, a, b);
+        const VectorMax3I expected_ee = edge_edge_aabb(
+            bodyA, poseIA_t0, poseIA_t1, 0, bodyB, poseIB_t0, poseIB_t1, 1, t,
+            a, b);
+        const Vector3I fv = trajectory.face_vertex(2, 0, t, a, b);
+        const VectorMax3I expected_fv = face_vertex_aabb(
+            bodyA, poseIA_t0, poseIA_t1, 2, bodyB, poseIB_t0, poseIB_t1, 0, t,
+            a, b);
+        for (int i = 0; i < dim; i++) {
+            CHECK(
+                ee(i).lower() == Approx(expected_ee(i).lower()).margin(1e-10));
+            CHECK(
+                ee(i).upper() == Approx(expected_ee(i).upper()).margin(1e-10));
+            CHECK(
+                fv(i).lower() == Approx(expected_fv(i).lower()).margin(1e-10));
+            CHECK(
+                fv(i).upper() == Approx(expected_fv(i).upper()).margin(1e-10));
+        }
+    }
+}
+
 TEST_CASE("Rigid face-vertex time of impact", "[ccd][rigid_toi][face_vertex]")
 {
     int dim = 3;
@@ -75,3 +75,70 @@ TEST_CASE("Root of simple function with constraints", "[ccd][interval]")
                    .margin(ipc::rigid::Constants::INTERVAL_ROOT_FINDER_TOL));
     }
 }
+
+TEST_CASE("Batched root of a 2D function", "[ccd][interval]")
+{
+    using namespace ipc::rigid;
+    typedef Eigen::Matrix<Interval, 2, 1> Box;
+
+    // Earliest t such that the point (t, s) reaches the circle of radius 0.5
+    // centered at (1, 0.5) for some s ∈ [0, 1].
+    size_t max_batch_size = 0;
+    auto f = [&](const IntervalBoxes<2>& x, IntervalBoxes<2>& y) {
+        max_batch_size = std::max(max_batch_size, x.size());
+        for (size_t i = 0; i < x.size(); i++) {
+            const Interval &t = x.coord(0)[i], &s = x.coord(1)[i];
+            const Interval r = (t - 1.0) * (t - 1.0)
+                + (s - 0.5) * (s - 0.5) - Interval(0.25);
+            y.push_back(Box(r, r));
+        }
+    };
+    auto always_true = [](const Box&) { return true; };
+
+    const double tol = 1e-6;
+    Box sol;
+    bool found_root = interval_root_finder_batched<2>(
+        f, always_true, always_true, Box(Interval(0, 1), Interval(0, 1)),
+        Eigen::Vector2d::Constant(tol), sol);
+    CHECK(found_root);
+    if (found_root) {
+        CHECK(sol(0).lower() == Approx(0.5).margin(2 * tol));
+        CHECK(sol(0).lower() <= 0.5);
+    }
+    CHECK(max_batch_size > 1);
+    CHECK(max_batch_size <= Constants::INTERVAL_ROOT_FINDER_BATCH_SIZE);
+}
+
+TEST_CASE("Batched root finder honors max_iterations", "[ccd][interval]")
+{
+    using namespace ipc::rigid;
+    typedef Eigen::Matrix<Interval, 2, 1> Box;
+
+    int num_evaluated = 0;
+    auto f = [&](const IntervalBoxes<2>& x, IntervalBoxes<2>& y) {
+        num_evaluated += x.size();
+        for (size_t i = 0; i < x.size(); i++) {
+            const Interval &t = x.coord(0)[i], &s = x.coord(1)[i];
+            const Interval r = (t - 1.0) * (t - 1.0)
+                + (s - 0.5) * (s - 0.5) - Interval(0.25);
+            y.push_back(Box(r, r));
+        }
+    };
+    auto always_true = [](const Box&) { return true; };
+
+    const int max_iterations = GENERATE(1, 10, 100, -1);
+    Box sol;
+    bool found_root = interval_root_finder_batched<2>(
+        f, always_true, always_true, Box(Interval(0, 1), Interval(0, 1)),
+        Eigen::Vector2d::Constant(1e-6), sol, max_iterations,
+        /*batch_size=*/8);
+    CHECK(found_root);
+    // The root is conservative even if the search stops early
+    CHECK(sol(0).lower() <= 0.5);
+    if (max_iterations >= 0) {
+        // One extra evaluation checks the tolerance box
+        CHECK(num_evaluated <= max_iterations + 1);
+    } else {
+        CHECK(sol(0).lower() == Approx(0.5).margin(2e-6));
+    }
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch.hpp>
+
+#include <cfenv>
+#include <limits>
+#include <random>
+
+#include <interval/mode_free_rounding.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Outward rounding without changing the rounding mode", "[interval]")
+{
+    double x = GENERATE(0.0, 1.0, -1.0, 1e-300, -1e300, 0.1, 4.9e-324);
+    CHECK(next_up(x) > x);
+    CHECK(next_down(x) < x);
+    CHECK(next_up(std::numeric_limits<double>::infinity()) > 0);
+    CHECK(next_down(-std::numeric_limits<double>::infinity()) < 0);
+}
+
+TEST_CASE("Mode-free rounding clamps overflow", "[interval]")
+{
+    const double max = std::numeric_limits<double>::max();
+    ModeFreeRounding rnd;
+    // A finite result that overflows is bounded by the largest double
+    CHECK(rnd.mul_down(max, 2.0) == max);
+    CHECK(rnd.div_down(max, 0.5) == max);
+    CHECK(rnd.add_down(max, max) == max);
+    CHECK(rnd.mul_up(-max, 2.0) == -max);
+    CHECK(rnd.div_up(-max, 0.5) == -max);
+    CHECK(rnd.sub_up(-max, max) == -max);
+    // The other bound stays infinite
+    CHECK(rnd.mul_up(max, 2.0) == std::numeric_limits<double>::infinity());
+    CHECK(rnd.mul_down(-max, 2.0) == -std::numeric_limits<double>::infinity());
+}
+
+TEST_CASE("Mode-free rounding keeps the rounding mode", "[interval]")
+{
+    typedef boost::numeric::interval<
+        double,
+        boost::numeric::interval_lib::policies<
+            boost::numeric::interval_lib::save_state_nothing<ModeFreeRounding>,
+            boost::numeric::interval_lib::checking_base<double>>>
+        ModeFreeInterval;
+
+    REQUIRE(std::fegetround() == FE_TONEAREST);
+
+    ModeFreeRounding rnd;
+    CHECK(rnd.int_down(-1.5) == -2);
+    CHECK(rnd.int_up(-1.5) == -1);
+    CHECK(rnd.median(1.0, 2.0) == 1.5);
+    CHECK(std::fegetround() == FE_TONEAREST);
+
+    // cos reduces its argument with fmod, which uses int_down
+    const ModeFreeInterval y = cos(ModeFreeInterval(7.0, 7.5));
+    CHECK(y.lower() <= std::cos(7.0));
+    CHECK(std::cos(7.5) <= y.upper());
+    CHECK(std::fegetround() == FE_TONEAREST);
+}
+
+TEST_CASE("Mode-free rounding bounds the exact result", "[interval]")
+{
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> value(-10, 10);
+    ModeFreeRounding rnd;
+
+    for (int trial = 0; trial < 1000; trial++) {
+        const double x = value(gen), y = value(gen);
+        const long double xl = x, yl = y;
+        CHECK(rnd.add_down(x, y) <= xl + yl);
+        CHECK(xl + yl <= rnd.add_up(x, y));
+        CHECK(rnd.sub_down(x, y) <= xl - yl);
+        CHECK(xl - yl <= rnd.sub_up(x, y));
+        CHECK(rnd.mul_down(x, y) <= xl * yl);
+        CHECK(xl * yl <= rnd.mul_up(x, y));
+        CHECK(rnd.div_down(x, y) <= xl / yl);
+        CHECK(xl / yl <= rnd.div_up(x, y));
+    }
+
+    // Exact results are not widened
+    CHECK(rnd.add_down(1.0, -1.0) == 0);
+    CHECK(rnd.mul_up(0.0, 3.0) == 0);
+    CHECK(rnd.conv_down(0.5) == 0.5);
+}
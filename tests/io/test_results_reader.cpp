@@ -0,0 +1,99 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/results_reader.hpp>
+#include <io/trajectory.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Read frames of simulation results", "[io][results]")
+{
+    std::vector<nlohmann::json> states;
+    for (int i = 0; i < 10; i++) {
+        nlohmann::json jrb;
+        jrb["position"] = { i, -i };
+        jrb["rotation"] = { 0.5 * i };
+        jrb["linear_velocity"] = { 1, 2 };
+        jrb["angular_velocity"] = { 3 };
+        states.push_back({ { "rigid_bodies", { jrb, jrb } } });
+    }
+    nlohmann::json args = {
+        { "timestep", 0.1 },
+        // Strings with brackets, quotes, and escapes must not confuse the scan
+        { "scene", "[{\"tricky\\\" ]}" },
+    };
+    nlohmann::json stats = { { "num_contacts", { 1, 2, 3 } } };
+
+    const fs::path dir = fs::temp_directory_path();
+    std::string filename;
+    SECTION("JSON")
+    {
+        nlohmann::json results;
+        results["args"] = args;
+        results["animation"]["state_sequence"] = states;
+        results["stats"] = stats;
+
+        filename = (dir / "test_results_reader.json").string();
+        std::ofstream(filename) << results.dump(GENERATE(-1, 4));
+    }
+    SECTION("Trajectory")
+    {
+        filename = (dir / "test_results_reader.traj").string();
+        TrajectoryWriter writer;
+        REQUIRE(writer.open(
+            filename, 2, 2, 0.1, { { "args", args }, { "stats", stats } }));
+        for (const auto& state : states) {
+            REQUIRE(writer.write_step(state));
+        }
+        REQUIRE(writer.close());
+    }
+
+    SimulationResultsReader reader;
+    REQUIRE(reader.open(filename));
+    CHECK(reader.args() == args);
+    CHECK(reader.stats() == stats);
+    CHECK(reader.timestep() == 0.1);
+    REQUIRE(reader.num_frames() == states.size());
+
+    const bool is_trajectory = filename.size() > 5
+        && filename.substr(filename.size() - 5) == ".traj";
+    for (size_t i : { 7, 0, 9, 3 }) {
+        const nlohmann::json state = reader.frame_state(i);
+        if (is_trajectory && i + 1 < states.size()) {
+            // Trajectories only store the poses of intermediate frames
+            for (size_t j = 0; j < 2; j++) {
+                CHECK(
+                    state["rigid_bodies"][j]["position"]
+                    == states[i]["rigid_bodies"][j]["position"]);
+                CHECK(
+                    state["rigid_bodies"][j]["rotation"]
+                    == states[i]["rigid_bodies"][j]["rotation"]);
+            }
+        } else {
+            CHECK(state["rigid_bodies"] == states[i]["rigid_bodies"]);
+        }
+        const PosesD poses = reader.frame_poses(i);
+        REQUIRE(poses.size() == 2);
+        CHECK(poses[1].position.x() == i);
+        CHECK(poses[1].position.y() == -double(i));
+        CHECK(poses[1].rotation.x() == 0.5 * i);
+    }
+
+    fs::remove(filename);
+}
+
+TEST_CASE("Reject files that are not simulation results", "[io][results]")
+{
+    const std::string filename =
+        (fs::temp_directory_path() / "test_results_reader_scene.json").string();
+    std::ofstream(filename) << R"({"scene_type": "rigid_body_problem"})";
+
+    SimulationResultsReader reader;
+    CHECK(!reader.open(filename));
+
+    fs::remove(filename);
+}
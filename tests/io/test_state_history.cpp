@@ -0,0 +1,122 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <sstream>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/state_history.hpp>
+
+using namespace ipc::rigid;
+
+TEST_CASE("Stream the state history to disk", "[io][json]")
+{
+    const size_t window_size = GENERATE(1, 4, 100);
+    StateHistory history(window_size);
+    CHECK(history.empty());
+
+    const int num_states = 20;
+    for (int i = 0; i < num_states; i++) {
+        nlohmann::json state;
+        state["step"] = i;
+        state["rigid_bodies"] = { { { "position", { i, 2 * i } } } };
+        history.push_back(state);
+    }
+    REQUIRE(history.size() == num_states);
+    CHECK(history.back()["step"] == num_states - 1);
+
+    SECTION("Random access")
+    {
+        for (int i : { 0, 7, 19, 3, 18 }) {
+            CHECK(history[i]["step"] == i);
+            CHECK(history[i]["rigid_bodies"][0]["position"][1] == 2 * i);
+        }
+    }
+
+    SECTION("Write as a JSON array")
+    {
+        std::stringstream ss;
+        history.write_json_array(ss);
+        nlohmann::json states = nlohmann::json::parse(ss.str());
+        REQUIRE(states.size() == num_states);
+        for (int i = 0; i < num_states; i++) {
+            CHECK(states[i] == history[i]);
+        }
+    }
+
+    SECTION("Append after reading")
+    {
+        CHECK(history[0]["step"] == 0);
+        history.push_back({ { "step", num_states } });
+        CHECK(history[num_states]["step"] == num_states);
+        CHECK(history[1]["step"] == 1);
+    }
+
+    SECTION("Clear")
+    {
+        history.clear();
+        CHECK(history.empty());
+        history.push_back({ { "step", 42 } });
+        REQUIRE(history.size() == 1);
+        CHECK(history[0]["step"] == 42);
+    }
+}
+
+TEST_CASE("Stream the state history into a kept file", "[io][json]")
+{
+    const std::string filename =
+        (fs::temp_directory_path() / "test_state_history.json").string();
+    const size_t window_size = GENERATE(1, 100);
+    const int num_states = 10;
+    std::string temporary_filename;
+    {
+        StateHistory history(window_size);
+        temporary_filename = history.filename();
+        CHECK(fs::exists(temporary_filename));
+        for (int i = 0; i < num_states; i++) {
+            history.push_back({ { "step", i } });
+        }
+
+        REQUIRE(history.stream_to(filename, R"({"states":)"));
+        CHECK(history.filename() == filename);
+        CHECK(!fs::exists(temporary_filename));
+        for (int i : { 0, 5, 9 }) {
+            CHECK(history[i]["step"] == i);
+        }
+
+        // A footer completes the file, and the next state replaces it
+        CHECK(history.finish(R"(,"is_complete":true})"));
+        nlohmann::json saved =
+            nlohmann::json::parse(std::ifstream(filename, std::ios::binary));
+        CHECK(saved["states"].size() == num_states);
+        CHECK(saved["is_complete"] == true);
+
+        history.push_back({ { "step", num_states } });
+        CHECK(history[num_states]["step"] == num_states);
+        CHECK(history.finish("}"));
+        saved =
+            nlohmann::json::parse(std::ifstream(filename, std::ios::binary));
+        CHECK(saved["states"].size() == num_states + 1);
+        CHECK(!saved.contains("is_complete"));
+
+        // Without a footer, there is one state per line after the header
+        history.push_back({ { "step", num_states + 1 } });
+    }
+    CHECK(!fs::exists(temporary_filename));
+    REQUIRE(fs::exists(filename));
+
+    std::ifstream input(filename, std::ios::binary);
+    std::string line;
+    REQUIRE(std::getline(input, line));
+    CHECK(line == R"({"states":[)");
+    int num_lines = 0;
+    while (std::getline(input, line)) {
+        const nlohmann::json state =
+            nlohmann::json::parse(line.substr(num_lines > 0));
+        CHECK(state["step"] == num_lines);
+        num_lines++;
+    }
+    CHECK(num_lines == num_states + 2);
+    input.close();
+    fs::remove(filename);
+}
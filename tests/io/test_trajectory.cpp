@@ -0,0 +1,134 @@
+#include <catch2/catch.hpp>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/serialize_json.hpp>
+#include <io/trajectory.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Binary trajectory round trip", "[io][trajectory]")
+{
+    const int dim = GENERATE(2, 3);
+    const bool single_precision = GENERATE(false, true);
+    const int ndof = PoseD::dim_to_ndof(dim);
+    const size_t num_bodies = 3, num_steps = 5;
+
+    std::vector<nlohmann::json> states;
+    for (size_t i = 0; i < num_steps; i++) {
+        std::vector<nlohmann::json> rbs;
+        for (size_t j = 0; j < num_bodies; j++) {
+            Eigen::VectorXd pose = Eigen::VectorXd::Random(ndof);
+            Eigen::VectorXd velocity = Eigen::VectorXd::Random(ndof);
+            nlohmann::json jrb;
+            jrb["position"] = to_json(Eigen::VectorXd(pose.head(dim)));
+            jrb["rotation"] = to_json(Eigen::VectorXd(pose.tail(ndof - dim)));
+            jrb["linear_velocity"] =
+                to_json(Eigen::VectorXd(velocity.head(dim)));
+            jrb["angular_velocity"] =
+                to_json(Eigen::VectorXd(velocity.tail(ndof - dim)));
+            if (dim == 3) {
+                jrb["Qdot"] =
+                    to_json(Eigen::Matrix3d(Eigen::Matrix3d::Random()));
+                jrb["Qddot"] =
+                    to_json(Eigen::Matrix3d(Eigen::Matrix3d::Random()));
+            }
+            rbs.push_back(jrb);
+        }
+        states.push_back(
+            { { "rigid_bodies", rbs },
+              { "kinetic_energy", double(i) },
+              { "linear_momentum", { 1.0 * i, 2.0 * i } } });
+    }
+    // A field that is only in some states
+    states[2]["min_distance"] = 1e-3;
+
+    const std::string filename =
+        (fs::temp_directory_path() / "test_trajectory.traj").string();
+    nlohmann::json metadata = { { "args", { { "timestep", 0.01 } } } };
+
+    TrajectoryWriter writer;
+    REQUIRE(writer.open(
+        filename, dim, num_bodies, 0.01, metadata, single_precision));
+    for (const auto& state : states) {
+        REQUIRE(writer.write_step(state));
+    }
+    REQUIRE(writer.close());
+
+    CHECK(is_trajectory_file(filename));
+    TrajectoryReader reader;
+    REQUIRE(reader.open(filename));
+    CHECK(reader.dim() == dim);
+    CHECK(reader.num_bodies() == num_bodies);
+    CHECK(reader.num_steps() == num_steps);
+    CHECK(reader.timestep() == 0.01);
+    CHECK(reader.metadata() == metadata);
+
+    CHECK(reader.is_complete());
+
+    const double tol = single_precision ? 1e-6 : 0;
+    // Read the steps out of order
+    for (size_t i : { 3, 0, 4, 1, 2 }) {
+        CAPTURE(i);
+        const nlohmann::json state = reader.read_state(i);
+        const PosesD poses = reader.read_poses(i);
+        REQUIRE(poses.size() == num_bodies);
+        for (size_t j = 0; j < num_bodies; j++) {
+            const auto& expected = states[i]["rigid_bodies"][j];
+            VectorMax3d position, rotation;
+            from_json(expected["position"], position);
+            from_json(expected["rotation"], rotation);
+            CHECK(
+                (poses[j].position - position).lpNorm<Eigen::Infinity>()
+                <= tol);
+            CHECK(
+                (poses[j].rotation - rotation).lpNorm<Eigen::Infinity>()
+                <= tol);
+        }
+
+        // The other fields of the state are kept for every step
+        CHECK(state["kinetic_energy"] == states[i]["kinetic_energy"]);
+        CHECK(state["linear_momentum"] == states[i]["linear_momentum"]);
+        if (state.contains("min_distance")) {
+            CHECK(
+                state["min_distance"]
+                == (i == 2 ? nlohmann::json(1e-3) : nlohmann::json()));
+        } else {
+            CHECK(!states[i].contains("min_distance"));
+        }
+
+        if (i + 1 == num_steps) {
+            // The final state is saved in full
+            CHECK(state == states[i]);
+        } else {
+            // Other steps only store the poses
+            const auto& jrb = state["rigid_bodies"][0];
+            CHECK(jrb.contains("position"));
+            CHECK(jrb.contains("rotation"));
+            CHECK(!jrb.contains("linear_velocity"));
+        }
+    }
+
+    SECTION("Unclosed and truncated files")
+    {
+        // Drop the trailer and half of the last step
+        const size_t step_bytes = num_bodies * ndof
+            * (single_precision ? sizeof(float) : sizeof(double));
+        const size_t steps_end = sizeof(TrajectoryHeader)
+            + metadata.dump().size() + num_steps * step_bytes;
+        fs::resize_file(filename, steps_end - step_bytes / 2);
+
+        TrajectoryReader truncated;
+        REQUIRE(truncated.open(filename));
+        CHECK(!truncated.is_complete());
+        CHECK(truncated.num_steps() == num_steps - 1);
+        const PosesD poses = truncated.read_poses(num_steps - 2);
+        VectorMax3d position;
+        from_json(
+            states[num_steps - 2]["rigid_bodies"][0]["position"], position);
+        CHECK((poses[0].position - position).lpNorm<Eigen::Infinity>() <= tol);
+    }
+
+    fs::remove(filename);
+}
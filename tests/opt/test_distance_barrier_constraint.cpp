@@ -1,5 +1,11 @@
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+
+#include <tbb/task_arena.h>
+
+#include <ccd/ccd.hpp>
+#include <constants.hpp>
 #include <logger.hpp>
 #include <opt/distance_barrier_constraint.hpp>
 
@@ -102,3 +108,147 @@ using namespace ipc::rigid;
 //         CHECK(actual_barrier[i] == Approx(expected_barrier[i]));
 //     }
 // }
+
+namespace {
+
+// Five tilted squares falling onto a floor
+RigidBodyAssembler falling_squares(PosesD& poses_t0, PosesD& poses_t1)
+{
+    Eigen::MatrixXi E(4, 2);
+    E << 0, 1, 1, 2, 2, 3, 3, 0;
+
+    std::vector<RigidBody> rbs;
+    auto add_box = [&](double width, double height, const PoseD& pose) {
+        Eigen::MatrixXd V(4, 2);
+        V << -width, -height, width, -height, width, height, -width, height;
+        rbs.emplace_back(
+            V / 2, E, pose, /*velocity=*/PoseD::Zero(2),
+            /*force=*/PoseD::Zero(2), /*density=*/1.0,
+            /*is_dof_fixed=*/VectorMax6b::Zero(3), /*oriented=*/false,
+            /*group_id=*/int(rbs.size()));
+    };
+
+    add_box(10, 0.2, PoseD(0, -0.1, 0));
+    for (int i = 0; i < 5; i++) {
+        add_box(0.5, 0.5, PoseD(-3 + 1.5 * i, 0.4 + 0.05 * i, 0.1 * i));
+    }
+
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    poses_t0 = bodies.rb_poses_t1();
+    poses_t1 = poses_t0;
+    for (size_t i = 1; i < poses_t1.size(); i++) {
+        poses_t1[i].position.y() -= 0.6;
+        poses_t1[i].rotation(0) += 0.3;
+    }
+    return bodies;
+}
+
+DistanceBarrierConstraint rigid_distance_barrier(double dhat)
+{
+    DistanceBarrierConstraint constraint;
+    constraint.detection_method = DetectionMethod::BVH;
+    constraint.trajectory_type = TrajectoryType::RIGID;
+    constraint.initial_barrier_activation_distance = dhat;
+    constraint.initialize();
+    return constraint;
+}
+
+std::vector<std::vector<long>> sorted_vertex_ids(
+    const RigidBodyAssembler& bodies, const Constraints& constraint_set)
+{
+    std::vector<std::vector<long>> ids;
+    for (size_t ci = 0; ci < constraint_set.size(); ci++) {
+        const auto vertex_ids =
+            constraint_set[ci].vertex_indices(bodies.m_edges, bodies.m_faces);
+        ids.emplace_back(vertex_ids.begin(), vertex_ids.end());
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+} // namespace
+
+TEST_CASE(
+    "Cached CCD candidates give the same constraint sets",
+    "[opt][ccd][DistanceBarrier][DistanceBarrierConstraint]")
+{
+    PosesD poses_t0, poses_t1;
+    const RigidBodyAssembler bodies = falling_squares(poses_t0, poses_t1);
+    const double dhat = 0.05;
+
+    DistanceBarrierConstraint constraint = rigid_distance_barrier(dhat);
+    const double toi =
+        constraint.compute_earliest_toi(bodies, poses_t0, poses_t1);
+    REQUIRE(toi > 0);
+    REQUIRE(toi < 1);
+    // The second query reuses the cached candidates
+    CHECK(constraint.compute_earliest_toi(bodies, poses_t0, poses_t1) == toi);
+
+    // Poses of a line search along the CCD trajectory
+    const Eigen::VectorXd x0 = PoseD::poses_to_dofs(poses_t0);
+    const Eigen::VectorXd dx = PoseD::poses_to_dofs(poses_t1) - x0;
+    for (const double alpha : { 0.0, 0.25, 0.5, 0.9, 0.99 }) {
+        CAPTURE(alpha);
+        const PosesD poses =
+            PoseD::dofs_to_poses(x0 + alpha * toi * dx, bodies.dim());
+
+        Constraints cached_constraint_set;
+        constraint.construct_constraint_set(
+            bodies, poses, cached_constraint_set);
+
+        Constraints expected_constraint_set;
+        rigid_distance_barrier(dhat).construct_constraint_set(
+            bodies, poses, expected_constraint_set);
+
+        CHECK(
+            sorted_vertex_ids(bodies, cached_constraint_set)
+            == sorted_vertex_ids(bodies, expected_constraint_set));
+        if (alpha == 0.99) {
+            CHECK(expected_constraint_set.size() > 0);
+        }
+    }
+}
+
+TEST_CASE(
+    "Earliest TOI does not depend on the thread count",
+    "[opt][ccd][DistanceBarrier][DistanceBarrierConstraint]")
+{
+    PosesD poses_t0, poses_t1;
+    const RigidBodyAssembler bodies = falling_squares(poses_t0, poses_t1);
+    const TrajectoryType trajectory =
+        GENERATE(TrajectoryType::RIGID, TrajectoryType::PIECEWISE_LINEAR);
+
+    // Serial reference without culling or a shared earliest TOI
+    Candidates candidates;
+    detect_collision_candidates(
+        bodies, poses_t0, poses_t1, CollisionType::EDGE_VERTEX, candidates,
+        DetectionMethod::BRUTE_FORCE, trajectory);
+    double expected_toi = std::numeric_limits<double>::infinity();
+    for (const auto& ev_candidate : candidates.ev_candidates) {
+        double toi;
+        if (edge_vertex_ccd(
+                bodies, poses_t0, poses_t1, ev_candidate, toi, trajectory)) {
+            expected_toi = std::min(expected_toi, toi);
+        }
+    }
+    REQUIRE(expected_toi < 1);
+
+    DistanceBarrierConstraint constraint = rigid_distance_barrier(0.05);
+    constraint.trajectory_type = trajectory;
+    CHECK(
+        constraint.compute_earliest_toi(bodies, poses_t0, poses_t1)
+        == Approx(expected_toi).margin(Constants::RIGID_CCD_TOI_TOL));
+
+    DistanceBarrierConstraint serial_constraint = rigid_distance_barrier(0.05);
+    serial_constraint.trajectory_type = trajectory;
+    double serial_toi;
+    tbb::task_arena(1).execute([&] {
+        serial_toi = serial_constraint.compute_earliest_toi(
+            bodies, poses_t0, poses_t1);
+    });
+    CHECK(
+        serial_toi
+        == Approx(expected_toi).margin(Constants::RIGID_CCD_TOI_TOL));
+}
@@ -0,0 +1,259 @@
+#include <catch2/catch.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <SimState.hpp>
+#include <problems/distance_barrier_rb_problem.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+// Two static floors far apart, each with a square resting on it. The squares
+// have different densities, so the average mass of each stack differs from
+// the average mass of the whole scene.
+nlohmann::json two_stacks_scene()
+{
+    nlohmann::json box = R"({
+        "vertices": [[-0.5, -0.5], [0.5, -0.5], [0.5, 0.5], [-0.5, 0.5]],
+        "edges": [[0, 1], [1, 2], [2, 3], [3, 0]]
+    })"_json;
+
+    nlohmann::json scene = R"({
+        "scene_type": "distance_barrier_rb_problem",
+        "solver": "ipc_solver",
+        "timestep": 0.01,
+        "rigid_body_problem": {
+            "gravity": [0, -9.81, 0],
+            "rigid_bodies": []
+        },
+        "newton_solver": {
+            "velocity_conv_tol": 1e-8,
+            "is_velocity_conv_tol_abs": true
+        },
+        "distance_barrier_constraint": {
+            "initial_barrier_activation_distance": 1e-3
+        }
+    })"_json;
+
+    auto& rbs = scene["rigid_body_problem"]["rigid_bodies"];
+    for (double x : { -3.0, 3.0 }) {
+        nlohmann::json floor = box;
+        floor["position"] = { x, -0.5 };
+        floor["scale"] = { 2.0, 1.0 };
+        floor["type"] = "static";
+        rbs.push_back(floor);
+
+        nlohmann::json square = box;
+        square["position"] = { x, 0.5 + 5e-4 };
+        square["density"] = x < 0 ? 1.0 : 10.0;
+        rbs.push_back(square);
+    }
+    return scene;
+}
+
+// A static floor and a stack of squares resting on it
+nlohmann::json stack_scene(int num_squares)
+{
+    nlohmann::json scene = two_stacks_scene();
+    auto& rbs = scene["rigid_body_problem"]["rigid_bodies"];
+    rbs.erase(rbs.begin() + 2, rbs.end());
+    for (int i = 1; i < num_squares; i++) {
+        nlohmann::json square = rbs[1];
+        square["position"][1] = 0.5 + i * (1 + 5e-4) + 5e-4;
+        rbs.push_back(square);
+    }
+    scene["body_sleeping"]["steps"] = 5;
+    return scene;
+}
+
+bool is_body_sleeping(const SimState& sim, size_t body_id)
+{
+    const nlohmann::json state = sim.problem_ptr->state();
+    return state["rigid_bodies"][body_id]["is_sleeping"].get<bool>();
+}
+
+} // namespace
+
+TEST_CASE(
+    "Contact islands match solving all bodies together",
+    "[RB][RB-Problem][contact_islands]")
+{
+    nlohmann::json scene = two_stacks_scene();
+
+    SimState monolithic;
+    REQUIRE(monolithic.init(scene));
+
+    scene["rigid_body_problem"]["solve_contact_islands"] = true;
+    SimState islands;
+    REQUIRE(islands.init(scene));
+
+    for (int i = 0; i < 10; i++) {
+        monolithic.simulation_step();
+        islands.simulation_step();
+        CAPTURE(i);
+        CHECK(!islands.m_step_has_intersections);
+        CHECK(
+            (islands.problem_ptr->vertices()
+             - monolithic.problem_ptr->vertices())
+                .lpNorm<Eigen::Infinity>()
+            == Approx(0).margin(1e-6));
+    }
+}
+
+TEST_CASE("Resting stacks fall asleep", "[RB][RB-Problem][sleeping]")
+{
+    const nlohmann::json scene = stack_scene(/*num_squares=*/2);
+    SimState sim;
+    REQUIRE(sim.init(scene));
+
+    for (int i = 0; i < 100; i++) {
+        sim.simulation_step();
+        CHECK(!sim.m_step_has_intersections);
+    }
+    CHECK(is_body_sleeping(sim, 1));
+    CHECK(is_body_sleeping(sim, 2));
+
+    // The sleep state is restored with the rest of the state
+    SimState resumed;
+    REQUIRE(resumed.init(scene));
+    CHECK(!is_body_sleeping(resumed, 1));
+    resumed.problem_ptr->state(sim.problem_ptr->state());
+    CHECK(is_body_sleeping(resumed, 1));
+    CHECK(is_body_sleeping(resumed, 2));
+}
+
+TEST_CASE("Falling bodies do not fall asleep", "[RB][RB-Problem][sleeping]")
+{
+    nlohmann::json scene = stack_scene(/*num_squares=*/1);
+    auto& rbs = scene["rigid_body_problem"]["rigid_bodies"];
+    rbs.erase(rbs.begin()); // Remove the floor
+    // Weak enough gravity to stay below the sleeping speed for many steps
+    scene["rigid_body_problem"]["gravity"] = { 0, -0.1, 0 };
+
+    SimState sim;
+    REQUIRE(sim.init(scene));
+
+    double prev_y = sim.problem_ptr->vertices().col(1).maxCoeff();
+    for (int i = 0; i < 20; i++) {
+        sim.simulation_step();
+        CAPTURE(i);
+        CHECK(!is_body_sleeping(sim, 0));
+        const double y = sim.problem_ptr->vertices().col(1).maxCoeff();
+        CHECK(y < prev_y);
+        prev_y = y;
+    }
+}
+
+TEST_CASE(
+    "Kinematic bodies follow their poses with adaptive time-steps",
+    "[RB][RB-Problem][kinematic][time_stepper]")
+{
+    nlohmann::json scene = stack_scene(/*num_squares=*/1);
+    auto& rbs = scene["rigid_body_problem"]["rigid_bodies"];
+    rbs.erase(rbs.begin()); // Remove the floor
+    scene["rigid_body_problem"]["gravity"] = { 0, 0, 0 };
+    scene["body_sleeping"]["steps"] = 0;
+
+    // One scripted pose per frame
+    const int num_frames = 10;
+    rbs[0]["position"] = { 0, 0 };
+    rbs[0]["type"] = "kinematic";
+    rbs[0]["kinematic_poses"] = nlohmann::json::array();
+    for (int i = 1; i <= num_frames; i++) {
+        rbs[0]["kinematic_poses"].push_back({ { "position", { 0.1 * i, 0 } } });
+    }
+
+    // Substeps that do not line up with the frames, either shorter than a
+    // frame or spanning several poses.
+    const double substep = GENERATE(0.004, 0.025);
+    scene["adaptive_timestep"]["enabled"] = true;
+    scene["adaptive_timestep"]["min_timestep"] = substep;
+    scene["adaptive_timestep"]["max_timestep"] = substep;
+
+    SimState sim;
+    REQUIRE(sim.init(scene));
+    for (int i = 1; i <= num_frames; i++) {
+        sim.simulation_step();
+        sim.save_simulation_step();
+        CAPTURE(substep, i);
+        const nlohmann::json& frame = sim.state_sequence.back();
+        CHECK(
+            frame["rigid_bodies"][0]["position"][0].get<double>()
+            == Approx(0.1 * i).margin(1e-6));
+        CHECK(
+            frame["rigid_bodies"][0]["position"][1].get<double>()
+            == Approx(0).margin(1e-6));
+    }
+}
+
+TEST_CASE(
+    "L-BFGS IPC solver matches the Newton IPC solver on contact",
+    "[RB][RB-Problem][lbfgs]")
+{
+    nlohmann::json scene = stack_scene(/*num_squares=*/2);
+    scene["body_sleeping"]["steps"] = 0;
+
+    SimState newton;
+    REQUIRE(newton.init(scene));
+
+    scene["solver"] = "lbfgs_ipc_solver";
+    SimState lbfgs;
+    REQUIRE(lbfgs.init(scene));
+
+    for (int i = 0; i < 10; i++) {
+        newton.simulation_step();
+        lbfgs.simulation_step();
+        CAPTURE(i);
+        CHECK(!lbfgs.m_step_has_intersections);
+        CHECK(lbfgs.problem_ptr->num_contacts() > 0);
+        CHECK(
+            (lbfgs.problem_ptr->vertices() - newton.problem_ptr->vertices())
+                .lpNorm<Eigen::Infinity>()
+            == Approx(0).margin(1e-5));
+    }
+}
+
+TEST_CASE(
+    "Hessian blocks match the assembled objective on contact",
+    "[RB][RB-Problem][matrix_free]")
+{
+    nlohmann::json scene = stack_scene(/*num_squares=*/2);
+    scene["body_sleeping"]["steps"] = 0;
+    scene["rigid_body_problem"]["coefficient_friction"] = 0.5;
+    SimState sim;
+    REQUIRE(sim.init(scene));
+    sim.simulation_step();
+    REQUIRE(sim.problem_ptr->num_contacts() > 0);
+
+    auto problem =
+        std::dynamic_pointer_cast<DistanceBarrierRBProblem>(sim.problem_ptr);
+    REQUIRE(problem != nullptr);
+    const Eigen::VectorXd x =
+        problem->poses_to_dofs(problem->m_assembler.rb_poses_t1());
+
+    Eigen::VectorXd grad_blocks;
+    BlockSparseMatrix hess_blocks;
+    const double fx_blocks =
+        problem->compute_objective_blocks(x, grad_blocks, hess_blocks);
+    // The contacts couple the bodies
+    CHECK(hess_blocks.num_nonzero_blocks() > size_t(problem->num_bodies()));
+
+    CHECK(problem->compute_objective(x) == Approx(fx_blocks));
+
+    Eigen::VectorXd grad;
+    CHECK(problem->compute_objective(x, grad) == Approx(fx_blocks));
+    CHECK((grad - grad_blocks).norm() == Approx(0).margin(1e-10));
+
+    Eigen::SparseMatrix<double> hess;
+    CHECK(problem->compute_objective(x, grad, hess) == Approx(fx_blocks));
+    CHECK((grad - grad_blocks).norm() == Approx(0).margin(1e-10));
+    for (int i = 0; i < 5; i++) {
+        const Eigen::VectorXd v = Eigen::VectorXd::Random(x.size());
+        const Eigen::VectorXd Hv = hess * v;
+        CHECK(
+            (hess_blocks * v - Hv).norm()
+            == Approx(0).margin(1e-10 * std::max(Hv.norm(), 1.0)));
+    }
+}
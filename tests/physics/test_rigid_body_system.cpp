@@ -4,9 +4,11 @@
 
 #include <catch2/catch.hpp>
 
+#include <finitediff.hpp>
 #include <igl/PI.h>
 
 #include <physics/rigid_body_assembler.hpp>
+#include <physics/world_vertices_diff.hpp>
 
 // ---------------------------------------------------
 // Tests
@@ -76,3 +78,70 @@ TEST_CASE("Rigid Body System Transform", "[RB][RB-System][RB-System-transform]")
         assembler.world_vertices(poses) - assembler.world_vertices();
     CHECK((expected - actual).squaredNorm() < 1E-6);
 }
+
+TEST_CASE("World vertices derivatives", "[RB][RB-System][RB-System-diff]")
+{
+    int dim = GENERATE(2, 3);
+    int ndof = Pose<double>::dim_to_ndof(dim);
+
+    Eigen::MatrixXd vertices(4, dim);
+    Eigen::MatrixXi edges(4, 2);
+    if (dim == 2) {
+        vertices << -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, 0.5;
+    } else {
+        vertices << -0.5, -0.5, 0, 0.5, -0.5, 0.1, 0.5, 0.5, 0.2, -0.5, 0.5,
+            -0.3;
+    }
+    edges << 0, 1, 1, 2, 2, 3, 3, 0;
+
+    Pose<double> velocity = Pose<double>::Zero(dim);
+    std::vector<RigidBody> rbs;
+    rbs.push_back(simple_rigid_body(vertices, edges, velocity));
+    rbs.push_back(simple_rigid_body(vertices, edges, velocity));
+    RigidBodyAssembler assembler;
+    assembler.init(rbs);
+
+    Eigen::VectorXd dof = Eigen::VectorXd::Random(2 * ndof);
+    PosesD poses = PoseD::dofs_to_poses(dof, dim);
+
+    WorldVerticesDiff V_diff(
+        assembler, poses, /*compute_jac=*/true, /*compute_hess=*/true);
+    CHECK((V_diff.vertices() - assembler.world_vertices(poses)).norm()
+          < 1e-12);
+
+    // The gradient-only path uses first-order autodiff
+    WorldVerticesDiff V_grad(
+        assembler, poses, /*compute_jac=*/true, /*compute_hess=*/false);
+    CHECK((V_grad.vertices() - V_diff.vertices()).norm() < 1e-12);
+
+    for (long vi = 0; vi < assembler.num_vertices(); vi++) {
+        long body_id = assembler.vertex_id_to_body_id(vi);
+        long local_vi = vi - assembler.m_body_vertex_id[body_id];
+        const RigidBody& body = assembler[body_id];
+        Eigen::VectorXd body_dof = dof.segment(body_id * ndof, ndof);
+
+        auto V = [&](const Eigen::VectorXd& x) -> Eigen::VectorXd {
+            return body.world_vertex(Pose<double>(x), local_vi);
+        };
+        Eigen::MatrixXd fd_jac;
+        fd::finite_jacobian(body_dof, V, fd_jac);
+        Eigen::MatrixXd jac = V_diff.vertex_jacobian(vi);
+        CHECK(fd::compare_jacobian(jac, fd_jac));
+        CHECK((V_grad.vertex_jacobian(vi) - jac).norm() < 1e-12);
+
+        for (int j = 0; j < dim; j++) {
+            auto grad_Vj = [&](const Eigen::VectorXd& x) -> Eigen::VectorXd {
+                Eigen::VectorXd perturbed_dof = dof;
+                perturbed_dof.segment(body_id * ndof, ndof) = x;
+                WorldVerticesDiff diff(
+                    assembler, PoseD::dofs_to_poses(perturbed_dof, dim),
+                    /*compute_jac=*/true, /*compute_hess=*/false);
+                return diff.vertex_jacobian(vi).row(j).transpose();
+            };
+            Eigen::MatrixXd fd_hess;
+            fd::finite_jacobian(body_dof, grad_Vj, fd_hess);
+            Eigen::MatrixXd hess = V_diff.vertex_hessian(vi, j);
+            CHECK(fd::compare_jacobian(hess, fd_hess));
+        }
+    }
+}
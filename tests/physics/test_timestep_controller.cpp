@@ -0,0 +1,76 @@
+#include <catch2/catch.hpp>
+
+#include <time_stepper/timestep_controller.hpp>
+
+using namespace ipc::rigid;
+
+TEST_CASE("Adaptive time-step controller", "[physics][time_stepper]")
+{
+    TimestepController controller;
+    const bool success = controller.settings(
+        R"({
+            "enabled": true,
+            "min_timestep": null,
+            "max_timestep": null,
+            "newton_iteration_budget": 20,
+            "min_ccd_step_size": 0.1,
+            "shrink_factor": 0.5,
+            "growth_factor": 1.25
+        })"_json,
+        0.01);
+    REQUIRE(success);
+    CHECK(controller.min_timestep == Approx(0.01 / 128));
+    CHECK(controller.max_timestep == Approx(0.04));
+
+    SECTION("Shrink over the iteration budget")
+    {
+        CHECK(controller.next_timestep(0.01, 21, 1) == Approx(0.005));
+    }
+    SECTION("Shrink when CCD collapses the step")
+    {
+        CHECK(controller.next_timestep(0.01, 5, 0.01) == Approx(0.005));
+    }
+    SECTION("Keep when the solve is moderately hard")
+    {
+        CHECK(controller.next_timestep(0.01, 15, 1) == Approx(0.01));
+        CHECK(controller.next_timestep(0.01, 5, 0.5) == Approx(0.01));
+    }
+    SECTION("Grow in smooth phases")
+    {
+        CHECK(controller.next_timestep(0.01, 5, 1) == Approx(0.0125));
+    }
+    SECTION("Clamp to the bounds")
+    {
+        CHECK(
+            controller.next_timestep(0.01 / 128, 100, 0)
+            == Approx(0.01 / 128));
+        CHECK(controller.next_timestep(0.04, 1, 1) == Approx(0.04));
+    }
+}
+
+TEST_CASE(
+    "Invalid adaptive time-step settings are rejected",
+    "[physics][time_stepper]")
+{
+    nlohmann::json json = R"({
+        "enabled": true,
+        "min_timestep": null,
+        "max_timestep": null,
+        "newton_iteration_budget": 20,
+        "min_ccd_step_size": 0.1,
+        "shrink_factor": 0.5,
+        "growth_factor": 1.25
+    })"_json;
+
+    SECTION("Minimum above the maximum")
+    {
+        json["min_timestep"] = 0.1;
+        json["max_timestep"] = 0.01;
+    }
+    SECTION("Non-positive minimum") { json["min_timestep"] = 0.0; }
+    SECTION("Shrink factor that grows") { json["shrink_factor"] = 1.5; }
+    SECTION("Growth factor that shrinks") { json["growth_factor"] = 0.5; }
+
+    TimestepController controller;
+    CHECK(!controller.settings(json, 0.01));
+}
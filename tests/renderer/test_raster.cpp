@@ -0,0 +1,194 @@
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <Eigen/LU>
+
+#include <raster.hpp>
+
+using namespace swr;
+
+namespace {
+
+Shaders depth_test_shaders(bool early_depth_test)
+{
+    Shaders shaders;
+    shaders.vertex_shader = [](const VertexAttributes& va,
+                               const UniformAttributes& uniform) {
+        return va;
+    };
+    shaders.fragment_shader = [](const VertexAttributes& va,
+                                 const UniformAttributes& uniform) {
+        FragmentAttributes out(va.color);
+        out.depth = -va.position(2);
+        return out;
+    };
+    shaders.blending_shader = [](const FragmentAttributes& fa,
+                                 FrameBufferAttributes& pixel) {
+        if (fa.depth < pixel.depth) {
+            pixel.color =
+                round(fa.color.array().max(0).min(1) * 255).cast<uint8_t>();
+            pixel.depth = fa.depth;
+        }
+    };
+    shaders.early_depth_test = early_depth_test;
+    return shaders;
+}
+
+// Serial rasterizer testing every pixel of the bounding box of each triangle
+// in order.
+void reference_rasterize_triangles(
+    const Shaders& shaders,
+    const UniformAttributes& uniform,
+    const std::vector<VertexAttributes>& vertices,
+    FrameBuffer& frameBuffer)
+{
+    for (size_t t = 0; t < vertices.size() / 3; t++) {
+        const VertexAttributes v1 =
+            shaders.vertex_shader(vertices[3 * t + 0], uniform);
+        const VertexAttributes v2 =
+            shaders.vertex_shader(vertices[3 * t + 1], uniform);
+        const VertexAttributes v3 =
+            shaders.vertex_shader(vertices[3 * t + 2], uniform);
+
+        Eigen::Matrix<Float, 3, 4> p;
+        p.row(0) = v1.position.array() / v1.position.w();
+        p.row(1) = v2.position.array() / v2.position.w();
+        p.row(2) = v3.position.array() / v3.position.w();
+        p.col(0) = ((p.col(0).array() + 1.0) / 2.0) * frameBuffer.rows();
+        p.col(1) = ((p.col(1).array() + 1.0) / 2.0) * frameBuffer.cols();
+
+        int lx = std::floor(p.col(0).minCoeff());
+        int ly = std::floor(p.col(1).minCoeff());
+        int ux = std::ceil(p.col(0).maxCoeff());
+        int uy = std::ceil(p.col(1).maxCoeff());
+        lx = std::min(std::max(lx, int(0)), int(frameBuffer.rows() - 1));
+        ly = std::min(std::max(ly, int(0)), int(frameBuffer.cols() - 1));
+        ux = std::max(std::min(ux, int(frameBuffer.rows() - 1)), int(0));
+        uy = std::max(std::min(uy, int(frameBuffer.cols() - 1)), int(0));
+
+        Matrix3F A;
+        A.col(0) = p.row(0).head<3>();
+        A.col(1) = p.row(1).head<3>();
+        A.col(2) = p.row(2).head<3>();
+        A.row(2) << 1.0, 1.0, 1.0;
+        const Matrix3F Ai = A.inverse();
+
+        for (int i = lx; i <= ux; i++) {
+            for (int j = ly; j <= uy; j++) {
+                Vector3F pixel(i + 0.5, j + 0.5, 1);
+                Vector3F b = Ai * pixel;
+                if (b.minCoeff() >= 0) {
+                    VertexAttributes va = VertexAttributes::interpolate(
+                        v1, v2, v3, b[0], b[1], b[2]);
+                    if (va.position.z() >= -1 && va.position.z() <= 1) {
+                        shaders.blending_shader(
+                            shaders.fragment_shader(va, uniform),
+                            frameBuffer(i, j));
+                    }
+                }
+            }
+        }
+    }
+}
+
+VertexAttributes random_vertex(std::mt19937& gen)
+{
+    // Vertices outside of [-1, 1] give triangles that are partially or
+    // entirely off-screen and fragments outside of the bi-unit cube.
+    std::uniform_real_distribution<Float> xy(-1.5, 1.5), z(-1.2, 1.2),
+        color(0, 1);
+    VertexAttributes v(xy(gen), xy(gen), z(gen));
+    v.color << color(gen), color(gen), color(gen);
+    return v;
+}
+
+std::vector<VertexAttributes> random_triangles(std::mt19937& gen, int n)
+{
+    // A triangle covering the whole screen at a random depth
+    std::vector<VertexAttributes> vertices;
+    const Float z = std::uniform_real_distribution<Float>(-0.9, 0.9)(gen);
+    for (const Vector2F& xy :
+         { Vector2F(-3, -3), Vector2F(5, -3), Vector2F(-3, 5) }) {
+        vertices.push_back(random_vertex(gen));
+        vertices.back().position.head<3>() << xy, z;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) {
+            vertices.push_back(random_vertex(gen));
+        }
+    }
+
+    // Degenerate triangles: a point, a segment, and collinear vertices
+    const VertexAttributes a = random_vertex(gen), b = random_vertex(gen);
+    VertexAttributes c = a;
+    c.position.head<3>() = (a.position.head<3>() + b.position.head<3>()) / 2;
+    for (const VertexAttributes& v : { a, a, a, a, a, b, a, c, b }) {
+        vertices.push_back(v);
+    }
+
+    // Triangles sharing an edge, whose pixel centers on the edge are covered
+    // by both
+    const VertexAttributes d = random_vertex(gen), e = random_vertex(gen);
+    for (const VertexAttributes& v : { a, b, d, b, a, e }) {
+        vertices.push_back(v);
+    }
+    return vertices;
+}
+
+void check_same_frame_buffer(
+    const FrameBuffer& actual, const FrameBuffer& expected)
+{
+    REQUIRE(actual.rows() == expected.rows());
+    REQUIRE(actual.cols() == expected.cols());
+    int num_differences = 0, num_drawn = 0;
+    for (int i = 0; i < actual.rows(); i++) {
+        for (int j = 0; j < actual.cols(); j++) {
+            num_differences += actual(i, j).color != expected(i, j).color
+                || actual(i, j).depth != expected(i, j).depth;
+            num_drawn += std::isfinite(expected(i, j).depth);
+        }
+    }
+    CHECK(num_drawn > 0);
+    CHECK(num_differences == 0);
+}
+
+} // namespace
+
+TEST_CASE("Tiled rasterizer matches the reference", "[renderer][raster]")
+{
+    std::mt19937 gen(GENERATE(0, 1, 2));
+    const Eigen::Vector2i resolution = GENERATE(
+        Eigen::Vector2i(64, 48), Eigen::Vector2i(37, 21),
+        Eigen::Vector2i(7, 13), Eigen::Vector2i(1, 1));
+    const bool early_depth_test = GENERATE(false, true);
+    const int num_triangles = GENERATE(1, 50);
+    CAPTURE(resolution.transpose(), early_depth_test, num_triangles);
+
+    const Shaders shaders = depth_test_shaders(early_depth_test);
+    const UniformAttributes uniform;
+    const std::vector<VertexAttributes> vertices =
+        random_triangles(gen, num_triangles);
+    const Eigen::Matrix<uint8_t, 4, 1> bg_color(255, 255, 255, 255);
+
+    FrameBuffer expected;
+    clear_frame_buffer(expected, resolution, bg_color);
+    reference_rasterize_triangles(shaders, uniform, vertices, expected);
+
+    FrameBuffer frame_buffer;
+    clear_frame_buffer(frame_buffer, resolution, bg_color);
+    rasterize_triangles(shaders, uniform, vertices, frame_buffer);
+    check_same_frame_buffer(frame_buffer, expected);
+
+    // The tiles of a single triangle lock the pixels and give the same image
+    clear_frame_buffer(frame_buffer, resolution, bg_color);
+    for (size_t i = 0; i < vertices.size(); i += 3) {
+        rasterize_triangle(
+            shaders, uniform, vertices[i], vertices[i + 1], vertices[i + 2],
+            frame_buffer);
+    }
+    check_same_frame_buffer(frame_buffer, expected);
+}
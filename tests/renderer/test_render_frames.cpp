@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <igl_stb_image.h>
+
+#include <render_frames.hpp>
+
+using namespace swr;
+
+TEST_CASE(
+    "Frames keep their order and names when rendered in parallel",
+    "[renderer]")
+{
+    const size_t num_frames = 20;
+    const int max_jobs = GENERATE(2, 4);
+    // A size that is not a multiple of a tile
+    const int width = 13, height = 5;
+
+    const fs::path frames_dir =
+        fs::temp_directory_path() / "test_render_frames";
+    fs::remove_all(frames_dir);
+    fs::create_directories(frames_dir);
+
+    // Each frame is filled with a color that identifies it. The earlier
+    // frames take longer, so they finish out of order.
+    const auto frame_color = [](size_t i) {
+        return Eigen::Matrix<uint8_t, 4, 1>(i, 2 * i, 255 - i, 255);
+    };
+    CHECK(render_frames(
+        num_frames, max_jobs,
+        [&](size_t i, FrameBuffer& frame_buffer) {
+            std::this_thread::sleep_for(
+                std::chrono::milliseconds(num_frames - i));
+            clear_frame_buffer(
+                frame_buffer, Eigen::Vector2i(width, height), frame_color(i));
+        },
+        frames_dir));
+
+    // Names sort in frame order
+    std::vector<std::string> filenames;
+    for (const auto& entry : fs::directory_iterator(frames_dir)) {
+        filenames.push_back(entry.path().string());
+    }
+    std::sort(filenames.begin(), filenames.end());
+    REQUIRE(filenames.size() == num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+        CHECK(filenames[i] == frame_filename(frames_dir, i));
+    }
+    CHECK(
+        fs::path(frame_filename(frames_dir, 7)).filename().string()
+        == "frame000007.png");
+
+    // Each file holds the image of its frame
+    for (size_t i = 0; i < num_frames; i++) {
+        CAPTURE(i);
+        int w, h, comp;
+        uint8_t* image = igl::stbi_load(
+            frame_filename(frames_dir, i).c_str(), &w, &h, &comp, 4);
+        REQUIRE(image != nullptr);
+        CHECK(w == width);
+        CHECK(h == height);
+        bool matches = true;
+        for (int p = 0; p < w * h; p++) {
+            for (int c = 0; c < 4; c++) {
+                matches &= image[4 * p + c] == frame_color(i)[c];
+            }
+        }
+        CHECK(matches);
+        igl::stbi_image_free(image);
+    }
+
+    fs::remove_all(frames_dir);
+}
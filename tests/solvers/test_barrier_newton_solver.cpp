@@ -6,6 +6,7 @@
 #include <autodiff/autodiff_types.hpp>
 #include <barrier/barrier.hpp>
 #include <solvers/homotopy_solver.hpp>
+#include <solvers/ipc_solver.hpp>
 #include <solvers/newton_solver.hpp>
 #include <utils/not_implemented_error.hpp>
 
@@ -173,3 +174,144 @@ TEST_CASE(
         CHECK(fd::compare_jacobian(finite_hessian, Eigen::MatrixXd(hess_fx)));
     }
 }
+
+TEST_CASE(
+    "Warm-started IPC solves converge in fewer iterations",
+    "[opt][barrier][ipc_solver][warm_start]")
+{
+    // f(x) = ∑ (xᵢ - aᵢ)⁴/4 + (xᵢ - aᵢ)²/2 with no active constraints, and a
+    // warm start point at the minimizer.
+    class WarmStartProblem : public virtual BarrierProblem {
+    public:
+        WarmStartProblem(const Eigen::VectorXd& a)
+            : a(a)
+            , is_dof_fixed_(VectorXb::Zero(a.size()))
+        {
+        }
+
+        double compute_energy_term(
+            const Eigen::VectorXd& x,
+            Eigen::VectorXd& grad_Ex,
+            Eigen::SparseMatrix<double>& hess_Ex,
+            bool compute_grad = true,
+            bool compute_hess = true) override
+        {
+            const Eigen::ArrayXd d = x - a;
+            if (compute_grad) {
+                grad_Ex = d.cube() + d;
+            }
+            if (compute_hess) {
+                hess_Ex = SparseDiagonal<double>(
+                    Eigen::VectorXd(3 * d.square() + 1));
+            }
+            return (d.pow(4) / 4 + d.square() / 2).sum();
+        }
+
+        double compute_barrier_term(
+            const Eigen::VectorXd& x,
+            Eigen::VectorXd& grad_Bx,
+            Eigen::SparseMatrix<double>& hess_Bx,
+            int& num_constraints,
+            bool compute_grad = true,
+            bool compute_hess = true) override
+        {
+            num_constraints = 0;
+            if (compute_grad) {
+                grad_Bx = Eigen::VectorXd::Zero(x.size());
+            }
+            if (compute_hess) {
+                hess_Bx.resize(x.size(), x.size());
+            }
+            return 0;
+        }
+
+        Eigen::VectorXd warm_start_point(const Eigen::VectorXd&) override
+        {
+            return a;
+        }
+
+        double barrier_hessian(double) const override { return 0; }
+        double barrier_activation_distance() const override { return 1e-3; }
+        void barrier_activation_distance(const double) override { }
+        double barrier_stiffness() const override { return kappa; }
+        void barrier_stiffness(const double k) override { kappa = k; }
+
+        bool
+        has_collisions(const Eigen::VectorXd&, const Eigen::VectorXd&) override
+        {
+            return false;
+        }
+        double compute_earliest_toi(
+            const Eigen::VectorXd&, const Eigen::VectorXd&) override
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        bool is_ccd_aligned_with_newton_update() override { return true; }
+
+        int num_vars() const override { return a.size(); }
+        const VectorXb& is_dof_fixed() const override { return is_dof_fixed_; }
+
+        double compute_min_distance(const Eigen::VectorXd&) const override
+        {
+            return 1;
+        }
+        Eigen::MatrixXd world_vertices(const Eigen::VectorXd& x) const override
+        {
+            return x;
+        }
+        double world_bbox_diagonal() const override { return 1; }
+        DiagonalMatrixXd mass_matrix() const override
+        {
+            DiagonalMatrixXd I(a.size());
+            I.setIdentity();
+            return I;
+        }
+        double average_mass() const override { return 1; }
+        double timestep() const override { return 1; }
+
+        Eigen::VectorXd a;
+        VectorXb is_dof_fixed_;
+        double kappa = 1;
+    };
+
+    nlohmann::json settings = R"({
+        "max_iterations": 100,
+        "convergence_criteria": "velocity",
+        "energy_conv_tol": 1e-5,
+        "velocity_conv_tol": 1e-8,
+        "is_velocity_conv_tol_abs": true,
+        "line_search_lower_bound": 1e-8,
+        "decompose_linear_solve": false,
+        "matrix_free": false,
+        "max_pcg_iterations": 1000,
+        "linear_solver": { "name": "Eigen::SimplicialLDLT" },
+        "dhat_epsilon": 1e-9,
+        "min_barrier_stiffness_scale": 1e11,
+        "warm_start": false
+    })"_json;
+
+    const Eigen::VectorXd a = Eigen::VectorXd::LinSpaced(10, -2, 2);
+    const Eigen::VectorXd x0 = Eigen::VectorXd::Zero(a.size());
+
+    WarmStartProblem cold_problem(a);
+    IPCSolver cold_solver;
+    cold_solver.settings(settings);
+    cold_solver.set_problem(cold_problem);
+    const OptimizationResults cold = cold_solver.solve(x0);
+    REQUIRE(cold.success);
+
+    // The stiffness of the problem before the first solve is not floored
+    WarmStartProblem warm_problem(a);
+    warm_problem.kappa = 1e30;
+    settings["warm_start"] = true;
+    IPCSolver warm_solver;
+    warm_solver.settings(settings);
+    warm_solver.set_problem(warm_problem);
+    warm_solver.init_solve(x0);
+    CHECK(warm_problem.kappa == Approx(cold_problem.kappa));
+
+    const OptimizationResults warm = warm_solver.solve(x0);
+    REQUIRE(warm.success);
+    CHECK((warm.x - cold.x).lpNorm<Eigen::Infinity>() == Approx(0).margin(1e-6));
+    CHECK(warm.num_iterations < cold.num_iterations);
+}
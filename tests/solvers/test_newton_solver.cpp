@@ -92,6 +92,7 @@ TEST_CASE("Simple tests of Newton's Method", "[opt][newtons_method]")
     AdHocProblem problem(num_vars);
 
     NewtonSolver solver;
+    solver.matrix_free = GENERATE(false, true);
     solver.set_problem(problem);
     solver.init_solve(problem.starting_point());
     OptimizationResults results = solver.solve(problem.starting_point());
@@ -115,6 +116,133 @@ TEST_CASE("Test Newton direction solve", "[opt][newtons_method][newton_dir]")
     CHECK((x + delta_x).squaredNorm() == Approx(0.0));
 }
 
+TEST_CASE(
+    "Test Newton direction solve with a reused pattern",
+    "[opt][newtons_method][newton_dir]")
+{
+    int num_vars = 100;
+    ipc::rigid::NewtonSolver solver;
+    Eigen::SparseMatrix<double> hessian =
+        SparseDiagonal<double>(Eigen::VectorXd::Ones(num_vars));
+    size_t pattern = ipc::rigid::sparsity_pattern_fingerprint(hessian);
+    CHECK(pattern != 0);
+
+    for (int i = 0; i < 3; i++) {
+        // Same pattern with different values
+        Eigen::VectorXd diagonal =
+            Eigen::VectorXd::Random(num_vars).array().abs() + 1;
+        hessian = SparseDiagonal<double>(diagonal);
+        CHECK(ipc::rigid::sparsity_pattern_fingerprint(hessian) == pattern);
+
+        Eigen::VectorXd gradient = Eigen::VectorXd::Random(num_vars);
+        Eigen::VectorXd delta_x;
+        CHECK(solver.compute_direction(gradient, hessian, delta_x));
+        CHECK((hessian * delta_x + gradient).norm() == Approx(0).margin(1e-8));
+    }
+
+    // Different pattern
+    hessian.coeffRef(0, num_vars - 1) = 0.5;
+    hessian.coeffRef(num_vars - 1, 0) = 0.5;
+    hessian.makeCompressed();
+    CHECK(ipc::rigid::sparsity_pattern_fingerprint(hessian) != pattern);
+    Eigen::VectorXd gradient = Eigen::VectorXd::Random(num_vars);
+    Eigen::VectorXd delta_x;
+    CHECK(solver.compute_direction(gradient, hessian, delta_x));
+    CHECK((hessian * delta_x + gradient).norm() == Approx(0).margin(1e-8));
+}
+
+TEST_CASE("Sparsity patterns are compared exactly", "[opt][sparsity_pattern]")
+{
+    int num_vars = 10;
+    Eigen::SparseMatrix<double> A =
+        SparseDiagonal<double>(Eigen::VectorXd::Ones(num_vars));
+    A.coeffRef(0, 1) = 1;
+    A.makeCompressed();
+
+    ipc::rigid::SparsityPattern pattern;
+    CHECK(!pattern.matches(A));
+    pattern.assign(A);
+    CHECK(pattern.matches(A));
+
+    // Same pattern with different values
+    Eigen::SparseMatrix<double> B = 2 * A;
+    B.makeCompressed();
+    CHECK(pattern.matches(B));
+
+    // Same number of nonzeros in a different position
+    Eigen::SparseMatrix<double> C =
+        SparseDiagonal<double>(Eigen::VectorXd::Ones(num_vars));
+    C.coeffRef(1, 0) = 1;
+    C.makeCompressed();
+    CHECK(C.nonZeros() == A.nonZeros());
+    CHECK(!pattern.matches(C));
+
+    // Uncompressed matrices never match
+    B.coeffRef(2, 3) = 1;
+    CHECK(!B.isCompressed());
+    CHECK(!pattern.matches(B));
+
+    pattern.clear();
+    CHECK(!pattern.matches(A));
+}
+
+TEST_CASE(
+    "Test Newton direction solve with decoupled blocks",
+    "[opt][newtons_method][newton_dir]")
+{
+    // Independent 6x6 blocks and one larger coupled block
+    int num_blocks = GENERATE(1, 5, 20);
+    int coupled_size = GENERATE(0, 12);
+    int num_vars = 6 * num_blocks + coupled_size;
+
+    Eigen::MatrixXd dense_hessian = Eigen::MatrixXd::Zero(num_vars, num_vars);
+    for (int i = 0; i < num_blocks; i++) {
+        Eigen::MatrixXd A = Eigen::MatrixXd::Random(6, 6);
+        dense_hessian.block<6, 6>(6 * i, 6 * i) =
+            A.transpose() * A + Eigen::MatrixXd::Identity(6, 6);
+    }
+    if (coupled_size > 0) {
+        Eigen::MatrixXd A = Eigen::MatrixXd::Random(coupled_size, coupled_size);
+        dense_hessian.bottomRightCorner(coupled_size, coupled_size) =
+            A.transpose() * A
+            + Eigen::MatrixXd::Identity(coupled_size, coupled_size);
+    }
+    Eigen::SparseMatrix<double> hessian = dense_hessian.sparseView();
+    Eigen::VectorXd gradient = Eigen::VectorXd::Random(num_vars);
+
+    ipc::rigid::NewtonSolver solver;
+    Eigen::VectorXd decomposed_delta_x, sparse_delta_x;
+    solver.decompose_linear_solve = true;
+    CHECK(solver.compute_direction(gradient, hessian, decomposed_delta_x));
+    solver.decompose_linear_solve = false;
+    CHECK(solver.compute_direction(gradient, hessian, sparse_delta_x));
+
+    CHECK(
+        (hessian * decomposed_delta_x + gradient).norm()
+        == Approx(0).margin(1e-8));
+    CHECK(
+        (decomposed_delta_x - sparse_delta_x).norm()
+        == Approx(0).margin(1e-8));
+}
+
+TEST_CASE(
+    "Test Newton direction solve with a singular decoupled block",
+    "[opt][newtons_method][newton_dir]")
+{
+    int num_vars = 12;
+    Eigen::VectorXd diagonal = Eigen::VectorXd::Ones(num_vars);
+    diagonal(5) = 0; // A zero 1×1 block
+    Eigen::SparseMatrix<double> hessian = SparseDiagonal<double>(diagonal);
+    Eigen::VectorXd gradient = Eigen::VectorXd::Ones(num_vars);
+
+    ipc::rigid::NewtonSolver solver;
+    solver.decompose_linear_solve = true;
+    Eigen::VectorXd delta_x;
+    CHECK(!solver.compute_direction(gradient, hessian, delta_x));
+    // Falls back to gradient descent instead of a zero step
+    CHECK((delta_x + gradient).norm() == Approx(0).margin(1e-12));
+}
+
 TEST_CASE("Test making a matrix SPD", "[opt][make_spd]")
 {
     Eigen::SparseMatrix<double> A =
@@ -126,3 +254,173 @@ TEST_CASE("Test making a matrix SPD", "[opt][make_spd]")
         CHECK(eig_vals(i).real() >= Approx(0.0).margin(1e-12));
     }
 }
+
+namespace {
+
+// f(x) = ½xᵀAx - bᵀx with a badly conditioned tridiagonal A, so a block-Jacobi
+// preconditioned CG needs many iterations.
+class TridiagonalProblem : public virtual OptimizationProblem {
+public:
+    TridiagonalProblem(int num_vars, double shift)
+    {
+        std::vector<Eigen::Triplet<double>> triplets;
+        for (int i = 0; i < num_vars; i++) {
+            triplets.emplace_back(i, i, 2 + shift);
+            if (i + 1 < num_vars) {
+                triplets.emplace_back(i, i + 1, -1);
+                triplets.emplace_back(i + 1, i, -1);
+            }
+        }
+        A.resize(num_vars, num_vars);
+        A.setFromTriplets(triplets.begin(), triplets.end());
+        b = Eigen::VectorXd::Random(num_vars);
+        x0 = Eigen::VectorXd::Zero(num_vars);
+        is_dof_fixed_ = VectorXb::Zero(num_vars);
+    }
+
+    Eigen::VectorXd minimizer() const
+    {
+        return Eigen::MatrixXd(A).ldlt().solve(b);
+    }
+
+    double compute_objective(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad_fx,
+        Eigen::SparseMatrix<double>& hess_fx,
+        bool compute_grad = true,
+        bool compute_hess = true) override
+    {
+        if (compute_grad) {
+            grad_fx = A * x - b;
+        }
+        if (compute_hess) {
+            hess_fx = A;
+        }
+        return 0.5 * x.dot(A * x) - b.dot(x);
+    }
+
+    bool has_collisions(const Eigen::VectorXd&, const Eigen::VectorXd&) override
+    {
+        return false;
+    }
+    double compute_earliest_toi(
+        const Eigen::VectorXd& xi, const Eigen::VectorXd& xj) override
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    bool is_ccd_aligned_with_newton_update() override { return true; }
+
+    const Eigen::VectorXd& starting_point() const { return x0; }
+    int num_vars() const override { return x0.size(); }
+    const VectorXb& is_dof_fixed() const override { return is_dof_fixed_; }
+
+    double compute_min_distance(const Eigen::VectorXd& x) const override
+    {
+        return -1;
+    }
+
+    /// Each DoF is the coordinate of one vertex
+    Eigen::MatrixXd world_vertices(const Eigen::VectorXd& x) const override
+    {
+        return x;
+    }
+
+    double world_bbox_diagonal() const override { return 1; }
+
+    DiagonalMatrixXd mass_matrix() const override
+    {
+        DiagonalMatrixXd I(num_vars());
+        I.setIdentity();
+        return I;
+    }
+    double average_mass() const override { return 1; }
+
+    double timestep() const override { return 1; }
+
+    Eigen::SparseMatrix<double> A;
+    Eigen::VectorXd b, x0;
+    VectorXb is_dof_fixed_;
+};
+
+// Exposes the matrix-free internals of the Newton solver
+class MatrixFreeNewtonSolver : public NewtonSolver {
+public:
+    MatrixFreeNewtonSolver() { matrix_free = true; }
+
+    using NewtonSolver::compute_matrix_free_direction;
+    using NewtonSolver::convergence_criteria;
+    using NewtonSolver::hessian_blocks;
+    using NewtonSolver::is_velocity_conv_tol_abs;
+    using NewtonSolver::m_forcing_term;
+    using NewtonSolver::velocity_conv_tol;
+};
+
+} // namespace
+
+TEST_CASE(
+    "Matrix-free Newton directions use the Eisenstat-Walker forcing term",
+    "[opt][newtons_method][newton_dir][matrix_free]")
+{
+    const int num_vars = 100;
+    TridiagonalProblem problem(num_vars, /*shift=*/1e-3);
+    MatrixFreeNewtonSolver solver;
+    solver.set_problem(problem);
+
+    Eigen::VectorXd gradient;
+    problem.compute_objective_blocks(
+        problem.starting_point(), gradient, solver.hessian_blocks);
+    const Eigen::VectorXi free_dof =
+        Eigen::VectorXi::LinSpaced(num_vars, 0, num_vars - 1);
+
+    const auto relative_residual = [&](const Eigen::VectorXd& g,
+                                       const Eigen::VectorXd& delta_x) {
+        return (problem.A * delta_x + g).norm() / g.norm();
+    };
+
+    // The first solve is loose
+    Eigen::VectorXd delta_x;
+    CHECK(solver.compute_matrix_free_direction(gradient, free_dof, delta_x));
+    CHECK(solver.m_forcing_term == Approx(0.5));
+    CHECK(relative_residual(gradient, delta_x) <= 0.5);
+    CHECK(relative_residual(gradient, delta_x) > 1e-3);
+
+    // The safeguard keeps the forcing term from dropping too quickly
+    gradient *= 0.1;
+    CHECK(solver.compute_matrix_free_direction(gradient, free_dof, delta_x));
+    CHECK(solver.m_forcing_term == Approx(0.9 * 0.5 * 0.5));
+    CHECK(relative_residual(gradient, delta_x) <= solver.m_forcing_term);
+
+    // Without the safeguard the forcing term is γ‖gₖ‖²/‖gₖ₋₁‖²
+    gradient *= 1e-3;
+    CHECK(solver.compute_matrix_free_direction(gradient, free_dof, delta_x));
+    CHECK(solver.m_forcing_term == Approx(0.9 * 1e-6));
+    CHECK(relative_residual(gradient, delta_x) <= 1e-6);
+
+    // Accurate solves do not change the forcing sequence
+    const double forcing_term = solver.m_forcing_term;
+    CHECK(solver.compute_matrix_free_direction(
+        gradient, free_dof, delta_x, /*accurate=*/true));
+    CHECK(solver.m_forcing_term == forcing_term);
+    CHECK(relative_residual(gradient, delta_x) <= 1e-7);
+}
+
+TEST_CASE(
+    "Velocity convergence is confirmed with an accurate direction",
+    "[opt][newtons_method][matrix_free]")
+{
+    TridiagonalProblem problem(/*num_vars=*/100, /*shift=*/1e-3);
+    MatrixFreeNewtonSolver solver;
+    solver.convergence_criteria = ConvergenceCriteria::VELOCITY;
+    solver.velocity_conv_tol = 1e-4;
+    solver.is_velocity_conv_tol_abs = true;
+    solver.set_problem(problem);
+    solver.init_solve(problem.starting_point());
+    OptimizationResults results = solver.solve(problem.starting_point());
+    REQUIRE(results.success);
+
+    // The accurate Newton step from x is x* - x, so its length is at most the
+    // tolerance (an inexact step can be much shorter far from x*).
+    CHECK(
+        (results.x - problem.minimizer()).lpNorm<Eigen::Infinity>()
+        <= 1.01 * solver.velocity_conv_tol);
+}
@@ -0,0 +1,89 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+
+#include <utils/block_sparse_matrix.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Block sparse matrix matches triplets", "[block_sparse_matrix]")
+{
+    std::mt19937 gen(0);
+    const long num_blocks = GENERATE(1, 5, 40);
+    const int block_size = GENERATE(3, 6);
+    std::uniform_int_distribution<long> block_id(0, num_blocks - 1);
+
+    BlockSparseMatrix blocks_a(num_blocks, block_size),
+        blocks_b(num_blocks, block_size);
+    std::vector<Eigen::Triplet<double>> triplets;
+
+    const int num_additions = GENERATE(0, 10, 200);
+    for (int k = 0; k < num_additions; k++) {
+        const long i = block_id(gen), j = block_id(gen);
+        const Eigen::MatrixXd block =
+            Eigen::MatrixXd::Random(block_size, block_size);
+        // Split the additions between two accumulators to test merging
+        (k % 2 ? blocks_a : blocks_b).add_block(i, j, block);
+        for (int r = 0; r < block_size; r++) {
+            for (int c = 0; c < block_size; c++) {
+                triplets.emplace_back(
+                    i * block_size + r, j * block_size + c, block(r, c));
+            }
+        }
+    }
+    blocks_a += blocks_b;
+
+    const long n = num_blocks * block_size;
+    Eigen::SparseMatrix<double> expected(n, n);
+    expected.setFromTriplets(triplets.begin(), triplets.end());
+
+    Eigen::SparseMatrix<double> actual;
+    blocks_a.to_sparse(actual);
+    CHECK(actual.rows() == n);
+    CHECK(actual.cols() == n);
+    // The order of the summation differs from setFromTriplets
+    CHECK(
+        (Eigen::MatrixXd(actual) - Eigen::MatrixXd(expected)).norm()
+        == Approx(0).margin(1e-12));
+
+    SECTION("Reuse the sparsity pattern")
+    {
+        const auto* inner = actual.innerIndexPtr();
+        blocks_a += blocks_a;
+        blocks_a.to_sparse(actual);
+        CHECK(actual.innerIndexPtr() == inner);
+        CHECK(
+            (Eigen::MatrixXd(actual) - 2 * Eigen::MatrixXd(expected)).norm()
+            == Approx(0).margin(1e-12));
+    }
+
+    SECTION("Matrix-vector product")
+    {
+        const Eigen::VectorXd x = Eigen::VectorXd::Random(n);
+        CHECK((blocks_a * x - expected * x).norm() == Approx(0).margin(1e-12));
+    }
+
+    SECTION("Add a sparse matrix")
+    {
+        BlockSparseMatrix blocks(num_blocks, block_size);
+        blocks += expected;
+        blocks *= 2;
+        blocks.to_sparse(actual);
+        CHECK(
+            (Eigen::MatrixXd(actual) - 2 * Eigen::MatrixXd(expected)).norm()
+            == Approx(0).margin(1e-12));
+    }
+
+    SECTION("Different sparsity pattern")
+    {
+        BlockSparseMatrix other(num_blocks, block_size);
+        other.add_block(
+            num_blocks - 1, 0,
+            Eigen::MatrixXd::Identity(block_size, block_size));
+        other.to_sparse(actual);
+        Eigen::MatrixXd other_dense = Eigen::MatrixXd::Zero(n, n);
+        other_dense.bottomLeftCorner(block_size, block_size).setIdentity();
+        CHECK((Eigen::MatrixXd(actual) - other_dense).norm() == 0);
+    }
+}
@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <random>
+
+#include <utils/refit_bvh.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+std::vector<RefitBVH::Box> random_boxes(std::mt19937& gen, size_t n)
+{
+    std::uniform_real_distribution<double> pos(-10, 10), size(0, 1);
+    std::vector<RefitBVH::Box> boxes(n);
+    for (auto& box : boxes) {
+        box[0] = Eigen::Vector3d(pos(gen), pos(gen), pos(gen));
+        box[1] = box[0] + Eigen::Vector3d(size(gen), size(gen), size(gen));
+    }
+    return boxes;
+}
+
+std::vector<unsigned int> brute_force_intersect_box(
+    const std::vector<RefitBVH::Box>& boxes, const RefitBVH::Box& query)
+{
+    std::vector<unsigned int> ids;
+    for (unsigned int i = 0; i < boxes.size(); i++) {
+        if ((boxes[i][0].array() <= query[1].array()).all()
+            && (query[0].array() <= boxes[i][1].array()).all()) {
+            ids.push_back(i);
+        }
+    }
+    return ids;
+}
+} // namespace
+
+TEST_CASE("Refit BVH matches brute force", "[bvh][refit]")
+{
+    std::mt19937 gen(0);
+    size_t n = GENERATE(1, 2, 17, 200);
+
+    std::vector<RefitBVH::Box> boxes = random_boxes(gen, n);
+    RefitBVH bvh;
+    bvh.init(boxes);
+    CHECK(bvh.size() == n);
+
+    std::normal_distribution<double> jitter(0, 0.5);
+    for (int step = 0; step < 5; step++) {
+        for (const auto& query : boxes) {
+            std::vector<unsigned int> ids;
+            bvh.intersect_box(query[0], query[1], ids);
+            std::sort(ids.begin(), ids.end());
+            CHECK(ids == brute_force_intersect_box(boxes, query));
+        }
+
+        std::vector<std::pair<int, int>> expected_pairs;
+        for (size_t i = 0; i < boxes.size(); i++) {
+            for (const unsigned int j :
+                 brute_force_intersect_box(boxes, boxes[i])) {
+                if (i < j) {
+                    expected_pairs.emplace_back(int(i), int(j));
+                }
+            }
+        }
+        std::vector<std::pair<int, int>> pairs;
+        bvh.intersect_self(pairs);
+        CHECK(std::is_sorted(
+            pairs.begin(), pairs.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; }));
+        std::sort(pairs.begin(), pairs.end());
+        CHECK(pairs == expected_pairs);
+
+        // Move the boxes and refit
+        for (auto& box : boxes) {
+            Eigen::Vector3d d(jitter(gen), jitter(gen), jitter(gen));
+            box[0] += d;
+            box[1] += d;
+        }
+        bvh.update(boxes);
+    }
+}
+
+TEST_CASE("Refit BVH rebuilds when quality degrades", "[bvh][refit]")
+{
+    std::mt19937 gen(0);
+    std::vector<RefitBVH::Box> boxes = random_boxes(gen, 100);
+    RefitBVH bvh;
+    bvh.init(boxes);
+
+    // A rigid translation does not change the quality
+    for (auto& box : boxes) {
+        box[0].x() += 5;
+        box[1].x() += 5;
+    }
+    CHECK(!bvh.update(boxes));
+
+    // Shuffling the boxes destroys the spatial coherence of the tree
+    std::shuffle(boxes.begin(), boxes.end(), gen);
+    CHECK(bvh.update(boxes));
+
+    // Changing the number of boxes requires a rebuild
+    boxes.pop_back();
+    CHECK(bvh.update(boxes));
+    CHECK(bvh.size() == boxes.size());
+}
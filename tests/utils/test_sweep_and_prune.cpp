@@ -0,0 +1,83 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <random>
+
+#include <utils/sweep_and_prune.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+std::vector<std::pair<int, int>>
+brute_force_intersect_self(const std::vector<SweepAndPrune::Box>& boxes)
+{
+    auto is_active = [](const SweepAndPrune::Box& box) {
+        return (box[0].array() <= box[1].array()).all();
+    };
+    std::vector<std::pair<int, int>> pairs;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        for (size_t j = i + 1; j < boxes.size(); j++) {
+            if (is_active(boxes[i]) && is_active(boxes[j])
+                && (boxes[i][0].array() <= boxes[j][1].array()).all()
+                && (boxes[j][0].array() <= boxes[i][1].array()).all()) {
+                pairs.emplace_back(int(i), int(j));
+            }
+        }
+    }
+    return pairs;
+}
+} // namespace
+
+TEST_CASE("Sweep and prune matches brute force", "[sap]")
+{
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> pos(-10, 10), size(0, 1);
+    std::normal_distribution<double> jitter(0, 0.1);
+
+    size_t n = GENERATE(0, 1, 2, 17, 300);
+    std::vector<SweepAndPrune::Box> boxes(n);
+    for (auto& box : boxes) {
+        box[0] = Eigen::Vector3d(pos(gen), pos(gen), pos(gen));
+        box[1] = box[0] + Eigen::Vector3d(size(gen), size(gen), size(gen));
+    }
+
+    SweepAndPrune sap;
+    for (int step = 0; step < 5; step++) {
+        // Deactivate a box by making it empty
+        std::vector<SweepAndPrune::Box> step_boxes = boxes;
+        if (n > 0) {
+            std::swap(step_boxes[step % n][0], step_boxes[step % n][1]);
+        }
+
+        sap.update(step_boxes);
+        CHECK(sap.size() == n);
+
+        std::vector<std::pair<int, int>> pairs;
+        sap.intersect_self(pairs);
+        std::sort(pairs.begin(), pairs.end());
+        CHECK(pairs == brute_force_intersect_self(step_boxes));
+
+        for (auto& box : boxes) {
+            Eigen::Vector3d d(jitter(gen), jitter(gen), jitter(gen));
+            box[0] += d;
+            box[1] += d;
+        }
+    }
+}
+
+TEST_CASE("Sweep and prune does no work for static boxes", "[sap]")
+{
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> pos(-10, 10);
+    std::vector<SweepAndPrune::Box> boxes(100);
+    for (auto& box : boxes) {
+        box[0] = Eigen::Vector3d(pos(gen), pos(gen), pos(gen));
+        box[1] = box[0].array() + 1;
+    }
+
+    SweepAndPrune sap;
+    sap.update(boxes);
+    sap.update(boxes);
+    CHECK(sap.num_swaps() == 0);
+}